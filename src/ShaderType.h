@@ -4,7 +4,12 @@
 enum class ShaderType {
     PORTAL = 0,
     PHONG,
-    NORMAL
+    NORMAL,
+    // Depth-only proxies for occlusion queries
+    BOUNDS,
+    // Full screen passes of the dynamic resolution
+    UPSCALE,
+    PORTAL_COMPOSITE
 };
 
 #endif // SHADERTYPE_H
@@ -2,17 +2,40 @@
 #include "vectormath.h"
 #include <QtCore/qtextstream.h>
 
-Camera::Camera() {
-    updateFunctions['W'] = &Camera::moveForward;
-    updateFunctions['S'] = &Camera::moveBackward;
-    updateFunctions['A'] = &Camera::moveLeft;
-    updateFunctions['D'] = &Camera::moveRight;
-    updateFunctions['Z'] = &Camera::hoverUp;
-    updateFunctions['X'] = &Camera::hoverDown;
-    updateFunctions['Q'] = &Camera::rotateLeft;
-    updateFunctions['E'] = &Camera::rotateRight;
-    updateFunctions['R'] = &Camera::rotateUp;
-    updateFunctions['F'] = &Camera::rotateDown;
+Camera::UpdateCameraFunction const Camera::updateFunctions[KeyboardStatus::ACTION_COUNT] = {
+    &Camera::moveForward,
+    &Camera::moveBackward,
+    &Camera::moveLeft,
+    &Camera::moveRight,
+    &Camera::hoverUp,
+    &Camera::hoverDown,
+    &Camera::rotateLeft,
+    &Camera::rotateRight,
+    &Camera::rotateUp,
+    &Camera::rotateDown
+};
+
+Camera::Camera() = default;
+
+void Camera::setPose(Pose const &pose) {
+    x = pose.x;
+    y = pose.y;
+    z = pose.z;
+    pan = pose.pan;
+    tilt = pose.tilt;
+    roll = pose.roll;
+}
+
+Camera::Pose Camera::Pose::interpolate(Pose const &a, Pose const &b, float alpha) {
+    auto lerp = [alpha](float from, float to) { return from + alpha * (to - from); };
+    return {
+        lerp(a.x, b.x),
+        lerp(a.y, b.y),
+        lerp(a.z, b.z),
+        lerp(a.pan, b.pan),
+        lerp(a.tilt, b.tilt),
+        lerp(a.roll, b.roll)
+    };
 }
 
 QMatrix4x4 Camera::getModelTransform() {
@@ -35,18 +58,19 @@ QMatrix4x4 Camera::getProjectionTransform() {
     return transform;
 }
 
-void Camera::update(KeyboardStatus keyboardStatus) {
-    for (auto const &pair : updateFunctions) {
-        int key = pair.first;
-        if (keyboardStatus.isDown(key)) {
-            UpdateCameraFunction update = updateFunctions[key];
-            (*this.*update)();
+void Camera::update(KeyboardStatus::Actions const &actions, float ticks) {
+    if (actions.none() || ticks <= 0) return;
+
+    for (size_t action = 0; action < KeyboardStatus::ACTION_COUNT; ++action) {
+        if (actions.test(action)) {
+            UpdateCameraFunction update = updateFunctions[action];
+            (*this.*update)(ticks);
         }
     }
 }
 
-void Camera::move(QVector3D const &direction) {
-    QVector3D movement = direction * cameraMovementSpeed;
+void Camera::move(QVector3D const &direction, float ticks) {
+    QVector3D movement = direction * cameraMovementSpeed * ticks;
 
     x += movement.x();
     y += movement.y();
@@ -59,63 +83,69 @@ QVector3D Camera::viewVector() {
     return view;
 }
 
-void Camera::moveForward() {
-    move(viewVector());
+void Camera::moveForward(float ticks) {
+    move(viewVector(), ticks);
 }
 
-void Camera::moveBackward() {
-    move(-viewVector());
+void Camera::moveBackward(float ticks) {
+    move(-viewVector(), ticks);
 }
 
-void Camera::moveRight() {
+void Camera::moveRight(float ticks) {
     if (-90 < pan && pan < 90) {
       move(
-          VectorMath::orthogonalVectors(viewVector()).second
+          VectorMath::orthogonalVectors(viewVector()).second,
+          ticks
       );
     } else {
       move(
-          -VectorMath::orthogonalVectors(viewVector()).second
+          -VectorMath::orthogonalVectors(viewVector()).second,
+          ticks
       );
     } 
 }
 
 // TODO there is a bug here when you turn more than 270 degrees.
-void Camera::moveLeft() {
+void Camera::moveLeft(float ticks) {
     if (-90 < pan && pan < 90) {
       move(
-          -VectorMath::orthogonalVectors(viewVector()).second
+          -VectorMath::orthogonalVectors(viewVector()).second,
+          ticks
       );
     } else {
       move(
-          VectorMath::orthogonalVectors(viewVector()).second
+          VectorMath::orthogonalVectors(viewVector()).second,
+          ticks
       );
     } 
 }
 
-void Camera::hoverUp() {
+void Camera::hoverUp(float ticks) {
     move(
-        -VectorMath::orthogonalVectors(viewVector()).first
+        -VectorMath::orthogonalVectors(viewVector()).first,
+        ticks
     );
 }
 
-void Camera::hoverDown() {
+void Camera::hoverDown(float ticks) {
     move(
-        VectorMath::orthogonalVectors(viewVector()).first
+        VectorMath::orthogonalVectors(viewVector()).first,
+        ticks
     );
 }
 
-void Camera::rotateUp() {
-    tilt -= cameraRotationalSpeed;
+void Camera::rotateUp(float ticks) {
+    tilt -= cameraRotationalSpeed * ticks;
 }
 
-void Camera::rotateDown() {
-    tilt += cameraRotationalSpeed;
+void Camera::rotateDown(float ticks) {
+    tilt += cameraRotationalSpeed * ticks;
 }
 
-void Camera::rotateLeft() {
-    pan -= cameraRotationalSpeed;
+void Camera::rotateLeft(float ticks) {
+    pan -= cameraRotationalSpeed * ticks;
 }
 
-void Camera::rotateRight() {
-    pan += cameraRotationalSpeed;
+void Camera::rotateRight(float ticks) {
+    pan += cameraRotationalSpeed * ticks;
 }
@@ -2,7 +2,6 @@
 #define CAMERA_H
 
 #include <QMatrix4x4>
-#include <unordered_map>
 
 #include "keyboardstatus.h"
 
@@ -35,6 +34,27 @@ class Camera
     float cameraRotationalSpeed = 0.5;
 
 public:
+    /*
+     * Everything that defines where the camera is and where it is looking.
+     */
+    struct Pose {
+        float x;
+        float y;
+        float z;
+        float pan;
+        float tilt;
+        float roll;
+
+        // Linear interpolation from a (alpha = 0) to b (alpha = 1)
+        static Pose interpolate(Pose const &a, Pose const &b, float alpha);
+    };
+
+    Pose getPose() const {
+      return {x, y, z, pan, tilt, roll};
+    }
+
+    void setPose(Pose const &pose);
+
     QVector3D getPosition() {
       return {x, y, z};
     }
@@ -42,8 +62,11 @@ public:
     // Gets the unit vector in the direction of the camera perspective
     QVector3D viewVector();
 
-    // Move / rotate the camera based on the keys currently pressed down
-    void update(KeyboardStatus keyboardStatus);
+    /*
+     * Move / rotate the camera based on the actions held down, for a duration
+     * of the given number of ticks (which may be a fraction of one)
+     */
+    void update(KeyboardStatus::Actions const &actions, float ticks);
 
     /*
      * Returns a transformation matrix (in homogeneous coordinates) such that if all objects were
@@ -60,33 +83,34 @@ public:
     Camera();
 
 private:
-    using UpdateCameraFunction = void (Camera::*)();
-    std::unordered_map<int, UpdateCameraFunction> updateFunctions;
+    // Indexed by KeyboardStatus::ACTION
+    using UpdateCameraFunction = void (Camera::*)(float ticks);
+    static UpdateCameraFunction const updateFunctions[KeyboardStatus::ACTION_COUNT];
 
     /*
-     * Move one tick (based on the camera movement speed)
+     * Move for a number of ticks (based on the camera movement speed)
      */
 
     // Performs the actual movement
-    void move(QVector3D const &direction);
+    void move(QVector3D const &direction, float ticks);
 
 
     // Setups direction of movement and calls Camera::move
-    void moveForward();
-    void moveBackward();
-    void moveRight();
-    void moveLeft();
-    void hoverUp();
-    void hoverDown();
+    void moveForward(float ticks);
+    void moveBackward(float ticks);
+    void moveRight(float ticks);
+    void moveLeft(float ticks);
+    void hoverUp(float ticks);
+    void hoverDown(float ticks);
 
     /*
-     * Rotate one tick (based on the camera rotational speed)
+     * Rotate for a number of ticks (based on the camera rotational speed)
      */
 
-    void rotateUp();
-    void rotateDown();
-    void rotateLeft();
-    void rotateRight();
+    void rotateUp(float ticks);
+    void rotateDown(float ticks);
+    void rotateLeft(float ticks);
+    void rotateRight(float ticks);
 };
 
 #endif // CAMERA_H
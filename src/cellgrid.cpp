@@ -0,0 +1,85 @@
+#include "cellgrid.h"
+
+#include <limits>
+
+#include "scenestore.h"
+
+namespace {
+
+// Of a cell, in scene units. Large enough that a pass looks at a few cells in
+// every direction, small enough that a cell is mostly in or out of a view.
+constexpr float CELL_SIZE = 10.0F;
+// Larger scenes get larger cells instead
+constexpr int MAX_CELLS_PER_AXIS = 64;
+
+}
+
+void CellGrid::build(ObjectTable const &objects) {
+    clear();
+    if (objects.size() == 0) return;
+
+    QVector3D low{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                  std::numeric_limits<float>::max()};
+    QVector3D high = -low;
+    for (QVector3D const &position : objects.positions) {
+        for (int axis = 0; axis < 3; ++axis) {
+            low[axis] = std::min(low[axis], position[axis]);
+            high[axis] = std::max(high[axis], position[axis]);
+        }
+    }
+
+    QVector3D extent = high - low;
+    float longest = std::max({extent.x(), extent.y(), extent.z()});
+    origin = low;
+    cellSize = std::max(CELL_SIZE, longest / MAX_CELLS_PER_AXIS);
+    for (int axis = 0; axis < 3; ++axis) {
+        dimensions[axis] = std::min(static_cast<int>(extent[axis] / cellSize) + 1, MAX_CELLS_PER_AXIS);
+    }
+    cellIndices.assign(static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2], -1);
+
+    // The bounds of the positions in every cell, grown one object at a time
+    std::vector<QVector3D> cellLow;
+    std::vector<QVector3D> cellHigh;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        QVector3D const &position = objects.positions[i];
+        size_t gridIndex = (static_cast<size_t>(coordinate(position.z(), 2)) * dimensions[1] +
+                            coordinate(position.y(), 1)) * dimensions[0] + coordinate(position.x(), 0);
+        if (cellIndices[gridIndex] < 0) {
+            cellIndices[gridIndex] = static_cast<int32_t>(cells.size());
+            cells.emplace_back();
+            cellLow.push_back(position);
+            cellHigh.push_back(position);
+        }
+
+        int32_t index = cellIndices[gridIndex];
+        Cell &cell = cells[index];
+        cell.objects.push_back(static_cast<uint32_t>(i));
+        for (int axis = 0; axis < 3; ++axis) {
+            cellLow[index][axis] = std::min(cellLow[index][axis], position[axis]);
+            cellHigh[index][axis] = std::max(cellHigh[index][axis], position[axis]);
+        }
+
+        RenderHandle const &rh = objects.renderHandles[i];
+        cell.modelRadius = std::max(cell.modelRadius, rh.boundsCenter.length() + rh.boundsRadius);
+        maxModelRadius = std::max(maxModelRadius, cell.modelRadius);
+    }
+
+    for (size_t index = 0; index < cells.size(); ++index) {
+        cells[index].center = (cellLow[index] + cellHigh[index]) / 2;
+        cells[index].radius = (cellHigh[index] - cellLow[index]).length() / 2;
+    }
+}
+
+void CellGrid::clear() {
+    origin = QVector3D{};
+    cellSize = 0;
+    std::fill(std::begin(dimensions), std::end(dimensions), 0);
+    cellIndices.clear();
+    cells.clear();
+    maxModelRadius = 0;
+}
+
+int CellGrid::coordinate(float position, int axis) const {
+    int cell = static_cast<int>(std::floor((position - origin[axis]) / cellSize));
+    return std::clamp(cell, 0, dimensions[axis] - 1);
+}
@@ -0,0 +1,121 @@
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <QVector3D>
+
+#include "multiview.h"
+#include "worldeffect.h"
+
+struct ObjectTable;
+
+/*
+ * The objects of a table bucketed into a uniform grid of cells, built once
+ * when the table is loaded, as its objects do not move. A pass only looks at
+ * the cells its views can reach, and only at the objects of the cells whose
+ * bounds intersect a view.
+ *
+ * The scenes have no geometry that occludes whole cells, so the potentially
+ * visible set of a cell is every cell within viewing distance of it. That set
+ * is a box of cells around the eye, which is read from the grid directly
+ * rather than stored per cell.
+ *
+ * Assumes the modelview transform of every object is a translation to its
+ * position, plus the camera's.
+ */
+class CellGrid
+{
+public:
+    // Buckets the objects at their current positions, with their current bounds
+    void build(ObjectTable const &objects);
+    // Until the next build, for when the objects change
+    void clear();
+
+    // Whether there is no grid, in which case every object has to be visited
+    bool isEmpty() const { return cells.empty(); }
+
+    /*
+     * Calls visit with the index of every object in a cell that may be
+     * visible in the views, drawn under the effect, as it is at the time of
+     * the frame. cameraOffset is the translation of the camera, from the
+     * positions of the objects to the space of the views. Returns the number
+     * of objects visited.
+     */
+    template <typename Visit>
+    size_t forEachVisible(QVector3D const &cameraOffset, WorldEffect const &effect,
+                          MultiView const &views, Visit &&visit) const;
+
+private:
+    struct Cell
+    {
+        // Around the positions of the objects
+        QVector3D center;
+        float radius = 0;
+        // Around the bounds of any of the objects, in their model space
+        float modelRadius = 0;
+        std::vector<uint32_t> objects;
+    };
+
+    // Where a position is in the grid, clamped to it
+    int coordinate(float position, int axis) const;
+
+    QVector3D origin;
+    float cellSize = 0;
+    int dimensions[3] = {0, 0, 0};
+    // Into cells for every position in the grid, -1 where it is empty
+    std::vector<int32_t> cellIndices;
+    // Only the cells with objects
+    std::vector<Cell> cells;
+    float maxModelRadius = 0;
+};
+
+template <typename Visit>
+size_t CellGrid::forEachVisible(QVector3D const &cameraOffset, WorldEffect const &effect,
+                                MultiView const &views, Visit &&visit) const {
+    // The effect moves and grows the bounds of every object at most this much
+    QVector3D effectOffset;
+    float effectRadius = maxModelRadius;
+    effect.mapBounds(effectOffset, effectRadius);
+
+    // The cells any of the eyes sees into, in the space of the positions
+    float reach = views.getReach() + effectRadius;
+    int from[3] = {dimensions[0], dimensions[1], dimensions[2]};
+    int to[3] = {-1, -1, -1};
+    for (int view = 0; view < views.count(); ++view) {
+        QVector3D eye = views.getEyes()[view] - cameraOffset - effectOffset;
+        for (int axis = 0; axis < 3; ++axis) {
+            from[axis] = std::min(from[axis], coordinate(eye[axis] - reach, axis));
+            to[axis] = std::max(to[axis], coordinate(eye[axis] + reach, axis));
+        }
+    }
+
+    size_t visited = 0;
+    for (int z = from[2]; z <= to[2]; ++z) {
+        for (int y = from[1]; y <= to[1]; ++y) {
+            for (int x = from[0]; x <= to[0]; ++x) {
+                int32_t index = cellIndices[(static_cast<size_t>(z) * dimensions[1] + y) * dimensions[0] + x];
+                if (index < 0) continue;
+
+                Cell const &cell = cells[index];
+                QVector3D center;
+                float radius = cell.modelRadius;
+                effect.mapBounds(center, radius);
+                if (!views.intersectsSphere(cell.center + cameraOffset + center, cell.radius + radius)) {
+                    continue;
+                }
+
+                for (uint32_t object : cell.objects) {
+                    visit(static_cast<size_t>(object));
+                }
+                visited += cell.objects.size();
+            }
+        }
+    }
+    return visited;
+}
+
+#endif // CELLGRID_H
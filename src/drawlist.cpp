@@ -0,0 +1,214 @@
+#include "drawlist.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "vectormath.h"
+
+void ObjectUniforms::write(void *to, QMatrix4x4 const &modelViewTransform,
+                           QVector3D const &positionOffset, QVector3D const &positionScale,
+                           GLint materialLayer) {
+    // Assembled here and copied in one go, the stream buffer may be write-combined memory
+    ObjectUniforms uniforms;
+    std::memcpy(uniforms.modelViewTransform, modelViewTransform.constData(), sizeof(uniforms.modelViewTransform));
+
+    QMatrix3x3 normalMatrix = modelViewTransform.normalMatrix();
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            uniforms.normalMatrix[4 * column + row] = normalMatrix(row, column);
+        }
+        uniforms.normalMatrix[4 * column + 3] = 0;
+    }
+
+    for (int axis = 0; axis < 3; ++axis) {
+        uniforms.positionOffset[axis] = positionOffset[axis];
+        uniforms.positionScale[axis] = positionScale[axis];
+    }
+    uniforms.padding = 0;
+    uniforms.materialLayer = materialLayer;
+
+    std::memcpy(to, &uniforms, sizeof(uniforms));
+}
+
+void EffectUniforms::write(void *to, WorldEffect const &effect) {
+    EffectUniforms uniforms;
+    std::memcpy(uniforms.transform, effect.transform.constData(), sizeof(uniforms.transform));
+
+    QMatrix3x3 normalMatrix = effect.transform.normalMatrix();
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            uniforms.normalMatrix[4 * column + row] = normalMatrix(row, column);
+        }
+        uniforms.normalMatrix[4 * column + 3] = 0;
+    }
+
+    uniforms.deformation = static_cast<GLint>(effect.deformation);
+    uniforms.strength = effect.strength;
+    uniforms.padding[0] = uniforms.padding[1] = 0;
+
+    std::memcpy(to, &uniforms, sizeof(uniforms));
+}
+
+void DrawList::build(
+    ObjectTable const &objects, WorldEffect const &effect,
+    MultiView const &views, QVector3D const &cameraOffset, ShaderType shaderType,
+    HiZBuffer const &hiZBuffer, int hiZPass,
+    StreamBuffer &uniforms, size_t uniformAlignment
+) {
+    this->shaderType = shaderType;
+    clear();
+
+    if (batchDraws.size() < objects.batches.size()) {
+        batchDraws.resize(objects.batches.size());
+    }
+    for (size_t i = 0; i < objects.batches.size(); ++i) {
+        StaticBatch const &batch = objects.batches[i];
+        batchDraws[i].vao = batch.vao;
+        batchDraws[i].page = batch.page;
+        batchDraws[i].recordsTexture = batch.recordsTexture;
+    }
+
+    auto addObject = [&](size_t i) {
+        RenderHandle const &rh = objects.renderHandles[i];
+        // The world effect is applied by the vertex shader, only its bounds are needed here
+        QMatrix4x4 const &modelViewTransform = objects.modelTransforms[i];
+
+        QVector3D center = rh.boundsCenter;
+        float radius = rh.boundsRadius;
+        effect.mapBounds(center, radius);
+        center = modelViewTransform.map(center);
+        radius *= VectorMath::maxScale(modelViewTransform);
+        if (!views.intersectsSphere(center, radius)) {
+            ++culled;
+            return;
+        }
+
+        // The Hi-Z buffer is only built for a single view
+        bool occluded = hiZBuffer.isOccluded(hiZPass, views.getProjections()[0], center, radius);
+
+        // Batched objects need no uniforms of their own, unless they are drawn on their own
+        if (rh.batch >= 0 && !occluded) {
+            BatchDraw &batchDraw = batchDraws[rh.batch];
+            if (!addVisibleRanges(rh, modelViewTransform, effect, views, batchDraw.rangeCounts,
+                                  batchDraw.rangeOffsets, 0)) {
+                ++culled;
+            }
+            return;
+        }
+
+        uint32_t firstRange = static_cast<uint32_t>(rangeCounts.size());
+        if (!addVisibleRanges(rh, modelViewTransform, effect, views, rangeCounts, rangeOffsets, firstRange)) {
+            ++culled;
+            return;
+        }
+        uint32_t rangeCount = static_cast<uint32_t>(rangeCounts.size()) - firstRange;
+
+        StreamBuffer::Allocation allocation = uniforms.allocate(sizeof(ObjectUniforms), uniformAlignment);
+        if (allocation.data == nullptr) {
+            // Only if the frame was sized too small, drop the object rather than draw it wrong
+            rangeCounts.resize(firstRange);
+            rangeOffsets.resize(firstRange);
+            ++culled;
+            return;
+        }
+        ObjectUniforms::write(allocation.data, modelViewTransform, rh.positionOffset, rh.positionScale,
+                              rh.material.layer);
+
+        DrawItem item{
+            rh.vao,
+            firstRange,
+            rangeCount,
+            rh.material,
+            allocation.offset,
+            center,
+            radius
+        };
+
+        if (occluded) {
+            occludedItems.push_back(item);
+        } else {
+            items.push_back(item);
+        }
+    };
+
+    if (objects.cells.isEmpty()) {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            addObject(i);
+        }
+    } else {
+        // The objects of the cells out of view are culled without looking at them
+        culled += objects.size() - objects.cells.forEachVisible(cameraOffset, effect, views, addObject);
+    }
+
+    auto byState = [](DrawItem const &a, DrawItem const &b) {
+        if (a.material.page != b.material.page) return a.material.page < b.material.page;
+        return a.vao < b.vao;
+    };
+    std::sort(items.begin(), items.end(), byState);
+    std::sort(occludedItems.begin(), occludedItems.end(), byState);
+}
+
+bool DrawList::addVisibleRanges(RenderHandle const &rh, QMatrix4x4 const &modelViewTransform,
+                                WorldEffect const &effect, MultiView const &views,
+                                std::vector<GLsizei> &counts, std::vector<GLvoid const *> &offsets,
+                                size_t firstMergeable) {
+    auto addRange = [&](GLuint firstIndex, GLuint count) {
+        uintptr_t offset = firstIndex * sizeof(GLuint);
+        if (counts.size() > firstMergeable &&
+            reinterpret_cast<uintptr_t>(offsets.back()) + counts.back() * sizeof(GLuint) == offset) {
+            counts.back() += static_cast<GLsizei>(count);
+        } else {
+            counts.push_back(static_cast<GLsizei>(count));
+            offsets.push_back(reinterpret_cast<GLvoid const *>(offset));
+        }
+    };
+
+    if (rh.meshlets == nullptr) {
+        addRange(rh.firstIndex, rh.size);
+        return true;
+    }
+
+    // Without a deformation, the effect folds into one transform for all meshlets
+    bool deformed = effect.deformation != WorldEffect::DEFORMATION::NONE;
+    QMatrix4x4 meshletTransform = deformed ? modelViewTransform : modelViewTransform * effect.transform;
+    // Mirrored, skewed or deformed by the world effect, the normal cones no longer hold
+    bool testCones = !deformed && VectorMath::isSimilarity(meshletTransform);
+    float scale = VectorMath::maxScale(meshletTransform);
+    bool anyVisible = false;
+
+    for (auto const &meshlet : *rh.meshlets) {
+        QVector3D center = meshlet.center;
+        float radius = meshlet.radius;
+        if (deformed) {
+            effect.mapBounds(center, radius);
+        }
+        center = meshletTransform.map(center);
+        radius *= scale;
+        if (!views.intersectsSphere(center, radius) ||
+            (testCones && views.isBackfacing(center, radius,
+                                             meshletTransform.mapVector(meshlet.coneAxis).normalized(),
+                                             meshlet.coneCutoff))) {
+            ++culledMeshlets;
+            continue;
+        }
+
+        addRange(rh.firstIndex + meshlet.firstIndex, meshlet.count);
+        anyVisible = true;
+    }
+    return anyVisible;
+}
+
+void DrawList::clear() {
+    items.clear();
+    occludedItems.clear();
+    rangeCounts.clear();
+    rangeOffsets.clear();
+    for (auto &batchDraw : batchDraws) {
+        batchDraw.rangeCounts.clear();
+        batchDraw.rangeOffsets.clear();
+    }
+    indirect = false;
+    culled = 0;
+    culledMeshlets = 0;
+}
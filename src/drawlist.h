@@ -0,0 +1,164 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <GL/gl.h>
+
+#include <vector>
+
+#include <QMatrix4x4>
+
+#include "hizbuffer.h"
+#include "multiview.h"
+#include "scenestore.h"
+#include "streambuffer.h"
+#include "worldeffect.h"
+#include "ShaderType.h"
+
+/*
+ * The per-object uniform block of the GL 3.3 shaders, in std140 layout. It is
+ * written to a StreamBuffer and bound per draw.
+ */
+struct ObjectUniforms
+{
+    static constexpr GLuint BINDING = 0;
+
+    float modelViewTransform[16];
+    // A mat3 takes up three vec4 columns
+    float normalMatrix[12];
+    float positionOffset[3];
+    float padding;
+    float positionScale[3];
+    GLint materialLayer;
+
+    static void write(void *to, QMatrix4x4 const &modelViewTransform,
+                      QVector3D const &positionOffset, QVector3D const &positionScale,
+                      GLint materialLayer = 0);
+};
+
+static_assert(sizeof(ObjectUniforms) == 144, "ObjectUniforms should match the std140 layout");
+
+/*
+ * The world effect of a pass, as the WorldEffect uniform block of
+ * shaders/worldeffect.glsl takes it, in std140 layout. Written to the stream
+ * buffer once per pass, with the animation resolved.
+ */
+struct EffectUniforms
+{
+    static constexpr GLuint BINDING = 1;
+
+    float transform[16];
+    // A mat3 takes up three vec4 columns
+    float normalMatrix[12];
+    GLint deformation;
+    float strength;
+    float padding[2];
+
+    static void write(void *to, WorldEffect const &effect);
+};
+
+static_assert(sizeof(EffectUniforms) == 128, "EffectUniforms should match the std140 layout");
+
+/*
+ * Everything needed to issue a single draw, with its uniforms already written.
+ * Only the visible meshlets are drawn, as ranges of the index buffer.
+ */
+struct DrawItem
+{
+    GLuint vao;
+    // The ranges of the item in DrawList::rangeCounts / rangeOffsets
+    uint32_t firstRange;
+    uint32_t rangeCount;
+    Material material;
+    // Where the ObjectUniforms of the draw are in the stream buffer
+    GLintptr uniformsOffset;
+
+    // Bounding sphere after the modelview transform, to draw an occlusion proxy
+    QVector3D boundsCenter;
+    float boundsRadius;
+};
+
+/*
+ * The visible objects of a StaticBatch, drawn with one glMultiDrawElements.
+ */
+struct BatchDraw
+{
+    GLuint vao = 0;
+    GLuint page = 0;
+    GLuint recordsTexture = 0;
+
+    // Merged across objects where they are adjacent in the batch
+    std::vector<GLsizei> rangeCounts;
+    std::vector<GLvoid const *> rangeOffsets;
+};
+
+/*
+ * The draws of one render pass (the scene, or the world behind one portal).
+ * Building it touches no GL state, so the lists of all passes can be built in
+ * parallel and only be submitted on the GL thread.
+ */
+struct DrawList
+{
+    ShaderType shaderType = ShaderType::PHONG;
+    std::vector<DrawItem> items;
+
+    // Where the EffectUniforms of the pass are in the stream buffer
+    GLintptr effectUniformsOffset = 0;
+
+    // Set when the pass is culled and drawn by IndirectDraws instead, in
+    // which case the items stay empty
+    bool indirect = false;
+
+    // Objects the Hi-Z buffer hid last frame. They are only drawn if their
+    // bounds pass an occlusion query against the depth of this frame.
+    std::vector<DrawItem> occludedItems;
+
+    // The visible objects of the static batches, in the order of
+    // ObjectTable::batches. Ones past the batches of the objects are empty.
+    std::vector<BatchDraw> batchDraws;
+
+    // The index ranges of all items, as taken by glMultiDrawElements. Adjacent
+    // visible meshlets are merged into one range.
+    std::vector<GLsizei> rangeCounts;
+    std::vector<GLvoid const *> rangeOffsets;
+
+    // Number of objects the last build rejected as outside the frusta or
+    // facing away, and of meshlets of the objects it kept
+    size_t culled = 0;
+    size_t culledMeshlets = 0;
+
+    /*
+     * Fills the list with the objects visible in any of the views, drawn
+     * under the world effect, as it is at the time of the frame. If the table
+     * has a CellGrid, only the objects of its cells that may be visible are
+     * looked at, cameraOffset being the camera's translation.
+     *
+     * The meshlets of the objects are culled against the frusta and, where
+     * the effect keeps angles, on their normal cones from all eyes. Objects
+     * hidden in hiZPass of the Hi-Z buffer go to occludedItems, and visible
+     * objects of a static batch to its batchDraws. The items are sorted on
+     * material page and mesh, so drawing them binds each only once.
+     *
+     * The uniforms of every item are written to the stream buffer, which may
+     * be done from several threads at once. Reuses the storage of the
+     * previous build.
+     */
+    void build(ObjectTable const &objects, WorldEffect const &effect,
+               MultiView const &views, QVector3D const &cameraOffset, ShaderType shaderType,
+               HiZBuffer const &hiZBuffer, int hiZPass,
+               StreamBuffer &uniforms, size_t uniformAlignment);
+
+    void clear();
+
+private:
+    /*
+     * Appends the index ranges of the meshlets of the mesh that may be
+     * visible, merging them into the ranges from firstMergeable on where they
+     * are adjacent. Returns whether any were.
+     */
+    bool addVisibleRanges(RenderHandle const &rh, QMatrix4x4 const &modelViewTransform,
+                          WorldEffect const &effect, MultiView const &views,
+                          std::vector<GLsizei> &counts, std::vector<GLvoid const *> &offsets,
+                          size_t firstMergeable);
+};
+
+#endif // DRAWLIST_H
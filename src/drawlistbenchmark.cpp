@@ -0,0 +1,167 @@
+#include "drawlistbenchmark.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include "camera.h"
+#include "framearena.h"
+#include "model.h"
+#include "renderprofile.h"
+#include "vectormath.h"
+#include "world.h"
+
+namespace {
+
+// As MainView renders the frame, at a common window shape
+constexpr float FIELD_OF_VIEW = 60.0F;
+constexpr float NEAR_PLANE = 0.2F;
+constexpr float FAR_PLANE = 40.0F;
+constexpr float ASPECT_RATIO = 16.0F / 9.0F;
+
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT of most desktop drivers
+constexpr size_t UNIFORM_ALIGNMENT = 256;
+
+RenderHandle prepareMesh(QString const &fileName) {
+    Model model(fileName, Model::LAYOUT::INDEXED);
+    return PreparedMesh::prepare({fileName, model.takeCoords(), model.takeNormals(), model.takeTextureCoords(),
+                                  model.takeIndices()}).handle;
+}
+
+}
+
+DrawListBenchmark::DrawListBenchmark(Scene &scene, unsigned threadCount) : scene(scene), jobSystem(threadCount) {
+    RenderHandle objectMesh = prepareMesh(scene.objectMesh);
+    for (auto &rh : scene.texturedObjects.renderHandles) {
+        rh = objectMesh;
+    }
+    scene.texturedObjects.cells.build(scene.texturedObjects);
+
+    RenderHandle portalMesh = prepareMesh(scene.portalMesh);
+    for (auto &rh : scene.portalObjects.renderHandles) {
+        rh = portalMesh;
+    }
+
+    worlds.resize(scene.worlds.size());
+    for (size_t worldId = 0; worldId < scene.worlds.size(); ++worldId) {
+        WorldData data = WorldData::load(static_cast<int>(worldId), scene.worlds[worldId]);
+        ObjectTable &objects = worlds[worldId];
+        objects.reserve(data.objects.size());
+        for (auto const &object : data.objects) {
+            objects.add(object.position);
+            objects.renderHandles.back() = data.meshes[object.meshIndex].handle;
+        }
+        objects.cells.build(objects);
+    }
+
+    uniforms.initializeInMemory();
+    // Without GL, so only the CPU side of the zones is timed
+    profiler.initialize(nullptr);
+    profiler.setEnabled(RenderSettings::current().profiler);
+}
+
+DrawListBenchmark::~DrawListBenchmark() {
+    uniforms.destroy();
+}
+
+ObjectTable *DrawListBenchmark::getWorldObjects(int worldId) {
+    if (worldId < 0 || static_cast<size_t>(worldId) >= worlds.size()) {
+        return &scene.texturedObjects;
+    }
+    return &worlds[worldId];
+}
+
+double DrawListBenchmark::buildFrame(RenderSnapshot const &snapshot, float effectTime) {
+    PortalTable &portals = scene.portalObjects;
+    portals.collisions = snapshot.portalCollisions;
+
+    Camera camera;
+    camera.setPose(snapshot.camera);
+    QMatrix4x4 cameraTransform = camera.getModelTransform();
+    QVector3D cameraOffset = cameraTransform.column(3).toVector3D();
+    views.update(camera.getProjectionTransform(), FIELD_OF_VIEW, ASPECT_RATIO, NEAR_PLANE, FAR_PLANE);
+
+    // As MainView::updateModelTransforms, for every table a pass may draw
+    auto updateModelTransforms = [&](ObjectTable &objects) {
+        jobSystem.parallelFor(objects.size(), 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                QMatrix4x4 &modelTransform = objects.modelTransforms[i];
+                modelTransform.setToIdentity();
+                modelTransform.translate(objects.positions[i]);
+                modelTransform = modelTransform * cameraTransform;
+            }
+        });
+    };
+    updateModelTransforms(portals);
+    updateModelTransforms(scene.texturedObjects);
+    for (ObjectTable &objects : worlds) {
+        updateModelTransforms(objects);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    profiler.beginFrame();
+    buildDrawLists(snapshot, effectTime, cameraOffset);
+    profiler.endFrame();
+    double milliseconds = timer.nsecsElapsed() / 1e6;
+
+    FrameArena::endFrame();
+    return milliseconds;
+}
+
+void DrawListBenchmark::buildDrawLists(RenderSnapshot const &snapshot, float effectTime,
+                                       QVector3D const &cameraOffset) {
+    Profiler::CpuZone zone{profiler, "buildDrawLists"};
+    PortalTable &portals = scene.portalObjects;
+
+    // The passes as MainView::buildDrawLists sets them up, the scene last
+    struct PassSource {
+        ObjectTable *objects;
+        WorldEffect effect;
+        ShaderType shaderType;
+        MultiView views;
+    };
+    FrameVector<PassSource> sources(portals.size() + 1);
+    for (size_t pass = 0; pass < portals.size(); ++pass) {
+        PortalEffect const &effect = portals.effects[pass];
+        RenderHandle const &rh = portals.renderHandles[pass];
+        QMatrix4x4 const &modelTransform = portals.modelTransforms[pass];
+        sources[pass] = {getWorldObjects(snapshot.inPortal ? -1 : effect.worldId),
+                         snapshot.inPortal ? WorldEffect{} : effect.worldEffect.at(effectTime),
+                         snapshot.inPortal ? ShaderType::PHONG : effect.shaderType,
+                         views.narrowedTo(modelTransform.map(rh.boundsCenter),
+                                          rh.boundsRadius * VectorMath::maxScale(modelTransform))};
+    }
+    sources[portals.size()] = {getWorldObjects(snapshot.currentWorldId),
+                               snapshot.currentWorldEffect.at(effectTime), snapshot.currentShaderType, views};
+
+    size_t uniformsCount = sources.size();
+    for (PassSource const &source : sources) {
+        uniformsCount += source.objects->size();
+    }
+    uniforms.beginFrame(uniformsCount * UNIFORM_ALIGNMENT);
+    for (PassSource const &source : sources) {
+        StreamBuffer::Allocation allocation = uniforms.allocate(sizeof(EffectUniforms), UNIFORM_ALIGNMENT);
+        if (allocation.data != nullptr) {
+            EffectUniforms::write(allocation.data, source.effect);
+        }
+    }
+
+    drawLists.resize(sources.size());
+    jobSystem.parallelFor(sources.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t pass = begin; pass < end; ++pass) {
+            PassSource const &source = sources[pass];
+            drawLists[pass].build(*source.objects, source.effect, source.views, cameraOffset, source.shaderType,
+                                  hiZBuffer, -1, uniforms, UNIFORM_ALIGNMENT);
+        }
+    });
+    uniforms.flush();
+    uniforms.endFrame();
+}
+
+size_t DrawListBenchmark::getDrawCount() const {
+    size_t draws = 0;
+    for (DrawList const &drawList : drawLists) {
+        draws += drawList.items.size() + drawList.occludedItems.size();
+    }
+    return draws;
+}
@@ -0,0 +1,71 @@
+#ifndef DRAWLISTBENCHMARK_H
+#define DRAWLISTBENCHMARK_H
+
+#include <vector>
+
+#include "drawlist.h"
+#include "hizbuffer.h"
+#include "jobsystem.h"
+#include "multiview.h"
+#include "profiler.h"
+#include "scene.h"
+#include "simulation.h"
+#include "streambuffer.h"
+
+/*
+ * Builds the draw lists of every pass of a scene as MainView::buildDrawLists
+ * does, on the CPU only, to time how that scales with the threads of the job
+ * system. Driven by a replay with --headless --time-draw-lists.
+ *
+ * The meshes are prepared as for uploading, but stay in memory, and the
+ * uniforms go to a StreamBuffer in memory. Every world is resident from the
+ * start, without static batches, and every portal is drawn in full. There is
+ * no depth of an earlier frame, so nothing is culled by the Hi-Z buffer.
+ *
+ * The frames are timed by the profiler as well, with the zones MainView opens
+ * around them, when the render profile runs it. Comparing the times with
+ * --profile release to those with --profile profile gives what the profiler
+ * costs a frame.
+ */
+class DrawListBenchmark
+{
+public:
+    /*
+     * Takes the objects of the scene, and loads all of its worlds. Builds on
+     * threadCount threads, zero for one per core as in MainView.
+     */
+    DrawListBenchmark(Scene &scene, unsigned threadCount);
+    ~DrawListBenchmark();
+
+    DrawListBenchmark(DrawListBenchmark const &) = delete;
+    DrawListBenchmark &operator=(DrawListBenchmark const &) = delete;
+
+    /*
+     * Builds the draw lists of all passes for the frame of a tick, with the
+     * world effects at effectTime. Returns how long that took in
+     * milliseconds, not counting the model transforms.
+     */
+    double buildFrame(RenderSnapshot const &snapshot, float effectTime);
+
+    unsigned getThreadCount() const { return jobSystem.getThreadCount(); }
+    // Of the last frame, over all passes
+    size_t getDrawCount() const;
+    Profiler const &getProfiler() const { return profiler; }
+
+private:
+    ObjectTable *getWorldObjects(int worldId);
+    // The timed part of buildFrame
+    void buildDrawLists(RenderSnapshot const &snapshot, float effectTime, QVector3D const &cameraOffset);
+
+    Scene &scene;
+    std::vector<ObjectTable> worlds;
+
+    JobSystem jobSystem;
+    MultiView views;
+    HiZBuffer hiZBuffer;
+    StreamBuffer uniforms;
+    std::vector<DrawList> drawLists;
+    Profiler profiler;
+};
+
+#endif // DRAWLISTBENCHMARK_H
@@ -0,0 +1,165 @@
+#include "dynamicresolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <QDebug>
+
+namespace {
+
+// Scales are only raised while the frame takes less than this of the budget,
+// and by at most RAISE_STEP at a time
+constexpr float RAISE_BELOW = 0.8F;
+constexpr float RAISE_STEP = 1.05F;
+
+}
+
+void DynamicResolution::initialize(QOpenGLFunctions_3_3_Core *gl, Settings const &settings) {
+    this->gl = gl;
+    this->settings = settings;
+    if (isEnabled()) {
+        qDebug() << ":: Scaling the resolution to a GPU frame budget of" << settings.frameBudget << "ms";
+    }
+}
+
+void DynamicResolution::destroy() {
+    if (gl == nullptr) return;
+
+    for (auto &frame : frames) {
+        gl->glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        frame = Frame{};
+    }
+    current = nullptr;
+    gl = nullptr;
+}
+
+float DynamicResolution::getPortalScale(size_t portal) const {
+    return portal < portalScales.size() ? portalScales[portal] : 1.0F;
+}
+
+GLuint DynamicResolution::query(size_t index) {
+    std::vector<GLuint> &queries = current->queries;
+    if (index >= queries.size()) {
+        size_t first = queries.size();
+        queries.resize(index + 1);
+        gl->glGenQueries(static_cast<GLsizei>(queries.size() - first), queries.data() + first);
+    }
+    return queries[index];
+}
+
+void DynamicResolution::beginFrame(size_t portalCount) {
+    if (!isEnabled()) return;
+
+    portalScales.resize(portalCount, 1.0F);
+
+    // Oldest first, so the newest measurement has the last word
+    std::array<Frame *, FRAME_LATENCY> pending;
+    for (size_t i = 0; i < FRAME_LATENCY; ++i) {
+        pending[i] = &frames[i];
+    }
+    std::sort(pending.begin(), pending.end(), [](Frame const *a, Frame const *b) { return a->frame < b->frame; });
+    for (Frame *frame : pending) {
+        if (frame->pending) collect(*frame);
+    }
+
+    current = &frames[frameCount % FRAME_LATENCY];
+    // Still not done after FRAME_LATENCY frames, rather lose it than wait
+    current->pending = false;
+    current->frame = frameCount;
+    current->portalsTimed.assign(portalCount, false);
+    gl->glQueryCounter(query(0), GL_TIMESTAMP);
+}
+
+void DynamicResolution::beginPortal(size_t portal) {
+    if (current == nullptr) return;
+
+    gl->glQueryCounter(query(2 + 2 * portal), GL_TIMESTAMP);
+    current->portalsTimed[portal] = true;
+}
+
+void DynamicResolution::endPortal(size_t portal) {
+    if (current == nullptr) return;
+
+    gl->glQueryCounter(query(3 + 2 * portal), GL_TIMESTAMP);
+}
+
+void DynamicResolution::endFrame() {
+    if (current == nullptr) return;
+
+    // Written last, so once it is available all queries of the frame are
+    gl->glQueryCounter(query(1), GL_TIMESTAMP);
+    current->pending = true;
+    current = nullptr;
+    ++frameCount;
+}
+
+void DynamicResolution::collect(Frame &frame) {
+    GLint available = 0;
+    gl->glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+
+    frame.pending = false;
+    if (frame.frame < settledFrame) return;
+
+    auto milliseconds = [&](size_t begin) {
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        gl->glGetQueryObjectui64v(frame.queries[begin], GL_QUERY_RESULT, &start);
+        gl->glGetQueryObjectui64v(frame.queries[begin + 1], GL_QUERY_RESULT, &end);
+        return static_cast<float>(end - start) / 1e6F;
+    };
+
+    portalTimes.assign(frame.portalsTimed.size(), 0.0F);
+    for (size_t portal = 0; portal < frame.portalsTimed.size(); ++portal) {
+        if (frame.portalsTimed[portal]) {
+            portalTimes[portal] = milliseconds(2 + 2 * portal);
+        }
+    }
+    adjust(milliseconds(0));
+}
+
+void DynamicResolution::adjust(float frameMilliseconds) {
+    frameTime = frameMilliseconds;
+    float budget = settings.frameBudget;
+    size_t portalCount = std::min(portalTimes.size(), portalScales.size());
+
+    // The time of a pass goes with its pixels, the square of its scale
+    if (frameMilliseconds > budget) {
+        float excess = frameMilliseconds - budget;
+
+        order.resize(portalCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return portalTimes[a] > portalTimes[b]; });
+        for (size_t portal : order) {
+            float time = portalTimes[portal];
+            if (excess <= 0 || time <= 0) break;
+
+            float ratio = settings.minPortalScale / portalScales[portal];
+            float cut = std::min(excess, time * (1 - ratio * ratio));
+            if (cut <= 0) continue;
+
+            portalScales[portal] *= std::sqrt((time - cut) / time);
+            excess -= cut;
+        }
+
+        // What the portals could not make up for
+        if (excess > 0) {
+            sceneScale = std::max(settings.minScale, sceneScale * std::sqrt(budget / (budget + excess)));
+        }
+        settledFrame = frameCount;
+    } else if (frameMilliseconds < RAISE_BELOW * budget) {
+        float step = std::min(RAISE_STEP, std::sqrt(RAISE_BELOW * budget / std::max(frameMilliseconds, 1e-3F)));
+        if (sceneScale < 1) {
+            sceneScale = std::min(1.0F, sceneScale * step);
+            settledFrame = frameCount;
+        } else {
+            for (size_t portal = 0; portal < portalCount; ++portal) {
+                if (portalScales[portal] < 1) {
+                    portalScales[portal] = std::min(1.0F, portalScales[portal] * step);
+                    settledFrame = frameCount;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+
+/*
+ * Picks the resolution frames are rendered at, so the GPU time of a frame
+ * stays within a budget.
+ *
+ * Every frame is timed on the GPU with timestamp queries, as is the world
+ * behind every portal. Like the profiler, the queries of the last
+ * FRAME_LATENCY frames are kept in a ring and only read once available, so
+ * measuring never waits on the GPU.
+ *
+ * The scene scale applies to the whole frame. Every portal world has a scale
+ * of its own on top of it, relative to the scene's. Over budget, the portal
+ * worlds that take the longest are lowered first, down to minPortalScale, and
+ * only then the scene. Under budget, the scene is raised back first. Scales
+ * go down as far as needed at once, but up in small steps, so the frame
+ * time settles rather than oscillates.
+ *
+ * Only to be used from the GL thread.
+ */
+class DynamicResolution
+{
+public:
+    static constexpr size_t FRAME_LATENCY = 4;
+
+    struct Settings {
+        // GPU milliseconds a frame may take, 0 to always render at full scale
+        float frameBudget = 1000.0F / 60.0F;
+        // Of the window's resolution, per side
+        float minScale = 0.5F;
+        // Of the scene's resolution, per side
+        float minPortalScale = 0.5F;
+    };
+
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLFunctions_3_3_Core *gl, Settings const &settings);
+    void destroy();
+
+    bool isEnabled() const { return gl != nullptr && settings.frameBudget > 0; }
+    Settings const &getSettings() const { return settings; }
+
+    /*
+     * Adjusts the scales to the frames the GPU has finished, then starts
+     * timing this one. The scales stay fixed until the next beginFrame().
+     */
+    void beginFrame(size_t portalCount);
+    void beginPortal(size_t portal);
+    void endPortal(size_t portal);
+    void endFrame();
+
+    float getSceneScale() const { return sceneScale; }
+    float getPortalScale(size_t portal) const;
+
+    // The last GPU frame time measured, in milliseconds
+    float getFrameTime() const { return frameTime; }
+
+private:
+    struct Frame {
+        bool pending = false;
+        uint64_t frame = 0;
+        // A begin and end timestamp for the frame, then for every portal
+        std::vector<GLuint> queries;
+        std::vector<bool> portalsTimed;
+    };
+
+    void collect(Frame &frame);
+    void adjust(float frameMilliseconds);
+    GLuint query(size_t index);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    Settings settings;
+
+    std::array<Frame, FRAME_LATENCY> frames;
+    Frame *current = nullptr;
+    uint64_t frameCount = 0;
+    // Frames started before the last change measure the old scales
+    uint64_t settledFrame = 0;
+
+    float sceneScale = 1.0F;
+    std::vector<float> portalScales;
+    float frameTime = 0.0F;
+
+    // Of the frame being collected, kept to not allocate every frame
+    std::vector<float> portalTimes;
+    std::vector<size_t> order;
+};
+
+#endif // DYNAMICRESOLUTION_H
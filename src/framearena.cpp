@@ -0,0 +1,82 @@
+#include "framearena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> heapAllocationCount{0};
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+// Counts the allocations of the whole process, to see what still hits the heap
+// every frame. The array forms end up here as well.
+void *operator new(std::size_t size) {
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size != 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+std::atomic<uint64_t> FrameArena::currentFrame{0};
+
+FrameArena &FrameArena::local() {
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void FrameArena::endFrame() {
+    currentFrame.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t FrameArena::heapAllocations() {
+    return heapAllocationCount.load(std::memory_order_relaxed);
+}
+
+void *FrameArena::allocate(size_t size, size_t alignment) {
+    uint64_t current = currentFrame.load(std::memory_order_acquire);
+    if (frame != current) {
+        frame = current;
+        reset();
+    }
+
+    size_t offset = blocks.empty() ? 0 : alignUp(used, alignment);
+    if (blocks.empty() || offset + size > blocks.back().size) {
+        // Blocks come from new[], aligned for any fundamental type
+        addBlock(std::max(BLOCK_SIZE, size));
+        offset = 0;
+    }
+
+    used = offset + size;
+    return blocks.back().memory.get() + offset;
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        size_t total = 0;
+        for (auto const &block : blocks) {
+            total += block.size;
+        }
+        blocks.clear();
+        addBlock(total);
+    }
+    used = 0;
+}
+
+void FrameArena::addBlock(size_t size) {
+    blocks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+}
@@ -0,0 +1,85 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+ * Memory for data that only lives for one frame, handed out by bumping a
+ * pointer and freed all at once when the frame ends.
+ *
+ * Every thread allocates from an arena of its own, so allocating takes no
+ * locks. endFrame() frees the arenas of all threads: each one resets itself on
+ * the first allocation of the next frame. Memory from the arena may therefore
+ * move between the threads of a frame, but must not be kept past endFrame().
+ *
+ * An arena grows by adding blocks. When a frame needed more than one, they are
+ * merged into a single block on reset, so once the frames reach a steady size
+ * the arena no longer touches the heap.
+ */
+class FrameArena
+{
+public:
+    static constexpr size_t BLOCK_SIZE = 64 << 10;
+
+    // The arena of the calling thread
+    static FrameArena &local();
+
+    // Frees everything allocated in the frame, by every thread. Only to be
+    // called once no thread allocates or uses frame memory anymore.
+    static void endFrame();
+
+    // The number of times operator new was called in the process so far
+    static uint64_t heapAllocations();
+
+    // Alignment has to be a power of two
+    void *allocate(size_t size, size_t alignment);
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> memory;
+        size_t size;
+    };
+
+    void reset();
+    void addBlock(size_t size);
+
+    std::vector<Block> blocks;
+    size_t used = 0;
+    uint64_t frame = 0;
+
+    static std::atomic<uint64_t> currentFrame;
+};
+
+/*
+ * Allocates STL containers from the frame arena of the thread that grows them.
+ * Deallocation does nothing, the memory is freed at the end of the frame.
+ */
+template <typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+
+    FrameAllocator() = default;
+    template <typename U>
+    FrameAllocator(FrameAllocator<U> const &) {}
+
+    T *allocate(size_t count) {
+        return static_cast<T *>(FrameArena::local().allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(FrameAllocator<U> const &) const { return true; }
+    template <typename U>
+    bool operator!=(FrameAllocator<U> const &) const { return false; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // FRAMEARENA_H
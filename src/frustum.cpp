@@ -0,0 +1,57 @@
+#include "frustum.h"
+
+#include <limits>
+
+Frustum Frustum::fromMatrix(QMatrix4x4 const &matrix) {
+    Frustum frustum;
+
+    // Gribb & Hartmann: every plane is the last row plus or minus another row
+    QVector4D w = matrix.row(3);
+    frustum.planes = {
+        w + matrix.row(0), // Left
+        w - matrix.row(0), // Right
+        w + matrix.row(1), // Bottom
+        w - matrix.row(1), // Top
+        w + matrix.row(2), // Near
+        w - matrix.row(2)  // Far
+    };
+
+    for (auto &plane : frustum.planes) {
+        plane = plane / plane.toVector3D().length();
+    }
+
+    return frustum;
+}
+
+Frustum Frustum::fromMatrix(QMatrix4x4 const &matrix, float left, float right, float bottom, float top) {
+    Frustum frustum = fromMatrix(matrix);
+
+    // x / w >= left is x - left * w >= 0, and so on
+    QVector4D w = matrix.row(3);
+    frustum.planes[0] = matrix.row(0) - left * w;
+    frustum.planes[1] = right * w - matrix.row(0);
+    frustum.planes[2] = matrix.row(1) - bottom * w;
+    frustum.planes[3] = top * w - matrix.row(1);
+
+    for (int plane = 0; plane < 4; ++plane) {
+        frustum.planes[plane] = frustum.planes[plane] / frustum.planes[plane].toVector3D().length();
+    }
+
+    return frustum;
+}
+
+Frustum Frustum::none() {
+    Frustum frustum;
+    frustum.planes.fill(QVector4D{0, 0, 0, -std::numeric_limits<float>::max()});
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(QVector3D const &center, float radius) const {
+    for (auto const &plane : planes) {
+        float distance = QVector3D::dotProduct(plane.toVector3D(), center) + plane.w();
+        if (distance < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
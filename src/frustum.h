@@ -0,0 +1,41 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <array>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector4D>
+
+/*
+ * The six planes of a view frustum, for visibility tests.
+ */
+class Frustum
+{
+public:
+    Frustum() = default;
+
+    /*
+     * Extracts the planes from a (projection) matrix. The planes are in the
+     * space the matrix transforms from.
+     */
+    static Frustum fromMatrix(QMatrix4x4 const &matrix);
+    /*
+     * The same, narrowed to a window of the normalized device coordinates,
+     * left < right and bottom < top, all within [-1, 1].
+     */
+    static Frustum fromMatrix(QMatrix4x4 const &matrix, float left, float right, float bottom, float top);
+    // A frustum nothing is inside of
+    static Frustum none();
+
+    // Whether a sphere is at least partially inside the frustum
+    bool intersectsSphere(QVector3D const &center, float radius) const;
+
+    std::array<QVector4D, 6> const &getPlanes() const { return planes; }
+
+private:
+    // (a, b, c, d) such that a point p is inside if a*x + b*y + c*z + d >= 0
+    std::array<QVector4D, 6> planes;
+};
+
+#endif // FRUSTUM_H
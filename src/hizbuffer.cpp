@@ -0,0 +1,135 @@
+#include "hizbuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+void HiZBuffer::build(
+    uint32_t const *depthStencil, int width, int height, int passCount, JobSystem &jobSystem
+) {
+    this->width = width;
+    this->height = height;
+
+    int baseWidth = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    int baseHeight = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    pyramids.resize(passCount);
+    for (auto &pyramid : pyramids) {
+        pyramid.resize(1);
+        pyramid[0].width = baseWidth;
+        pyramid[0].height = baseHeight;
+        // Zero, so texels without any pixel of the pass occlude everything
+        pyramid[0].depths.assign(baseWidth * baseHeight, 0.0F);
+    }
+
+    // Finest level: every pixel only raises the texel of its own pass
+    jobSystem.parallelFor(baseHeight, 16, [&](size_t begin, size_t end) {
+        for (size_t by = begin; by < end; ++by) {
+            int yEnd = std::min(static_cast<int>(by + 1) * BLOCK_SIZE, height);
+            for (int y = by * BLOCK_SIZE; y < yEnd; ++y) {
+                uint32_t const *row = depthStencil + static_cast<size_t>(y) * width;
+                for (int x = 0; x < width; ++x) {
+                    int pass = row[x] & 0xFF;
+                    if (pass >= passCount) continue;
+
+                    float depth = static_cast<float>(row[x] >> 8) / static_cast<float>(0xFFFFFF);
+                    float &texel = pyramids[pass][0].depths[by * baseWidth + x / BLOCK_SIZE];
+                    texel = std::max(texel, depth);
+                }
+            }
+        }
+    });
+
+    // Coarser levels, down to a single texel
+    jobSystem.parallelFor(passCount, 1, [&](size_t begin, size_t end) {
+        for (size_t pass = begin; pass < end; ++pass) {
+            std::vector<Level> &pyramid = pyramids[pass];
+            while (pyramid.back().width > 1 || pyramid.back().height > 1) {
+                Level const &finer = pyramid.back();
+                Level coarser;
+                coarser.width = std::max(1, (finer.width + 1) / 2);
+                coarser.height = std::max(1, (finer.height + 1) / 2);
+                coarser.depths.resize(coarser.width * coarser.height);
+
+                for (int y = 0; y < coarser.height; ++y) {
+                    int y0 = std::min(2 * y, finer.height - 1);
+                    int y1 = std::min(2 * y + 1, finer.height - 1);
+                    for (int x = 0; x < coarser.width; ++x) {
+                        int x0 = std::min(2 * x, finer.width - 1);
+                        int x1 = std::min(2 * x + 1, finer.width - 1);
+                        coarser.depths[y * coarser.width + x] = std::max({
+                            finer.at(x0, y0), finer.at(x1, y0), finer.at(x0, y1), finer.at(x1, y1)
+                        });
+                    }
+                }
+                pyramid.push_back(std::move(coarser));
+            }
+        }
+    });
+}
+
+bool HiZBuffer::isOccluded(
+    int pass, QMatrix4x4 const &projection, QVector3D const &center, float radius
+) const {
+    if (pass < 0 || pass >= static_cast<int>(pyramids.size())) {
+        return false;
+    }
+
+    // Screen-space bounds of the box around the sphere
+    float minX = 1, minY = 1, maxX = -1, maxY = -1;
+    float nearestDepth = 1;
+    for (int corner = 0; corner < 8; ++corner) {
+        QVector3D offset{
+            corner & 1 ? radius : -radius,
+            corner & 2 ? radius : -radius,
+            corner & 4 ? radius : -radius
+        };
+        QVector4D clip = projection * QVector4D(center + offset, 1);
+        if (clip.w() <= 0) {
+            // Reaches behind the camera
+            return false;
+        }
+
+        QVector3D ndc = clip.toVector3DAffine();
+        minX = std::min(minX, ndc.x());
+        maxX = std::max(maxX, ndc.x());
+        minY = std::min(minY, ndc.y());
+        maxY = std::max(maxY, ndc.y());
+        nearestDepth = std::min(nearestDepth, ndc.z() * 0.5F + 0.5F);
+    }
+
+    if (nearestDepth <= 0) {
+        // Crosses the near plane
+        return false;
+    }
+
+    // Window coordinates, in texels of the finest level
+    std::vector<Level> const &pyramid = pyramids[pass];
+    float scaleX = 0.5F * width / BLOCK_SIZE;
+    float scaleY = 0.5F * height / BLOCK_SIZE;
+    int x0 = std::clamp(static_cast<int>((minX + 1) * scaleX), 0, pyramid[0].width - 1);
+    int x1 = std::clamp(static_cast<int>((maxX + 1) * scaleX), 0, pyramid[0].width - 1);
+    int y0 = std::clamp(static_cast<int>((minY + 1) * scaleY), 0, pyramid[0].height - 1);
+    int y1 = std::clamp(static_cast<int>((maxY + 1) * scaleY), 0, pyramid[0].height - 1);
+
+    // The level at which the bounds span at most two texels per side
+    int extent = std::max(x1 - x0, y1 - y0);
+    int level = 0;
+    while (extent > 1 && level + 1 < static_cast<int>(pyramid.size())) {
+        extent = (extent + 1) / 2;
+        ++level;
+    }
+    x0 >>= level;
+    x1 >>= level;
+    y0 >>= level;
+    y1 >>= level;
+
+    Level const &coarse = pyramid[level];
+    float furthestDepth = 0;
+    for (int y = y0; y <= std::min(y1, coarse.height - 1); ++y) {
+        for (int x = x0; x <= std::min(x1, coarse.width - 1); ++x) {
+            furthestDepth = std::max(furthestDepth, coarse.at(x, y));
+        }
+    }
+
+    return nearestDepth > furthestDepth;
+}
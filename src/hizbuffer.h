@@ -0,0 +1,60 @@
+#ifndef HIZBUFFER_H
+#define HIZBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "jobsystem.h"
+
+/*
+ * Hierarchical-Z pyramids built from the depth / stencil buffer of the
+ * previous frame, to test objects for occlusion before submitting them.
+ *
+ * There is one pyramid per render pass (the scene, or the world behind one
+ * portal), told apart by the stencil value the pass drew at. Pixels that
+ * belong to another pass count as fully occluding, as nothing of this pass
+ * can show up there.
+ *
+ * The pyramids lag one frame behind, so a test can be wrong for objects that
+ * moved into view. Objects culled by it have to be re-tested against the
+ * current frame before being skipped for good.
+ */
+class HiZBuffer
+{
+public:
+    // Pixels per side of a texel in the finest level
+    static constexpr int BLOCK_SIZE = 4;
+
+    /*
+     * Rebuilds the pyramids from a GL_DEPTH_STENCIL / GL_UNSIGNED_INT_24_8
+     * readback. Pass p owns the pixels with stencil value p.
+     */
+    void build(uint32_t const *depthStencil, int width, int height, int passCount, JobSystem &jobSystem);
+
+    void invalidate() { pyramids.clear(); }
+
+    /*
+     * Whether a sphere, given after the modelview transform, is hidden behind
+     * what was drawn in the pass. Conservative: returns false when unsure.
+     */
+    bool isOccluded(int pass, QMatrix4x4 const &projection, QVector3D const &center, float radius) const;
+
+private:
+    struct Level {
+        int width;
+        int height;
+        // Furthest window-space depth in each texel
+        std::vector<float> depths;
+
+        float at(int x, int y) const { return depths[y * width + x]; }
+    };
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<Level>> pyramids;
+};
+
+#endif // HIZBUFFER_H
@@ -0,0 +1,194 @@
+#include "impostoratlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <QDebug>
+
+#include "vectormath.h"
+
+namespace {
+
+// Of the atlas, per side, and of the tiles in it
+constexpr int MAX_ATLAS_SIZE = 4096;
+constexpr int MAX_TILE_SIZE = 256;
+constexpr int MIN_TILE_SIZE = 32;
+
+// A portal drawn in full stays so until it is this much further away than
+// the furthest of the nearest fullPortals
+constexpr float FULL_HYSTERESIS = 1.5F;
+
+}
+
+void ImpostorAtlas::initialize(QOpenGLFunctions_3_3_Core *gl, Settings const &settings) {
+    this->gl = gl;
+    this->settings = settings;
+    this->settings.fullPortals = std::clamp(settings.fullPortals, 0, MAX_FULL_PORTALS);
+    atlas.initialize(gl);
+}
+
+void ImpostorAtlas::destroy() {
+    if (gl == nullptr) return;
+
+    atlas.destroy();
+    impostors.clear();
+    tilesPerSide = 0;
+    tileSize = 0;
+    gl = nullptr;
+}
+
+void ImpostorAtlas::resize(size_t portalCount) {
+    impostors.assign(portalCount, Impostor{});
+    nextRefresh = 0;
+    if (portalCount <= static_cast<size_t>(settings.fullPortals)) {
+        return;
+    }
+
+    // One tile per portal, so tiles never change hands
+    tilesPerSide = std::min(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(portalCount)))),
+                            MAX_ATLAS_SIZE / MIN_TILE_SIZE);
+    tileSize = std::clamp(MAX_ATLAS_SIZE / tilesPerSide, MIN_TILE_SIZE, MAX_TILE_SIZE);
+    atlas.resize(tilesPerSide * tileSize, tilesPerSide * tileSize);
+    qDebug() << ":: Drawing portals past the nearest" << settings.fullPortals << "as impostors, in tiles of"
+             << tileSize << "pixels";
+}
+
+void ImpostorAtlas::invalidate() {
+    for (auto &impostor : impostors) {
+        impostor.hasImage = false;
+    }
+}
+
+void ImpostorAtlas::beginFrame(PortalTable const &portals, MultiView const &views, QVector3D const &cameraOffset) {
+    if (gl == nullptr) return;
+
+    if (impostors.size() != portals.size()) {
+        resize(portals.size());
+    }
+    size_t fullPortals = static_cast<size_t>(settings.fullPortals);
+    if (impostors.size() <= fullPortals) {
+        return;
+    }
+
+    auto distanceOf = [&](size_t portal) { return portals.collisions[portal].cameraDistance; };
+    order.resize(impostors.size());
+    std::iota(order.begin(), order.end(), 0);
+    float furthestFull = -1;
+    if (fullPortals > 0) {
+        std::nth_element(order.begin(), order.begin() + (fullPortals - 1), order.end(),
+                         [&](size_t a, size_t b) { return distanceOf(a) < distanceOf(b); });
+        furthestFull = distanceOf(order[fullPortals - 1]);
+    }
+
+    size_t tileCount = static_cast<size_t>(tilesPerSide) * tilesPerSide;
+    auto cropTo = [&](size_t portal, MultiView &tileViews) {
+        RenderHandle const &rh = portals.renderHandles[portal];
+        QMatrix4x4 const &modelTransform = portals.modelTransforms[portal];
+        return views.croppedTo(modelTransform.map(rh.boundsCenter),
+                               rh.boundsRadius * VectorMath::maxScale(modelTransform), tileViews);
+    };
+
+    MultiView tileViews;
+    for (size_t portal = 0; portal < impostors.size(); ++portal) {
+        Impostor &impostor = impostors[portal];
+        float distance = distanceOf(portal);
+        impostor.nearby = distance <= furthestFull ||
+                          (impostor.nearby && distance <= furthestFull * FULL_HYSTERESIS);
+
+        if (impostor.nearby || portal >= tileCount) {
+            // Its image would be out of date by the time it is an impostor again
+            impostor.mode = MODE::FULL;
+            impostor.hasImage = false;
+        } else if (impostor.hasImage) {
+            impostor.mode = MODE::IMPOSTOR;
+        } else if (cropTo(portal, tileViews)) {
+            impostor.mode = MODE::REFRESH;
+            impostor.tileViews = tileViews;
+            impostor.cameraOffset = cameraOffset;
+        } else {
+            impostor.mode = MODE::FULL;
+        }
+    }
+    limitFullPortals(portals, views, cameraOffset);
+
+    // Impostors off screen keep their image until they are back on it
+    int refreshes = 0;
+    for (size_t i = 0; i < impostors.size() && refreshes < settings.refreshesPerFrame; ++i) {
+        size_t portal = (nextRefresh + i) % impostors.size();
+        Impostor &impostor = impostors[portal];
+        if (impostor.mode != MODE::IMPOSTOR || !cropTo(portal, tileViews)) continue;
+
+        impostor.mode = MODE::REFRESH;
+        impostor.tileViews = tileViews;
+        impostor.cameraOffset = cameraOffset;
+        nextRefresh = portal + 1;
+        ++refreshes;
+    }
+}
+
+void ImpostorAtlas::limitFullPortals(PortalTable const &portals, MultiView const &views,
+                                     QVector3D const &cameraOffset) {
+    auto isFull = [&](size_t portal) { return impostors[portal].mode == MODE::FULL; };
+    if (std::count_if(order.begin(), order.end(), isFull) <= MAX_FULL_PORTALS) {
+        return;
+    }
+
+    // Only with more portals around the camera than there are stencil values
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return portals.collisions[a].cameraDistance < portals.collisions[b].cameraDistance;
+    });
+    size_t tileCount = static_cast<size_t>(tilesPerSide) * tilesPerSide;
+    int full = 0;
+    MultiView tileViews;
+    for (size_t portal : order) {
+        if (!isFull(portal) || ++full <= MAX_FULL_PORTALS) continue;
+
+        Impostor &impostor = impostors[portal];
+        RenderHandle const &rh = portals.renderHandles[portal];
+        QMatrix4x4 const &modelTransform = portals.modelTransforms[portal];
+        if (impostor.hasImage) {
+            impostor.mode = MODE::IMPOSTOR;
+        } else if (portal < tileCount &&
+                   views.croppedTo(modelTransform.map(rh.boundsCenter),
+                                   rh.boundsRadius * VectorMath::maxScale(modelTransform), tileViews)) {
+            impostor.mode = MODE::REFRESH;
+            impostor.tileViews = tileViews;
+            impostor.cameraOffset = cameraOffset;
+        } else {
+            impostor.mode = MODE::HIDDEN;
+        }
+    }
+}
+
+void ImpostorAtlas::beginRefresh(size_t portal) {
+    int x = static_cast<int>(portal) % tilesPerSide * tileSize;
+    int y = static_cast<int>(portal) / tilesPerSide * tileSize;
+    atlas.bind(atlas.getWidth(), atlas.getHeight());
+    gl->glViewport(x, y, tileSize, tileSize);
+
+    gl->glEnable(GL_SCISSOR_TEST);
+    gl->glScissor(x, y, tileSize, tileSize);
+    gl->glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    gl->glDisable(GL_SCISSOR_TEST);
+}
+
+void ImpostorAtlas::endRefresh(size_t portal, bool complete) {
+    impostors[portal].hasImage = complete;
+}
+
+QMatrix4x4 ImpostorAtlas::getImageTransform(size_t portal, QVector3D const &cameraOffset) const {
+    Impostor const &impostor = impostors[portal];
+
+    // From the clip space of the tile's view to the tile in the atlas
+    float scale = static_cast<float>(tileSize) / atlas.getWidth();
+    QMatrix4x4 transform;
+    transform.translate((static_cast<int>(portal) % tilesPerSide + 0.5F) * scale,
+                        (static_cast<int>(portal) / tilesPerSide + 0.5F) * scale);
+    transform.scale(scale / 2, scale / 2);
+
+    // The image was rendered with the camera where it was then
+    QMatrix4x4 cameraMoved;
+    cameraMoved.translate(impostor.cameraOffset - cameraOffset);
+    return transform * impostor.tileViews.getProjections()[0] * cameraMoved;
+}
@@ -0,0 +1,123 @@
+#ifndef IMPOSTORATLAS_H
+#define IMPOSTORATLAS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QVector3D>
+
+#include "multiview.h"
+#include "rendertarget.h"
+#include "scenestore.h"
+
+/*
+ * Stands in for the worlds behind distant portals with images of them, so a
+ * scene with hundreds of portals only renders the worlds of the nearest ones.
+ *
+ * The fullPortals portals nearest to the camera are drawn in full, each with
+ * a stencil and a pass of its own. Every other portal is an impostor: a tile
+ * of a shared atlas holds the world behind it as seen from the camera at some
+ * earlier frame, rendered at the tile's low resolution with the view cropped
+ * to the portal, and the portal is drawn as a single quad that projects the
+ * tile back onto itself. A few impostors are refreshed every frame, in turn.
+ *
+ * A portal has to get well past the nearest fullPortals to turn back into an
+ * impostor, so portals around the boundary do not switch every frame. An
+ * impostor that has no image yet is refreshed right away, or drawn in full if
+ * it cannot be (when it reaches in front of the near plane).
+ *
+ * The stencil buffer has 8 bits, so no more than MAX_FULL_PORTALS portals are
+ * drawn in full in a frame, whatever the hysteresis. The furthest ones past
+ * that are impostors as well, or hidden if they have no tile to be one.
+ *
+ * Only to be used from the GL thread.
+ */
+class ImpostorAtlas
+{
+public:
+    // Every portal drawn in full takes a stencil value, besides the 0 of the scene
+    static constexpr int MAX_FULL_PORTALS = 254;
+
+    struct Settings {
+        // The portals nearest to the camera drawn in full
+        int fullPortals = 16;
+        // Impostors with an image refreshed per frame, in turn
+        int refreshesPerFrame = 4;
+    };
+
+    enum class MODE {
+        FULL,
+        IMPOSTOR,
+        // An impostor, rendered into its tile this frame before it is drawn
+        REFRESH,
+        // Past MAX_FULL_PORTALS without a tile, only its border is drawn
+        HIDDEN
+    };
+
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLFunctions_3_3_Core *gl, Settings const &settings);
+    void destroy();
+
+    /*
+     * Picks how every portal is drawn this frame, by its distance to the
+     * camera, and the impostors to refresh. views are those of the frame,
+     * cameraOffset the translation of the camera.
+     */
+    void beginFrame(PortalTable const &portals, MultiView const &views, QVector3D const &cameraOffset);
+
+    // Drops the images of all impostors, when the worlds behind the portals change
+    void invalidate();
+
+    MODE getMode(size_t portal) const { return portal < impostors.size() ? impostors[portal].mode : MODE::FULL; }
+    // What an impostor that is being refreshed is rendered from, a single view cropped to the portal
+    MultiView const &getTileViews(size_t portal) const { return impostors[portal].tileViews; }
+    // Of a side of the tiles, in pixels
+    int getTileSize() const { return tileSize; }
+
+    // Binds and clears the tile of an impostor that is being refreshed
+    void beginRefresh(size_t portal);
+    // complete is false if the world was not there to render, so the image is not kept
+    void endRefresh(size_t portal, bool complete);
+
+    GLuint getAtlas() const { return atlas.getColor(); }
+    /*
+     * From the space of the modelview transforms, with the camera at
+     * cameraOffset, to the coordinates of an impostor's image in the atlas,
+     * before the division by w.
+     */
+    QMatrix4x4 getImageTransform(size_t portal, QVector3D const &cameraOffset) const;
+
+private:
+    struct Impostor {
+        MODE mode = MODE::FULL;
+        // Among the portals drawn in full, give or take the hysteresis
+        bool nearby = true;
+        bool hasImage = false;
+        // Of the last refresh, which the image was rendered from
+        MultiView tileViews;
+        QVector3D cameraOffset;
+    };
+
+    // Lays the tiles out for a number of portals
+    void resize(size_t portalCount);
+    // Turns the furthest portals drawn in full past MAX_FULL_PORTALS into impostors
+    void limitFullPortals(PortalTable const &portals, MultiView const &views, QVector3D const &cameraOffset);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    Settings settings;
+
+    RenderTarget atlas;
+    int tilesPerSide = 0;
+    int tileSize = 0;
+
+    std::vector<Impostor> impostors;
+    // Where the refreshes in turn continue next frame
+    size_t nextRefresh = 0;
+
+    // Kept to not allocate every frame
+    std::vector<size_t> order;
+};
+
+#endif // IMPOSTORATLAS_H
@@ -0,0 +1,254 @@
+#include "indirectdraws.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <QDebug>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QOpenGLVersionFunctionsFactory>
+#endif
+
+#include "drawlist.h"
+#include "shadersource.h"
+#include "vectormath.h"
+
+namespace {
+
+// The std430 layout of ObjectRecord in the shaders
+struct ObjectRecord
+{
+    float position[4];
+    float positionOffset[4];
+    float positionScale[4];
+    // Bounding sphere in model space: center and radius
+    float bounds[4];
+    GLuint count;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLint materialLayer;
+};
+
+static_assert(sizeof(ObjectRecord) == 80, "ObjectRecord should match the std430 layout");
+
+// As read by glMultiDrawElementsIndirect, written by the culling shader
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+constexpr GLuint CULL_GROUP_SIZE = 64;
+
+void copy(QVector3D const &from, float to[4], float w = 0) {
+    to[0] = from.x();
+    to[1] = from.y();
+    to[2] = from.z();
+    to[3] = w;
+}
+
+}
+
+bool IndirectDraws::initialize(QOpenGLContext *context, int viewCount) {
+    QSurfaceFormat format = context->format();
+    if (std::make_pair(format.majorVersion(), format.minorVersion()) < std::make_pair(4, 3)) {
+        qDebug() << ":: No GL 4.3, drawing without multi-draw-indirect";
+        return false;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    auto *functions = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_4_3_Core>(context);
+#else
+    auto *functions = context->versionFunctions<QOpenGLFunctions_4_3_Core>();
+#endif
+    if (functions == nullptr || !functions->initializeOpenGLFunctions()) {
+        return false;
+    }
+
+    if (!cullProgram.addShaderFromSourceCode(QOpenGLShader::Compute,
+                                             ShaderSource::load(":/shaders/cullcompshader.glsl")) ||
+        !cullProgram.link()) {
+        qWarning() << "Culling shader failed to build, drawing without multi-draw-indirect";
+        return false;
+    }
+    // The effect of the pass, bound by the caller of cull()
+    functions->glUniformBlockBinding(cullProgram.programId(),
+                                     functions->glGetUniformBlockIndex(cullProgram.programId(), "WorldEffect"),
+                                     EffectUniforms::BINDING);
+
+    // Instance i of a draw with baseInstance b reads element b + i
+    std::vector<GLuint> ids(MAX_OBJECTS);
+    std::iota(ids.begin(), ids.end(), 0);
+    functions->glGenBuffers(1, &drawIds);
+    functions->glBindBuffer(GL_ARRAY_BUFFER, drawIds);
+    functions->glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+    functions->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    gl = functions;
+    this->viewCount = viewCount;
+    qDebug() << ":: Drawing with multi-draw-indirect";
+    return true;
+}
+
+void IndirectDraws::destroy() {
+    if (gl == nullptr) return;
+
+    for (auto &pair : tables) {
+        gl->glDeleteBuffers(1, &pair.second.records);
+    }
+    tables.clear();
+
+    for (auto &pass : passes) {
+        gl->glDeleteBuffers(1, &pass.commands);
+    }
+    passes.clear();
+
+    gl->glDeleteBuffers(1, &drawIds);
+    gl = nullptr;
+}
+
+void IndirectDraws::attachDrawIds() {
+    if (gl == nullptr) return;
+
+    gl->glBindBuffer(GL_ARRAY_BUFFER, drawIds);
+    gl->glVertexAttribIPointer(DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    gl->glVertexAttribDivisor(DRAW_ID_LOCATION, static_cast<GLuint>(viewCount));
+    gl->glEnableVertexAttribArray(DRAW_ID_LOCATION);
+}
+
+void IndirectDraws::release(ObjectTable const &objects) {
+    auto table = tables.find(&objects);
+    if (table == tables.end()) return;
+
+    for (auto &pass : passes) {
+        if (pass.table == &table->second) {
+            pass.table = nullptr;
+        }
+    }
+
+    gl->glDeleteBuffers(1, &table->second.records);
+    tables.erase(table);
+}
+
+IndirectDraws::Table const &IndirectDraws::upload(ObjectTable const &objects) {
+    Table &table = tables[&objects];
+    // Objects do not move, so only a table that changed size needs new records
+    if (table.records != 0 && table.count == objects.size()) {
+        return table;
+    }
+
+    // Order the objects on material page and mesh, so each group is one draw
+    std::vector<size_t> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        RenderHandle const &first = objects.renderHandles[a];
+        RenderHandle const &second = objects.renderHandles[b];
+        if (first.material.page != second.material.page) return first.material.page < second.material.page;
+        return first.vao < second.vao;
+    });
+
+    std::vector<ObjectRecord> records(order.size());
+    table.groups.clear();
+    for (size_t i = 0; i < order.size(); ++i) {
+        RenderHandle const &rh = objects.renderHandles[order[i]];
+        ObjectRecord &record = records[i];
+
+        copy(objects.positions[order[i]], record.position);
+        copy(rh.positionOffset, record.positionOffset);
+        copy(rh.positionScale, record.positionScale);
+        copy(rh.boundsCenter, record.bounds, rh.boundsRadius);
+        record.count = rh.size;
+        record.firstIndex = rh.firstIndex;
+        record.baseVertex = 0;
+        record.materialLayer = rh.material.layer;
+
+        if (table.groups.empty() || table.groups.back().vao != rh.vao ||
+            table.groups.back().page != rh.material.page) {
+            table.groups.push_back({rh.vao, rh.material.page, static_cast<GLuint>(i), 0});
+        }
+        ++table.groups.back().count;
+    }
+
+    if (table.records == 0) {
+        gl->glGenBuffers(1, &table.records);
+    }
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, table.records);
+    gl->glBufferData(GL_SHADER_STORAGE_BUFFER, records.size() * sizeof(ObjectRecord),
+                     records.data(), GL_STATIC_DRAW);
+    gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    table.count = objects.size();
+
+    return table;
+}
+
+void IndirectDraws::cull(size_t pass, ObjectTable const *objects, QMatrix4x4 const &passTransform,
+                         MultiView const &views) {
+    if (passes.size() <= pass) {
+        passes.resize(pass + 1);
+    }
+    Pass &current = passes[pass];
+    current.table = nullptr;
+    current.transform = passTransform;
+    if (objects == nullptr || objects->size() == 0) {
+        return;
+    }
+    current.table = &upload(*objects);
+
+    if (current.commands == 0) {
+        gl->glGenBuffers(1, &current.commands);
+    }
+    if (current.capacity < current.table->count) {
+        current.capacity = current.table->count;
+        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, current.commands);
+        gl->glBufferData(GL_SHADER_STORAGE_BUFFER, current.capacity * sizeof(DrawElementsIndirectCommand),
+                         nullptr, GL_DYNAMIC_COPY);
+        gl->glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    cullProgram.bind();
+    cullProgram.setUniformValue("objectCount", static_cast<GLuint>(current.table->count));
+    cullProgram.setUniformValue("passTransform", passTransform);
+    cullProgram.setUniformValue("passScale", VectorMath::maxScale(passTransform));
+    std::array<QVector4D, 6 * MultiView::MAX_VIEWS> planes;
+    for (int view = 0; view < views.count(); ++view) {
+        auto const &frustumPlanes = views.getFrusta()[view].getPlanes();
+        std::copy(frustumPlanes.begin(), frustumPlanes.end(), planes.begin() + 6 * view);
+    }
+    cullProgram.setUniformValue("viewCount", views.count());
+    cullProgram.setUniformValueArray("frustumPlanes", planes.data(), 6 * views.count());
+
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, current.table->records);
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, current.commands);
+    gl->glDispatchCompute(static_cast<GLuint>((current.table->count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+
+    cullProgram.release();
+}
+
+void IndirectDraws::finishCulling() {
+    gl->glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
+
+void IndirectDraws::draw(size_t pass) {
+    if (pass >= passes.size() || passes[pass].table == nullptr) {
+        return;
+    }
+    Pass const &current = passes[pass];
+
+    gl->glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, current.table->records);
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, current.commands);
+    gl->glActiveTexture(GL_TEXTURE0);
+
+    for (auto const &group : current.table->groups) {
+        gl->glBindTexture(GL_TEXTURE_2D_ARRAY, group.page);
+        gl->glBindVertexArray(group.vao);
+        gl->glMultiDrawElementsIndirect(
+            GL_TRIANGLES, GL_UNSIGNED_INT,
+            reinterpret_cast<GLvoid const *>(group.first * sizeof(DrawElementsIndirectCommand)),
+            static_cast<GLsizei>(group.count), 0);
+    }
+
+    gl->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
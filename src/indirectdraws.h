@@ -0,0 +1,106 @@
+#ifndef INDIRECTDRAWS_H
+#define INDIRECTDRAWS_H
+
+#include <unordered_map>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_4_3_Core>
+#include <QOpenGLShaderProgram>
+
+#include "multiview.h"
+#include "scenestore.h"
+
+/*
+ * The GL 4.3 draw path, where the GPU culls and the CPU cost of a pass does
+ * not grow with the number of objects.
+ *
+ * The objects of a table are uploaded once, as records in a shader storage
+ * buffer. Every pass, a compute shader culls the records against the frustum
+ * and writes one draw command per object, with an instance count of 0 for the
+ * culled ones. The pass is then drawn with one glMultiDrawElementsIndirect per
+ * mesh and material page.
+ *
+ * The vertex shader finds the record of a draw through the baseInstance of its
+ * command: the mesh VAOs get an instanced attribute at DRAW_ID_LOCATION that
+ * counts up from 0, which therefore reads as the baseInstance. A visible object
+ * is drawn once per view (see MultiView), so the attribute advances once every
+ * viewCount instances.
+ *
+ * Only to be used from the GL thread.
+ */
+class IndirectDraws
+{
+public:
+    static constexpr GLuint DRAW_ID_LOCATION = 3;
+    // Tables with more objects are left to the GL 3.3 path
+    static constexpr GLuint MAX_OBJECTS = 1 << 16;
+
+    /*
+     * Returns false if the context does not support GL 4.3 or the culling
+     * shader does not compile, in which case the path stays unavailable.
+     */
+    bool initialize(QOpenGLContext *context, int viewCount);
+    void destroy();
+
+    bool isAvailable() const { return gl != nullptr; }
+    bool supports(ObjectTable const &objects) const { return objects.size() <= MAX_OBJECTS; }
+
+    // Adds the draw id attribute to the vertex array that is currently bound
+    void attachDrawIds();
+
+    // Drops the records of a table, before it is freed
+    void release(ObjectTable const &objects);
+
+    /*
+     * Culls the objects of a pass, or clears the pass if objects is nullptr.
+     * The world effect of the pass, bound at EffectUniforms::BINDING, is
+     * applied first, then the pass transform (the camera), and then the
+     * objects are moved to their positions.
+     */
+    void cull(size_t pass, ObjectTable const *objects, QMatrix4x4 const &passTransform,
+              MultiView const &views);
+
+    // Makes the commands of all passes culled so far visible to draw()
+    void finishCulling();
+
+    QMatrix4x4 const &getPassTransform(size_t pass) const { return passes[pass].transform; }
+
+    // Draws a culled pass, with a program on shaders/indirectvertshader.glsl bound
+    void draw(size_t pass);
+
+private:
+    // The objects sharing a mesh and material page, contiguous in the records
+    struct Group {
+        GLuint vao;
+        GLuint page;
+        GLuint first;
+        GLuint count;
+    };
+
+    struct Table {
+        GLuint records = 0;
+        size_t count = 0;
+        std::vector<Group> groups;
+    };
+
+    struct Pass {
+        Table const *table = nullptr;
+        QMatrix4x4 transform;
+        GLuint commands = 0;
+        size_t capacity = 0;
+    };
+
+    Table const &upload(ObjectTable const &objects);
+
+    QOpenGLFunctions_4_3_Core *gl = nullptr;
+    QOpenGLShaderProgram cullProgram;
+    GLuint drawIds = 0;
+    int viewCount = 1;
+
+    std::unordered_map<ObjectTable const *, Table> tables;
+    std::vector<Pass> passes;
+};
+
+#endif // INDIRECTDRAWS_H
@@ -0,0 +1,173 @@
+#include "inputrecording.h"
+
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QtGlobal>
+
+#include "simulation.h"
+
+namespace {
+
+constexpr char MAGIC[4] = {'M', 'W', 'I', 'R'};
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    // Of the recording session, a span of 1 is 1 / tickRate seconds
+    uint32_t tickRate;
+    uint32_t tickCount;
+    uint32_t eventCount;
+    uint32_t reserved;
+};
+
+struct TickRecord {
+    float span;
+    uint32_t eventCount;
+    // x, y, z, pan, tilt, roll
+    float camera[6];
+    int32_t worldId;
+};
+
+struct EventRecord {
+    uint8_t action;
+    uint8_t status;
+    uint16_t reserved;
+    float at;
+};
+
+// After the header: the ticks, then the events of all ticks in order
+static_assert(sizeof(FileHeader) == 24, "FileHeader should not be padded");
+static_assert(sizeof(TickRecord) == 36, "TickRecord should not be padded");
+static_assert(sizeof(EventRecord) == 8, "EventRecord should not be padded");
+
+template <typename T>
+void writeRecords(QFile &file, std::vector<T> const &records) {
+    file.write(reinterpret_cast<char const *>(records.data()), records.size() * sizeof(T));
+}
+
+}
+
+void InputRecording::clear() {
+    ticks.clear();
+    events.clear();
+}
+
+void InputRecording::reserve(size_t ticks) {
+    this->ticks.reserve(ticks);
+}
+
+void InputRecording::addTick(float span, Event const *events, size_t eventCount, Camera::Pose const &camera,
+                             int worldId) {
+    ticks.push_back({span, static_cast<uint32_t>(this->events.size()), static_cast<uint32_t>(eventCount),
+                     camera, worldId});
+    this->events.insert(this->events.end(), events, events + eventCount);
+}
+
+bool InputRecording::save(QString const &fileName) const {
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.tickRate = Simulation::TICK_RATE;
+    header.tickCount = static_cast<uint32_t>(ticks.size());
+    header.eventCount = static_cast<uint32_t>(events.size());
+
+    std::vector<TickRecord> tickRecords(ticks.size());
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        Tick const &tick = ticks[i];
+        TickRecord &record = tickRecords[i];
+        record.span = tick.span;
+        record.eventCount = tick.eventCount;
+        float const camera[6] = {tick.camera.x, tick.camera.y, tick.camera.z,
+                                 tick.camera.pan, tick.camera.tilt, tick.camera.roll};
+        std::memcpy(record.camera, camera, sizeof(camera));
+        record.worldId = tick.worldId;
+    }
+
+    std::vector<EventRecord> eventRecords(events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        eventRecords[i] = {static_cast<uint8_t>(events[i].action), static_cast<uint8_t>(events[i].status), 0,
+                           events[i].at};
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write recording" << fileName;
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    writeRecords(file, tickRecords);
+    writeRecords(file, eventRecords);
+
+    if (file.error() != QFileDevice::NoError) {
+        qWarning() << "Could not write recording" << fileName << "-" << file.errorString();
+        return false;
+    }
+    qDebug() << ":: Recorded" << ticks.size() << "ticks and" << events.size() << "key events to" << fileName;
+    return true;
+}
+
+bool InputRecording::load(QString const &fileName) {
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    qWarning() << "Recordings are little endian, cannot replay" << fileName;
+    return false;
+#endif
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open recording" << fileName;
+        return false;
+    }
+    QByteArray contents = file.readAll();
+    auto const *data = reinterpret_cast<uchar const *>(contents.constData());
+
+    auto invalid = [&](char const *reason) {
+        qWarning() << "Invalid recording" << fileName << "-" << reason;
+        clear();
+        return false;
+    };
+
+    quint64 size = static_cast<quint64>(contents.size());
+    FileHeader header;
+    if (size < sizeof(header)) return invalid("no header");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return invalid("wrong magic");
+    if (header.version != VERSION) return invalid("unsupported version");
+    if (header.tickRate != Simulation::TICK_RATE) return invalid("recorded at another tick rate");
+
+    quint64 ticksOffset = sizeof(FileHeader);
+    quint64 eventsOffset = ticksOffset + quint64{header.tickCount} * sizeof(TickRecord);
+    if (eventsOffset + quint64{header.eventCount} * sizeof(EventRecord) != size) return invalid("wrong size");
+
+    clear();
+    events.reserve(header.eventCount);
+    for (uint32_t i = 0; i < header.eventCount; ++i) {
+        EventRecord record;
+        std::memcpy(&record, data + eventsOffset + i * sizeof(record), sizeof(record));
+        if (record.action >= KeyboardStatus::ACTION_COUNT ||
+            record.status > static_cast<uint8_t>(KeyboardStatus::KEY_STATUS::UP)) {
+            return invalid("bad event");
+        }
+        events.push_back({static_cast<KeyboardStatus::ACTION>(record.action),
+                          static_cast<KeyboardStatus::KEY_STATUS>(record.status), record.at});
+    }
+
+    ticks.reserve(header.tickCount);
+    uint32_t firstEvent = 0;
+    for (uint32_t i = 0; i < header.tickCount; ++i) {
+        TickRecord record;
+        std::memcpy(&record, data + ticksOffset + i * sizeof(record), sizeof(record));
+        if (quint64{firstEvent} + record.eventCount > header.eventCount) return invalid("bad event count");
+
+        Camera::Pose camera{record.camera[0], record.camera[1], record.camera[2],
+                            record.camera[3], record.camera[4], record.camera[5]};
+        ticks.push_back({record.span, firstEvent, record.eventCount, camera, record.worldId});
+        firstEvent += record.eventCount;
+    }
+    if (firstEvent != header.eventCount) return invalid("bad event count");
+
+    qDebug() << ":: Loaded recording" << fileName << "of" << ticks.size() << "ticks";
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef INPUTRECORDING_H
+#define INPUTRECORDING_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+#include "camera.h"
+#include "keyboardstatus.h"
+
+/*
+ * The input of every simulation tick of a session, and where the camera ended
+ * up after each, so the session can be replayed tick for tick.
+ *
+ * A tick is recorded as the span of time it simulated and the key events
+ * within it, both in ticks rather than wall clock time, so replaying does not
+ * depend on when the ticks run. The camera pose and world after the tick are
+ * kept as well: a replay follows them exactly, and checks the input against
+ * them to tell whether the camera code still moves the same way.
+ *
+ * On disk it is a little endian header followed by a flat array of tick
+ * records and one of event records, in the order of the ticks.
+ */
+class InputRecording
+{
+public:
+    struct Event {
+        KeyboardStatus::ACTION action;
+        KeyboardStatus::KEY_STATUS status;
+        // In ticks since the start of the tick
+        float at;
+    };
+
+    struct Tick {
+        // In ticks, usually close to 1
+        float span;
+        uint32_t firstEvent;
+        uint32_t eventCount;
+        // After the tick
+        Camera::Pose camera;
+        int worldId;
+    };
+
+    void clear();
+    void reserve(size_t ticks);
+
+    void addTick(float span, Event const *events, size_t eventCount, Camera::Pose const &camera, int worldId);
+
+    size_t size() const { return ticks.size(); }
+    bool isEmpty() const { return ticks.empty(); }
+    Tick const &tick(size_t index) const { return ticks[index]; }
+    Event const *eventsOf(Tick const &tick) const { return events.data() + tick.firstEvent; }
+
+    /*
+     * Returns false, having warned about what is wrong, if the file does not
+     * save or load.
+     */
+    bool save(QString const &fileName) const;
+    bool load(QString const &fileName);
+
+private:
+    std::vector<Tick> ticks;
+    std::vector<Event> events;
+};
+
+#endif // INPUTRECORDING_H
@@ -0,0 +1,154 @@
+#include "jobsystem.h"
+
+#include <algorithm>
+
+namespace {
+
+// The job system the current thread works for, and its queue in there
+thread_local JobSystem const *currentJobSystem = nullptr;
+thread_local int currentQueueIndex = -1;
+
+}
+
+bool JobSystem::Queue::pushBack(Task const &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail - head == CAPACITY) return false;
+
+    tasks[tail % CAPACITY] = task;
+    ++tail;
+    return true;
+}
+
+bool JobSystem::Queue::popBack(Task &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head) return false;
+
+    --tail;
+    task = tasks[tail % CAPACITY];
+    return true;
+}
+
+bool JobSystem::Queue::popFront(Task &task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail == head) return false;
+
+    task = tasks[head % CAPACITY];
+    ++head;
+    return true;
+}
+
+JobSystem::JobSystem(unsigned threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    // Queue 0 belongs to the creating thread
+    currentJobSystem = this;
+    currentQueueIndex = 0;
+
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        running = false;
+    }
+    wakeUp.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (currentJobSystem == this) {
+        currentJobSystem = nullptr;
+        currentQueueIndex = -1;
+    }
+}
+
+void JobSystem::wait(TaskGroup &group) {
+    Task task;
+    while (group.pending.load(std::memory_order_acquire) != 0) {
+        if (findTask(task)) {
+            execute(task);
+        } else {
+            // The remaining tasks are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::push(TaskGroup &group, Task task) {
+    task.group = &group;
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+
+    int index = currentQueue();
+    Queue &queue = *queues[index < 0 ? 0 : index];
+    if (!queue.pushBack(task)) {
+        // Queue is full, just do it now
+        execute(task);
+        return;
+    }
+
+    queuedTasks.fetch_add(1, std::memory_order_release);
+    {
+        // Lock, so a worker can't miss the notification between checking and sleeping
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+}
+
+bool JobSystem::findTask(Task &task) {
+    int own = currentQueue();
+    if (own >= 0 && queues[own]->popBack(task)) {
+        queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Steal, starting at the queue after our own to spread out the thieves
+    size_t count = queues.size();
+    size_t start = own < 0 ? 0 : own + 1;
+    for (size_t i = 0; i < count; ++i) {
+        size_t victim = (start + i) % count;
+        if (static_cast<int>(victim) == own) continue;
+
+        if (queues[victim]->popFront(task)) {
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(Task &task) {
+    task.function(task.callable, task.begin, task.end);
+    task.group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    currentJobSystem = this;
+    currentQueueIndex = static_cast<int>(index);
+
+    Task task;
+    while (running.load()) {
+        if (findTask(task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] {
+            return !running.load() || queuedTasks.load(std::memory_order_acquire) != 0;
+        });
+    }
+}
+
+int JobSystem::currentQueue() const {
+    return currentJobSystem == this ? currentQueueIndex : -1;
+}
@@ -0,0 +1,131 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A work-stealing scheduler for short, per-frame CPU tasks.
+ *
+ * Every thread (the workers, plus the thread that created the job system)
+ * has its own task queue. Threads push and pop their own tasks at the back,
+ * and idle threads steal from the front of other queues. A thread waiting on
+ * a TaskGroup keeps executing tasks in the meantime, so nested fork-join works.
+ *
+ * Tasks only reference their callable, nothing is allocated per task: the
+ * callable has to outlive the wait() on its group, which fork-join usage
+ * guarantees.
+ */
+class JobSystem
+{
+public:
+    /*
+     * Tracks a set of tasks to wait on.
+     */
+    class TaskGroup
+    {
+        friend class JobSystem;
+        std::atomic<size_t> pending{0};
+    };
+
+    /*
+     * Creates a job system with threadCount threads in total, including the
+     * calling thread. Zero picks one thread per core.
+     */
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(JobSystem const &) = delete;
+    JobSystem &operator=(JobSystem const &) = delete;
+
+    // Including the thread that created the job system
+    unsigned getThreadCount() const { return static_cast<unsigned>(queues.size()); }
+
+    // Schedules task() to run as part of group
+    template <typename Task>
+    void run(TaskGroup &group, Task &task) {
+        push(group, {&invoke<Task>, &task, 0, 0});
+    }
+
+    // Blocks until all tasks of the group are done, executing tasks meanwhile
+    void wait(TaskGroup &group);
+
+    /*
+     * Calls body(begin, end) on consecutive ranges of [0, count), of at most
+     * grainSize elements each, spread over all threads. Returns when all
+     * ranges are done.
+     */
+    template <typename Body>
+    void parallelFor(size_t count, size_t grainSize, Body const &body) {
+        if (count == 0) return;
+        if (grainSize == 0) grainSize = 1;
+
+        TaskGroup group;
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+            size_t end = begin + grainSize < count ? begin + grainSize : count;
+            push(group, {&invokeRange<Body>, const_cast<Body *>(&body), begin, end});
+        }
+        wait(group);
+    }
+
+private:
+    struct Task {
+        void (*function)(void *callable, size_t begin, size_t end);
+        void *callable;
+        size_t begin;
+        size_t end;
+        TaskGroup *group = nullptr;
+    };
+
+    /*
+     * A fixed size deque guarded by a lock. The owner uses the back, thieves the
+     * front. Fixed size, so scheduling never allocates.
+     */
+    struct Queue {
+        static constexpr size_t CAPACITY = 1024;
+
+        std::mutex mutex;
+        std::array<Task, CAPACITY> tasks;
+        size_t head = 0;
+        size_t tail = 0;
+
+        bool pushBack(Task const &task);
+        bool popBack(Task &task);
+        bool popFront(Task &task);
+    };
+
+    template <typename Task>
+    static void invoke(void *callable, size_t, size_t) {
+        (*static_cast<Task *>(callable))();
+    }
+
+    template <typename Body>
+    static void invokeRange(void *callable, size_t begin, size_t end) {
+        (*static_cast<Body const *>(callable))(begin, end);
+    }
+
+    void push(TaskGroup &group, Task task);
+    bool findTask(Task &task);
+    void execute(Task &task);
+    void workerLoop(unsigned index);
+
+    // Index of the queue of the current thread, or -1 if it is not part of this job system
+    int currentQueue() const;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // Number of tasks sitting in queues, lets idle workers sleep
+    std::atomic<size_t> queuedTasks{0};
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<bool> running{true};
+};
+
+#endif // JOBSYSTEM_H
@@ -1,14 +1,23 @@
 #include "keyboardstatus.h"
 
-void KeyboardStatus::updateStatus(int key, KEY_STATUS status) {
-    keyStatuses[key] = status;
-}
+#include <QtCore/qnamespace.h>
 
-bool KeyboardStatus::isDown(char key) {
-    if (keyStatuses.find(key) == keyStatuses.end()) {
-        // Initialize key to up, if status has not been set.
-        keyStatuses[key] = KEY_STATUS::UP;
+bool KeyboardStatus::actionFor(int key, ACTION &action) {
+    switch (key) {
+    case Qt::Key_W: action = ACTION::MOVE_FORWARD; return true;
+    case Qt::Key_S: action = ACTION::MOVE_BACKWARD; return true;
+    case Qt::Key_A: action = ACTION::MOVE_LEFT; return true;
+    case Qt::Key_D: action = ACTION::MOVE_RIGHT; return true;
+    case Qt::Key_Z: action = ACTION::HOVER_UP; return true;
+    case Qt::Key_X: action = ACTION::HOVER_DOWN; return true;
+    case Qt::Key_Q: action = ACTION::ROTATE_LEFT; return true;
+    case Qt::Key_E: action = ACTION::ROTATE_RIGHT; return true;
+    case Qt::Key_R: action = ACTION::ROTATE_UP; return true;
+    case Qt::Key_F: action = ACTION::ROTATE_DOWN; return true;
+    default: return false;
     }
+}
 
-    return keyStatuses[key] == KEY_STATUS::DOWN;
+void KeyboardStatus::updateStatus(ACTION action, KEY_STATUS status) {
+    actions.set(static_cast<size_t>(action), status == KEY_STATUS::DOWN);
 }
@@ -1,30 +1,73 @@
 #ifndef KEYBOARDSTATUS_H
 #define KEYBOARDSTATUS_H
 
-#include <unordered_map>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
 
 /*
- * Keeps track of the status of keyboard presses (whether it is being held down or not
+ * Keeps track of which actions are being held down, as mapped from keys.
+ *
+ * Key presses and releases arrive as timestamped events, so whoever consumes
+ * them can tell how long within a tick an action was held.
  */
 class KeyboardStatus
 {
 public:
+    using Clock = std::chrono::steady_clock;
+
     enum class KEY_STATUS {
         DOWN,
         UP
     };
-private:
-    std::unordered_map<int, KEY_STATUS> keyStatuses;
-public:
+
+    enum class ACTION {
+        MOVE_FORWARD,
+        MOVE_BACKWARD,
+        MOVE_LEFT,
+        MOVE_RIGHT,
+        HOVER_UP,
+        HOVER_DOWN,
+        ROTATE_LEFT,
+        ROTATE_RIGHT,
+        ROTATE_UP,
+        ROTATE_DOWN,
+        COUNT
+    };
+
+    static constexpr size_t ACTION_COUNT = static_cast<size_t>(ACTION::COUNT);
+    using Actions = std::bitset<ACTION_COUNT>;
+
     /*
-     * Update the status of the keyboard key.
+     * A press or release of the key mapped to an action, at the time the
+     * GUI thread received it.
      */
-    void updateStatus(int key, KEY_STATUS status);
+    struct Event {
+        ACTION action;
+        KEY_STATUS status;
+        Clock::time_point time;
+    };
 
     /*
-     * Returns whether a key is currently down (i.e: pressed)
+     * Finds the action a key is mapped to. Returns false for keys that are
+     * not mapped.
      */
-    bool isDown(char key);
+    static bool actionFor(int key, ACTION &action);
+
+    /*
+     * Update the status of an action.
+     */
+    void updateStatus(ACTION action, KEY_STATUS status);
+
+    /*
+     * Returns whether an action is currently down (i.e: its key is pressed)
+     */
+    bool isDown(ACTION action) const { return actions.test(static_cast<size_t>(action)); }
+
+    Actions const &getActions() const { return actions; }
+
+private:
+    Actions actions;
 };
 
 #endif // KEYBOARDSTATUS_H
@@ -1,7 +1,152 @@
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QSurfaceFormat>
 
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "drawlistbenchmark.h"
+#include "inputrecording.h"
 #include "mainwindow.h"
+#include "renderprofile.h"
+#include "scenefile.h"
+#include "simulation.h"
+#include "texturefile.h"
+
+/**
+ * @brief timeDrawLists Builds the draw lists of the frame of every tick of a
+ * recording on the CPU only, see DrawListBenchmark, and reports the time per
+ * frame, and the profiler's percentiles if the render profile runs it.
+ * @param settings Settings with the scene to replay the recording in.
+ * @param recording The recording.
+ * @param threadCount The threads to build the draw lists on.
+ * @param median Set to the median time per frame, in milliseconds.
+ * @return Whether every tick moved as it was recorded.
+ */
+static bool timeDrawLists(RenderSettings const &settings, InputRecording const &recording, unsigned threadCount,
+                          double &median) {
+  // A scene and simulation of its own, so every run replays the same frames
+  Scene scene = SceneFile::loadOrBuiltIn(settings.sceneFile);
+  Simulation simulation{scene.portalObjects};
+  DrawListBenchmark benchmark{scene, threadCount};
+
+  std::vector<double> milliseconds;
+  size_t draws = 0;
+  size_t diverged = 0;
+  for (size_t tick = 0; tick < recording.size(); ++tick) {
+    if (!simulation.replayTick(recording, tick)) {
+      ++diverged;
+    }
+    RenderSnapshot const &snapshot = simulation.latestSnapshot();
+    // The world effects animate by the ticks, as in a replay that is drawn
+    float effectTime = static_cast<float>(snapshot.tick * std::chrono::duration<double>(
+                                                              Simulation::tickDuration()).count());
+    milliseconds.push_back(benchmark.buildFrame(snapshot, effectTime));
+    draws += benchmark.getDrawCount();
+  }
+  if (milliseconds.empty()) {
+    median = 0;
+    return diverged == 0;
+  }
+
+  double total = 0;
+  for (double frame : milliseconds) {
+    total += frame;
+  }
+  std::sort(milliseconds.begin(), milliseconds.end());
+  median = milliseconds[milliseconds.size() / 2];
+  qDebug() << ":: Built the draw lists of" << milliseconds.size() << "frames on" << benchmark.getThreadCount()
+           << "threads with the" << qPrintable(toString(RenderSettings::current().profile))
+           << "profile, median" << median << "ms, mean" << total / milliseconds.size() << "ms, max"
+           << milliseconds.back() << "ms," << draws / milliseconds.size() << "draws per frame";
+  for (auto const &zone : benchmark.getProfiler().getStatistics()) {
+      qDebug().noquote() << QString("%1 p50 %2 p95 %3 p99 %4 ms")
+                                .arg(zone.name, -30)
+                                .arg(zone.p50, 7, 'f', 2)
+                                .arg(zone.p95, 7, 'f', 2)
+                                .arg(zone.p99, 7, 'f', 2);
+  }
+  return diverged == 0;
+}
+
+/**
+ * @brief timeDrawListScaling Times the draw list builds of a recording on 1,
+ * 2, 4, ... threads up to one per core, and reports the median of each
+ * against that on a single thread. MANY_WORLDS_THREADS times only that many.
+ * @param settings Settings with the scene to replay the recording in.
+ * @param recording The recording.
+ * @return Whether every tick of every run moved as it was recorded.
+ */
+static bool timeDrawListScaling(RenderSettings const &settings, InputRecording const &recording) {
+  std::vector<unsigned> threadCounts;
+  int requested = qEnvironmentVariableIntValue("MANY_WORLDS_THREADS");
+  if (requested > 0) {
+    threadCounts.push_back(static_cast<unsigned>(requested));
+  } else {
+    unsigned cores = std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads < cores; threads *= 2) {
+      threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(cores);
+  }
+
+  bool replayed = true;
+  std::vector<double> medians;
+  for (unsigned threads : threadCounts) {
+    double median = 0;
+    replayed = timeDrawLists(settings, recording, threads, median) && replayed;
+    medians.push_back(median);
+  }
+
+  qDebug() << ":: Draw list builds by threads, median ms per frame and speedup over the first";
+  for (size_t i = 0; i < threadCounts.size(); ++i) {
+    qDebug().noquote() << QString("%1 threads %2 ms %3x")
+                              .arg(static_cast<qulonglong>(threadCounts[i]), 3)
+                              .arg(medians[i], 7, 'f', 3)
+                              .arg(medians[i] > 0 ? medians.front() / medians[i] : 0.0, 5, 'f', 2);
+  }
+  return replayed;
+}
+
+/**
+ * @brief replayHeadless Runs a recording through the simulation only, without
+ * a window or GL, as fast as it goes.
+ * @param settings Settings with the recording and the scene to replay it in.
+ * @return Whether every tick moved as it was recorded.
+ */
+static bool replayHeadless(RenderSettings const &settings) {
+  InputRecording recording;
+  if (settings.replayFile.isEmpty()) {
+    qWarning() << "--headless needs a recording to --replay";
+    return false;
+  }
+  if (!recording.load(settings.replayFile)) {
+    return false;
+  }
+
+  if (settings.timeDrawLists) {
+    return timeDrawListScaling(settings, recording);
+  }
+
+  Scene scene = SceneFile::loadOrBuiltIn(settings.sceneFile);
+  Simulation simulation{scene.portalObjects};
+
+  QElapsedTimer timer;
+  timer.start();
+  size_t diverged = 0;
+  for (size_t tick = 0; tick < recording.size(); ++tick) {
+    if (!simulation.replayTick(recording, tick)) {
+      ++diverged;
+    }
+  }
+  double milliseconds = timer.nsecsElapsed() / 1e6;
+
+  qDebug() << ":: Replayed" << recording.size() << "ticks in" << milliseconds << "ms,"
+           << diverged << "did not move as recorded";
+  return diverged == 0;
+}
 
 /**
  * @brief main Entry point of the application.
@@ -10,17 +155,41 @@
  * @return Exit code.
  */
 int main(int argc, char *argv[]) {
+  // --compile-scene <text file> <binary file> converts a scene and exits
+  if (argc == 4 && std::strcmp(argv[1], "--compile-scene") == 0) {
+    return SceneFile::compile(QString::fromLocal8Bit(argv[2]), QString::fromLocal8Bit(argv[3])) ? 0 : 1;
+  }
+  // --compile-texture <image> <texture file> likewise, see TextureFile
+  if (argc == 4 && std::strcmp(argv[1], "--compile-texture") == 0) {
+    return TextureFile::compile(QString::fromLocal8Bit(argv[2]), QString::fromLocal8Bit(argv[3])) ? 0 : 1;
+  }
+
+  RenderSettings renderSettings = RenderSettings::fromCommandLine(argc, argv);
+  RenderSettings::setCurrent(renderSettings);
+
+  if (renderSettings.headless) {
+    return replayHeadless(renderSettings) ? 0 : 1;
+  }
+
   QApplication a(argc, argv);
+  qDebug() << ":: Render profile" << qPrintable(toString(renderSettings.profile));
 
   // Request OpenGL 3.3 Core
   QSurfaceFormat glFormat;
   glFormat.setProfile(QSurfaceFormat::CoreProfile);
   glFormat.setVersion(3, 3);
-  glFormat.setOption(QSurfaceFormat::DebugContext);
+  if (renderSettings.debugContext) {
+    glFormat.setOption(QSurfaceFormat::DebugContext);
+  }
 
   // Some platforms need to explicitly set the depth buffer size (24 bits)
   glFormat.setDepthBufferSize(24);
 
+  // Replays run as fast as they can, rather than at the display's refresh rate
+  if (!renderSettings.replayFile.isEmpty()) {
+    glFormat.setSwapInterval(0);
+  }
+
   QSurfaceFormat::setDefaultFormat(glFormat);
 
   MainWindow w;
@@ -1,8 +1,13 @@
 #include "mainview.h"
+#include <QCoreApplication>
 #include <QDateTime>
+#include <QPainter>
 #include <algorithm>
 
 #include "model.h"
+#include "scenefile.h"
+#include "shadersource.h"
+#include "vectormath.h"
 
 MainView::MainView(QWidget *parent) : QOpenGLWidget(parent) {
     qDebug() << "MainView constructor";
@@ -11,14 +16,39 @@ MainView::MainView(QWidget *parent) : QOpenGLWidget(parent) {
 
     connect(&timer, SIGNAL(timeout()), this, SLOT(update()));
     timer.start(1000 / FPS);
+
+    connect(this, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
 }
 
 MainView::~MainView() {
   qDebug() << "MainView destructor";
 
+  simulation.stop();
+  if (!simulation.getRecording().isEmpty()) {
+    simulation.getRecording().save(RenderSettings::current().recordFile);
+  }
+
   makeCurrent();
 
+  profiler.destroy();
+  destroyRenderTargets();
+  impostorAtlas.destroy();
   destroyModelBuffers();
+  worldStreamer.releaseAll([this](World &world) { releaseWorld(world); });
+}
+
+Scene MainView::loadScene() {
+  return SceneFile::loadOrBuiltIn(RenderSettings::current().sceneFile);
+}
+
+WorldStreamer::Settings MainView::worldStreamerSettings() {
+  RenderSettings const &settings = RenderSettings::current();
+  WorldStreamer::Settings streamerSettings;
+  streamerSettings.memoryBudget = settings.worldBudget;
+  streamerSettings.loadDistance = settings.worldLoadDistance;
+  // So a world that has just loaded is not evicted again right away
+  streamerSettings.evictDistance = std::max(settings.worldEvictDistance, settings.worldLoadDistance);
+  return streamerSettings;
 }
 
 // --- OpenGL initialization
@@ -27,17 +57,39 @@ void MainView::initializeGL() {
   qDebug() << ":: Initializing OpenGL";
   initializeOpenGLFunctions();
 
-  connect(&debugLogger, SIGNAL(messageLogged(QOpenGLDebugMessage)), this,
-          SLOT(onMessageLogged(QOpenGLDebugMessage)), Qt::DirectConnection);
-
-  if (debugLogger.initialize()) {
-    qDebug() << ":: Logging initialized";
-    debugLogger.startLogging(QOpenGLDebugLogger::SynchronousLogging);
+  RenderSettings const &settings = RenderSettings::current();
+
+  if (settings.logging) {
+    connect(&debugLogger, SIGNAL(messageLogged(QOpenGLDebugMessage)), this,
+            SLOT(onMessageLogged(QOpenGLDebugMessage)), Qt::DirectConnection);
+
+    if (debugLogger.initialize()) {
+      qDebug() << ":: Logging initialized";
+      debugLogger.startLogging(settings.synchronousLogging
+                                   ? QOpenGLDebugLogger::SynchronousLogging
+                                   : QOpenGLDebugLogger::AsynchronousLogging);
+
+      // Have the driver drop the messages below the minimum severity
+      QOpenGLDebugMessage::Severities ignored{};
+      for (auto severity : {QOpenGLDebugMessage::MediumSeverity, QOpenGLDebugMessage::LowSeverity,
+                            QOpenGLDebugMessage::NotificationSeverity}) {
+        if (severity > settings.minimumSeverity) {
+          ignored |= severity;
+        }
+      }
+      debugLogger.disableMessages(QOpenGLDebugMessage::AnySource, QOpenGLDebugMessage::AnyType, ignored);
+    }
   }
 
   QString glVersion{reinterpret_cast<const char *>(glGetString(GL_VERSION))};
   qDebug() << ":: Using OpenGL" << qPrintable(glVersion);
 
+  profiler.initialize(this);
+  profiler.setEnabled(settings.profiler);
+
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+  objectUniforms.initialize(context(), this);
+
   // Enable depth buffer
   glEnable(GL_DEPTH_TEST);
 
@@ -53,28 +105,72 @@ void MainView::initializeGL() {
 
   createShaderProgram(shaders[ShaderType::PHONG], ":/shaders/vertshader.glsl", ":/shaders/fragshader.glsl");
   createShaderProgram(shaders[ShaderType::NORMAL], ":/shaders/normalvertshader.glsl", ":/shaders/normalfragshader.glsl");
-  createShaderProgram(shaders[ShaderType::PORTAL], ":/shaders/vertshader.glsl", ":/shaders/portalfragshader.glsl");
-  for (auto &to : currentScene.texturedObjects) {
-      loadIntoSceneObject(":/models/cat.obj", to, ":/textures/cat_diff.png");
+  createShaderProgram(shaders[ShaderType::PORTAL], ":/shaders/portalvertshader.glsl", ":/shaders/portalfragshader.glsl");
+  createShaderProgram(shaders[ShaderType::BOUNDS], ":/shaders/vertshader.glsl", ":/shaders/boundsfragshader.glsl");
+  createShaderProgram(shaders[ShaderType::UPSCALE], ":/shaders/screenvertshader.glsl", ":/shaders/upscalefragshader.glsl");
+  createShaderProgram(shaders[ShaderType::PORTAL_COMPOSITE], ":/shaders/screenvertshader.glsl", ":/shaders/compositefragshader.glsl");
+  createShaderProgram(batchShaders[ShaderType::PHONG], ":/shaders/batchvertshader.glsl", ":/shaders/fragshader.glsl");
+  createShaderProgram(batchShaders[ShaderType::NORMAL], ":/shaders/batchvertshader.glsl", ":/shaders/normalfragshader.glsl");
+
+  DynamicResolution::Settings resolutionSettings;
+  resolutionSettings.frameBudget = settings.frameBudget;
+  dynamicResolution.initialize(this, resolutionSettings);
+  frameTarget.initialize(this);
+  portalTarget.initialize(this);
+  glGenVertexArrays(1, &screenVao);
+
+  ImpostorAtlas::Settings impostorSettings;
+  impostorSettings.fullPortals = settings.fullPortals;
+  impostorSettings.refreshesPerFrame = settings.impostorRefreshes;
+  impostorAtlas.initialize(this, impostorSettings);
+
+  views = settings.stereoEyeDistance > 0 ? MultiView::stereo(settings.stereoEyeDistance)
+                                         : MultiView::surround(settings.viewCount);
+  if (views.count() > 1) {
+    qDebug() << ":: Rendering" << views.count() << "views in one pass";
   }
 
-  for (auto &po : currentScene.portalObjects) {
-      loadIntoSceneObject(":/models/portal.obj", po);
+  // Before any mesh is loaded, so their VAOs get the draw ids
+  if (settings.indirectDraws && indirectDraws.initialize(context(), views.count())) {
+    createShaderProgram(indirectShaders[ShaderType::PHONG], ":/shaders/indirectvertshader.glsl", ":/shaders/fragshader.glsl");
+    createShaderProgram(indirectShaders[ShaderType::NORMAL], ":/shaders/indirectvertshader.glsl", ":/shaders/normalfragshader.glsl");
   }
 
-  // Initialize transformations
-  updateProjectionTransform();
+  TextureStreamer::Settings textureSettings;
+  textureSettings.memoryBudget = settings.textureBudget;
+  textureStreamer.initialize(this, textureSettings);
 
-  for (auto &to : currentScene.texturedObjects) {
-      updateModelTransforms(to);
+  // All objects of the scene share one mesh, as do all portals
+  loadIntoRenderHandle(currentScene.objectMesh, objectMesh, currentScene.objectTexture);
+  loadIntoRenderHandle(currentScene.portalMesh, portalMesh);
+  createBoundsMesh();
+
+  for (auto &rh : currentScene.texturedObjects.renderHandles) {
+      rh = objectMesh;
   }
+  currentScene.texturedObjects.cells.build(currentScene.texturedObjects);
 
-  for (auto &po : currentScene.portalObjects) {
-      updateModelTransforms(po);
+  for (auto &rh : currentScene.portalObjects.renderHandles) {
+      rh = portalMesh;
   }
 
-  // Initialize current world transform
-  currentWorldEffectTransform.setToIdentity();
+  // Initialize transformations
+  updateProjectionTransform();
+
+  updateModelTransforms(currentScene.texturedObjects);
+  updateModelTransforms(currentScene.portalObjects);
+
+  checkGLErrors("initializeGL", RenderSettings::GL_ERROR_CHECKS::PER_FRAME);
+
+  if (!settings.replayFile.isEmpty() && replay.load(settings.replayFile)) {
+    // One tick per frame, as fast as the frames go, profiled for the summary
+    timer.setInterval(0);
+    profiler.setEnabled(true);
+    replayTimer.start();
+  } else {
+    simulation.setRecording(!settings.recordFile.isEmpty());
+    simulation.start();
+  }
 }
 
 void MainView::createShaderProgram(
@@ -83,49 +179,206 @@ void MainView::createShaderProgram(
     QString const &objectFragShaderFile
     ) {
   // Create shader program
-  shader.addShaderFromSourceFile(QOpenGLShader::Vertex, vertShaderFile);
-  shader.addShaderFromSourceFile(QOpenGLShader::Fragment, objectFragShaderFile);
+  shader.addShaderFromSourceCode(QOpenGLShader::Vertex, ShaderSource::load(vertShaderFile));
+  shader.addShaderFromSourceCode(QOpenGLShader::Fragment, ShaderSource::load(objectFragShaderFile));
   shader.link();
+
+  // GL 3.3 cannot set the binding in the shader
+  GLuint block = glGetUniformBlockIndex(shader.programId(), "ObjectUniforms");
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(shader.programId(), block, ObjectUniforms::BINDING);
+  }
+  block = glGetUniformBlockIndex(shader.programId(), "WorldEffect");
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(shader.programId(), block, EffectUniforms::BINDING);
+  }
 }
 
 // --- OpenGL drawing
 
-void MainView::paintScene() {
-    QOpenGLShaderProgram &shaderProgram = shaders[currentShaderType];
-    shaderProgram.bind();
+void MainView::buildDrawLists() {
+    Profiler::CpuZone zone{profiler, "buildDrawLists"};
+    PortalTable &portals = currentScene.portalObjects;
 
-    // Scene constants
-    shaderProgram.setUniformValue("materialColor", QVector3D{1, 1, 1});
-    shaderProgram.setUniformValue("ka", 0.4F);
-    shaderProgram.setUniformValue("kd", 0.4F);
-    shaderProgram.setUniformValue("ks", 0.4F);
-    shaderProgram.setUniformValue("p", 8);
-    shaderProgram.setUniformValue("lightCoordinates", QVector3D{100, 50, 0});
-    shaderProgram.setUniformValue("lightColor", QVector3D{1, 1, 1});
+    portalDrawLists.resize(portals.size());
 
-    // Transformation Constants
+    QMatrix4x4 cameraTransform = camera.getModelTransform();
+    QVector3D cameraOffset = cameraTransform.column(3).toVector3D();
+    impostorAtlas.beginFrame(portals, views, cameraOffset);
 
-    for (auto &to : currentScene.texturedObjects) {
-        QMatrix4x4 meshWithNoEffectTransform = to.modelTransform * currentWorldEffectTransform;
-        shaderProgram.setUniformValue("projectionTransform", projectionTransform);
-        shaderProgram.setUniformValue("modelViewTransform", meshWithNoEffectTransform);
-        shaderProgram.setUniformValue("normalMatrix", meshWithNoEffectTransform.normalMatrix());
+    // Only the portals drawn in full take a stencil value, so a scene with
+    // hundreds of portals stays within its 8 bits
+    portalStencils.assign(portals.size(), 0);
+    int stencilVal = 1;
+    for (size_t portal = 0; portal < portals.size(); ++portal) {
+        if (impostorAtlas.getMode(portal) == ImpostorAtlas::MODE::FULL) {
+            portalStencils[portal] = stencilVal++;
+        }
+    }
 
-        shaderProgram.setUniformValue("sampler", 0);
+    // What every pass draws. Index portals.size() is the scene itself.
+    // The effects are resolved to the time of the frame here, once per pass.
+    // A portal world only shows where the portal is on screen, so the views
+    // of its pass are narrowed to that. An impostor is only drawn when it is
+    // refreshed, through the view of its tile.
+    struct PassSource {
+        ObjectTable *objects;
+        WorldEffect effect;
+        ShaderType shaderType;
+        MultiView views;
+    };
+    FrameVector<PassSource> sources(portals.size() + 1);
+    for (size_t pass = 0; pass < portals.size(); ++pass) {
+        // If we are in a portal world, make sure to set portal door to render the default world instead
+        PortalEffect const &effect = portals.effects[pass];
+        WorldEffect portalEffect = inPortal ? WorldEffect{} : effect.worldEffect.at(effectTime);
+        RenderHandle const &rh = portals.renderHandles[pass];
+        QMatrix4x4 const &modelTransform = portals.modelTransforms[pass];
+        sources[pass] = {getWorldObjects(inPortal ? -1 : effect.worldId), portalEffect,
+                         inPortal ? ShaderType::PHONG : effect.shaderType,
+                         views.narrowedTo(modelTransform.map(rh.boundsCenter),
+                                          rh.boundsRadius * VectorMath::maxScale(modelTransform))};
+
+        switch (impostorAtlas.getMode(pass)) {
+        case ImpostorAtlas::MODE::FULL:
+            break;
+        case ImpostorAtlas::MODE::IMPOSTOR:
+        case ImpostorAtlas::MODE::HIDDEN:
+            sources[pass].objects = nullptr;
+            break;
+        case ImpostorAtlas::MODE::REFRESH:
+            sources[pass].views = impostorAtlas.getTileViews(pass);
+            break;
+        }
+    }
+    // The world we are in may still be being uploaded
+    sources[portals.size()] = {getWorldObjects(currentWorldId), currentWorldEffect.at(effectTime), currentShaderType,
+                               views};
+
+    auto isRefresh = [&](size_t pass) {
+        return pass < portals.size() && impostorAtlas.getMode(pass) == ImpostorAtlas::MODE::REFRESH;
+    };
+
+    // A world seen through a portal shows no larger than the portal, or its impostor's tile, does
+    float screenPixels = static_cast<float>(std::max(width() / views.count(), height())) *
+                         dynamicResolution.getSceneScale();
+    for (size_t pass = 0; pass < sources.size(); ++pass) {
+        if (sources[pass].objects == nullptr) continue;
+
+        float maxPixels = screenPixels;
+        if (isRefresh(pass)) {
+            maxPixels = static_cast<float>(impostorAtlas.getTileSize());
+        } else if (pass < portals.size()) {
+            maxPixels = 2 * portalMesh.boundsRadius * VectorMath::maxScale(portals.modelTransforms[pass]) *
+                        focalPixels() / std::max(portals.collisions[pass].cameraDistance, NEAR_PLANE) *
+                        dynamicResolution.getPortalScale(pass);
+        }
+        requestTextureLevels(*sources[pass].objects, sources[pass].effect, sources[pass].views, cameraOffset,
+                             maxPixels);
+    }
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, to.texture);
+    // The scene draws where the stencil is 0, a portal drawn in full where it
+    // is the portal's stencil value of the frame the Hi-Z buffer is from
+    auto drawListOf = [&](size_t pass) -> DrawList & {
+        return pass == portals.size() ? sceneDrawList : portalDrawLists[pass];
+    };
+    auto hiZPassOf = [&](size_t pass) {
+        if (pass == portals.size()) return 0;
+        return pass < hiZPortalPasses.size() ? hiZPortalPasses[pass] : -1;
+    };
+    auto indirectPassOf = [&](size_t pass) {
+        return pass == portals.size() ? 0 : static_cast<int>(pass) + 1;
+    };
+    auto isIndirect = [&](PassSource const &source) {
+        return indirectDraws.isAvailable() && indirectDraws.supports(*source.objects);
+    };
+
+    // Room for the uniforms of every object of the CPU passes and of their
+    // occlusion proxies, of every draw of a portal (its stencil and border,
+    // plus a second stencil when its world is drawn at a lower resolution,
+    // see paintPortalWorld), and for the effect of every pass plus the
+    // identity one the portals and proxies are drawn under
+    size_t portalDraws = dynamicResolution.isEnabled() ? 3 : 2;
+    size_t uniformsCount = portalDraws * portals.size() + sources.size() + 1;
+    for (PassSource const &source : sources) {
+        if (source.objects != nullptr && !isIndirect(source)) {
+            uniformsCount += 2 * source.objects->size();
+        }
+    }
+    size_t uniformsSize = (sizeof(ObjectUniforms) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    objectUniforms.beginFrame(uniformsCount * uniformsSize);
+
+    auto writeEffectUniforms = [&](WorldEffect const &effect) {
+        StreamBuffer::Allocation allocation = objectUniforms.allocate(sizeof(EffectUniforms), uniformAlignment);
+        if (allocation.data != nullptr) {
+            EffectUniforms::write(allocation.data, effect);
+        }
+        return allocation.offset;
+    };
+    for (size_t pass = 0; pass < sources.size(); ++pass) {
+        drawListOf(pass).effectUniformsOffset = writeEffectUniforms(sources[pass].effect);
+    }
+    identityEffectOffset = writeEffectUniforms(WorldEffect{});
+
+    // Every pass only reads the scene, so all of them are built in parallel
+    jobSystem.parallelFor(portals.size() + 1, 1, [&](size_t begin, size_t end) {
+        for (size_t pass = begin; pass < end; ++pass) {
+            PassSource const &source = sources[pass];
+            DrawList &drawList = drawListOf(pass);
+            if (source.objects == nullptr || isIndirect(source)) {
+                drawList.clear();
+                continue;
+            }
+            // An impostor is not in the frame the pyramids are built from
+            int hiZPass = isRefresh(pass) ? -1 : hiZPassOf(pass);
+            drawList.build(*source.objects, source.effect, source.views, cameraOffset, source.shaderType,
+                           hiZBuffer, hiZPass,
+                           objectUniforms, uniformAlignment);
+        }
+    });
+    objectUniforms.flush();
+
+    if (!indirectDraws.isAvailable()) {
+        return;
+    }
 
-        glBindVertexArray(to.vao);
-        glDrawArrays(GL_TRIANGLES, 0, to.size);
+    // GL calls, so on this thread. Only a dispatch per pass, whatever the number of objects.
+    for (size_t pass = 0; pass < sources.size(); ++pass) {
+        PassSource const &source = sources[pass];
+        DrawList &drawList = drawListOf(pass);
+        bool indirect = source.objects != nullptr && isIndirect(source);
+        // The culling bounds the objects under the effect of the pass
+        bindEffectUniforms(drawList.effectUniformsOffset);
+        indirectDraws.cull(indirectPassOf(pass), indirect ? source.objects : nullptr, cameraTransform,
+                           source.views);
+
+        drawList.indirect = indirect;
+        drawList.shaderType = source.shaderType;
     }
+    indirectDraws.finishCulling();
+}
 
-    shaderProgram.release();
+void MainView::paintScene() {
+    Profiler::Zone zone{profiler, "paintScene"};
+    paintDrawList(sceneDrawList, 0);
 }
 
 
 void MainView::paintGL() {
+  // Process-wide, so it takes in what the other threads allocate meanwhile
+  uint64_t heapAllocations = FrameArena::heapAllocations();
+  profiler.beginFrame();
+
   updateCameraPosition();
+  updateHiZBuffer();
+  buildDrawLists();
+  updateTextureStreaming();
+
+  PortalTable &portals = currentScene.portalObjects;
+  // After the CPU work above, which the GPU time is not to include
+  dynamicResolution.beginFrame(portals.size());
+  refreshImpostors();
+  bindFrameTarget();
 
   // Clear the screen before rendering
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -134,43 +387,165 @@ void MainView::paintGL() {
   glEnable(GL_STENCIL_TEST);
   // Set stencil buffer to all 0s
   glClear(GL_STENCIL_BUFFER_BIT);
-
-  int stencilVal = 1;
-
-  for (auto &po : currentScene.portalObjects) {
-      setPortalStencil(po, stencilVal);
-      for (auto &to : currentScene.texturedObjects) {
-          glStencilFunc(GL_EQUAL, stencilVal, 0xFF);
-          paintMeshWithPortalEffectAtStencil(to, po);
+  setViewClipping(true);
+
+  for (size_t portal = 0; portal < portals.size(); ++portal) {
+      ImpostorAtlas::MODE mode = impostorAtlas.getMode(portal);
+      if (mode != ImpostorAtlas::MODE::FULL) {
+          // A single quad with the image of the world, instead of a stencil and a pass
+          glStencilFunc(GL_EQUAL, 0, 0xFF);
+          if (mode != ImpostorAtlas::MODE::HIDDEN) {
+              paintPortal(portal, false, true);
+          }
+          paintPortal(portal, true);
+          continue;
+      }
+      dynamicResolution.beginPortal(portal);
+      {
+          Profiler::Zone zone{profiler, "portal world", static_cast<int>(portal)};
+          paintPortalWorld(portal, portalStencils[portal]);
       }
+      dynamicResolution.endPortal(portal);
+      checkGLErrors("portal world", RenderSettings::GL_ERROR_CHECKS::PER_PASS);
       // Only draw where stencil buffer is 0
       glStencilFunc(GL_EQUAL, 0, 0xFF);
-      paintPortal(po, true);
-      ++stencilVal;
+      paintPortal(portal, true);
   }
 
   paintScene();
+  checkGLErrors("paintScene", RenderSettings::GL_ERROR_CHECKS::PER_PASS);
 
+  setViewClipping(false);
   glDisable(GL_STENCIL_TEST);
+
+  // Depth and stencil of this frame are what the next one culls against
+  readBackDepth();
+  upscaleFrame();
+
+  // The overlay allocates for its text, so it is left out
+  frameHeapAllocations = FrameArena::heapAllocations() - heapAllocations;
+  FrameArena::endFrame();
+
+  if (showProfilerOverlay) {
+      paintProfilerOverlay();
+  }
+
+  checkGLErrors("paintGL", RenderSettings::GL_ERROR_CHECKS::PER_FRAME);
+
+  dynamicResolution.endFrame();
+  objectUniforms.endFrame();
+  profiler.endFrame();
+
+  if (!replay.isEmpty() && replayedTicks == replay.size()) {
+      finishReplay();
+  }
+}
+
+void MainView::finishReplay() {
+  double seconds = replayTimer.nsecsElapsed() / 1e9;
+  qDebug() << ":: Replayed" << replayedTicks << "frames in" << seconds << "s,"
+           << replayedTicks / seconds << "frames per second";
+  if (divergedTicks > 0) {
+      qWarning() << divergedTicks << "ticks of the replay did not move as recorded, the camera followed the recording";
+  }
+  for (auto const &zone : profiler.getStatistics()) {
+      qDebug().noquote() << QString("%1 p50 %2 p95 %3 p99 %4 ms")
+                                .arg(zone.name, -30)
+                                .arg(zone.p50, 7, 'f', 2)
+                                .arg(zone.p95, 7, 'f', 2)
+                                .arg(zone.p99, 7, 'f', 2);
+  }
+
+  replay.clear();
+  QCoreApplication::quit();
+}
+
+void MainView::paintProfilerOverlay() {
+  {
+      QPainter painter(this);
+      profiler.setHeapAllocations(frameHeapAllocations);
+      profiler.paintOverlay(painter);
+  }
+
+  // QPainter leaves its own state behind
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_CULL_FACE);
+  glDepthFunc(GL_LEQUAL);
 }
 
 void MainView::resizeGL(int newWidth, int newHeight) {
   Q_UNUSED(newWidth)
   Q_UNUSED(newHeight)
   updateProjectionTransform();
+
+  // The pyramids no longer match the framebuffer
+  hiZBuffer.invalidate();
 }
 
 void MainView::updateCameraPosition() {
-    camera.update(keyboardStatus);
+    Profiler::CpuZone zone{profiler, "updateCameraPosition"};
+
+    // Replays run a tick per frame, so every run draws the same frames
+    bool replaying = replayedTicks < replay.size();
+    if (replaying && !simulation.replayTick(replay, replayedTicks++)) {
+        ++divergedTicks;
+    }
+
+    // Taken first, so the snapshot has applied all of them
+    simulation.takeAppliedInputs(pendingInputs);
+    RenderSnapshot const &snapshot = simulation.latestSnapshot();
+
+    float ticksSince = std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot.tickTime)
+                       / std::chrono::duration<float>(Simulation::tickDuration());
+    // The time in the simulation the camera of this frame is at, and the same
+    // in ticks, which the world effects animate by so replays repeat them
+    std::chrono::steady_clock::time_point shownTime;
+    double shownTick = static_cast<double>(snapshot.tick);
+    if (replaying) {
+        camera.setPose(snapshot.camera);
+        shownTime = snapshot.tickTime;
+    } else if (RenderSettings::current().predictCamera) {
+        // Carry the last tick on with the actions still held, which is exact
+        // until the next input event
+        float ahead = std::clamp(ticksSince, 0.0F, 2.0F);
+        camera.setPose(snapshot.camera);
+        camera.update(snapshot.actions, ahead);
+        shownTime = snapshot.tickTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                            ahead * std::chrono::duration<float>(Simulation::tickDuration()));
+        shownTick += ahead;
+    } else {
+        // Render in between the last two ticks, based on how long ago the last one was
+        float alpha = std::clamp(ticksSince, 0.0F, 1.0F);
+        camera.setPose(Camera::Pose::interpolate(snapshot.previousCamera, snapshot.camera, alpha));
+        shownTime = snapshot.previousTickTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                    alpha * (snapshot.tickTime - snapshot.previousTickTime));
+        shownTick += alpha - 1;
+    }
+    effectTime = static_cast<float>(shownTick * std::chrono::duration<double>(Simulation::tickDuration()).count());
 
-    for (auto &po : currentScene.portalObjects) {
-        updatePortalEffectTransforms(po);
-        updateModelTransforms(po);
+    // The inputs this frame shows, measured once it is presented
+    auto shown = std::stable_partition(pendingInputs.begin(), pendingInputs.end(),
+                                       [&](auto const &time) { return time > shownTime; });
+    presentedInputs.insert(presentedInputs.end(), shown, pendingInputs.end());
+    pendingInputs.erase(shown, pendingInputs.end());
+
+    if (snapshot.inPortal != inPortal) {
+        // The portals lead elsewhere now
+        impostorAtlas.invalidate();
     }
+    inPortal = snapshot.inPortal;
+    currentWorldId = snapshot.currentWorldId;
+    currentWorldEffect = snapshot.currentWorldEffect;
+    currentShaderType = snapshot.currentShaderType;
+    currentScene.portalObjects.collisions = snapshot.portalCollisions;
+
+    updateModelTransforms(currentScene.portalObjects);
+    updateModelTransforms(currentScene.texturedObjects);
 
+    updateWorldStreaming();
 
-    for (auto &to : currentScene.texturedObjects) {
-        updateModelTransforms(to);
+    for (auto &pair : worldStreamer.getResidentWorlds()) {
+        updateModelTransforms(pair.second.texturedObjects);
     }
 
     updateProjectionTransform();
@@ -179,24 +554,38 @@ void MainView::updateCameraPosition() {
 void MainView::updateProjectionTransform() {
   float aspectRatio =
       static_cast<float>(width()) / static_cast<float>(height());
-  projectionTransform.setToIdentity();
-  projectionTransform.perspective(60.0F, aspectRatio, 0.2F, 40.0F);
-
-  projectionTransform = projectionTransform * camera.getProjectionTransform();
+  views.update(camera.getProjectionTransform(), FIELD_OF_VIEW, aspectRatio, NEAR_PLANE, 40.0F);
 }
 
 void MainView::destroyModelBuffers() {
-    for (auto &to : currentScene.texturedObjects) {
-        cleanUpSceneObject(to);
-        glDeleteTextures(1, &to.texture);
-    }
+    indirectDraws.destroy();
+    objectUniforms.destroy();
 
-    for (auto &po : currentScene.portalObjects) {
-        cleanUpSceneObject(po);
+    cleanUpRenderHandle(objectMesh);
+    for (GLuint page : sceneMaterialPages) {
+        textureStreamer.releasePage(page);
     }
+    sceneMaterialPages.clear();
+
+    cleanUpRenderHandle(portalMesh);
+    textureStreamer.destroy();
+
+    destroyOcclusionCulling();
 
 }
 
 void MainView::onMessageLogged(QOpenGLDebugMessage Message) {
   qDebug() << " → Log:" << Message;
 }
+
+/**
+ * @brief MainView::onFrameSwapped Triggered once a frame has been handed to
+ * the window system, which is as close to the display as GL lets us see.
+ */
+void MainView::onFrameSwapped() {
+  auto presented = std::chrono::steady_clock::now();
+  for (auto const &time : presentedInputs) {
+      profiler.recordLatency("input to present", time, presented);
+  }
+  presentedInputs.clear();
+}
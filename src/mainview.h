@@ -1,6 +1,7 @@
 #ifndef MAINVIEW_H
 #define MAINVIEW_H
 
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QMatrix4x4>
 #include <QMouseEvent>
@@ -11,12 +12,30 @@
 #include <QTimer>
 #include <QVector3D>
 
+#include <array>
+#include <chrono>
+
 #include "keyboardstatus.h"
 #include "camera.h"
-#include "sceneobject.h"
-#include "texturedobject.h"
-#include "portalobject.h"
+#include "inputrecording.h"
+#include "scenestore.h"
 #include "scene.h"
+#include "staticbatch.h"
+#include "worldstreamer.h"
+#include "simulation.h"
+#include "jobsystem.h"
+#include "multiview.h"
+#include "drawlist.h"
+#include "dynamicresolution.h"
+#include "framearena.h"
+#include "hizbuffer.h"
+#include "impostoratlas.h"
+#include "indirectdraws.h"
+#include "profiler.h"
+#include "streambuffer.h"
+#include "texturestreamer.h"
+#include "renderprofile.h"
+#include "rendertarget.h"
 #include "ShaderType.h"
 
 /**
@@ -28,6 +47,9 @@ class MainView : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
 
     // The FPS to run at
     int const FPS =  60;
+    // Vertical, in degrees
+    static constexpr float FIELD_OF_VIEW = 60.0F;
+    static constexpr float NEAR_PLANE = 0.2F;
 
 public:
     MainView(QWidget *parent = nullptr);
@@ -47,50 +69,190 @@ protected:
 
 private slots:
     void onMessageLogged(QOpenGLDebugMessage Message);
+    void onFrameSwapped();
 
 private:
-    void generateTexture(QString const &fileName, TexturedObject &tso);
+    TextureData loadTexture(QString const &fileName);
+    std::vector<Material> generateMaterials(std::vector<TextureData> const &textures, std::vector<GLuint> &pages);
     void createShaderProgram(
         QOpenGLShaderProgram &shader,
         QString const &verShaderFile,
         QString const &objectFragShaderFile
         );
-    void loadIntoSceneObject(QString const &fileName, SceneObject &so);
-    void loadIntoSceneObject(
-        QString const &fileName, TexturedObject &tso, QString const &textureName);
+    void loadIntoRenderHandle(QString const &fileName, RenderHandle &rh);
+    void loadIntoRenderHandle(MeshData const &mesh, RenderHandle &rh);
+    void loadIntoRenderHandle(PreparedMesh const &mesh, RenderHandle &rh);
+    void setVertexAttributes();
+    void loadIntoRenderHandle(
+        QString const &fileName, RenderHandle &rh, QString const &textureName);
     void loadMesh(const QString &filename);
-    void cleanUpSceneObject(SceneObject &so);
+    void cleanUpRenderHandle(RenderHandle &rh);
     void destroyModelBuffers();
     void updateCameraPosition();
     void updateProjectionTransform();
-    void updateModelTransforms(SceneObject &so);
+    void updateModelTransforms(ObjectTable &objects);
     void loadPortal(const QString &filename);
-    void paintPortal(PortalObject &po, bool renderBorder);
-    void setPortalStencil(PortalObject &po, int stencilVal);
+    void paintPortal(size_t portal, bool renderBorder, bool drawImpostor = false);
+    void setPortalStencil(size_t portal, int stencilVal);
     void paintScene();
-    void paintMeshWithPortalEffectAtStencil(TexturedObject &to, PortalObject &po);
-    void updatePortalEffectTransforms(PortalObject &po);
-    PortalObject::COLLISION_STATE getPortalCollision(PortalObject &po);
+    void bindFrameTarget();
+    void paintPortalWorld(size_t portal, int stencilVal);
+    void upscaleFrame();
+    void destroyRenderTargets();
+    void refreshImpostors();
+    void buildDrawLists();
+    void paintDrawList(DrawList const &drawList, int pass);
+    void paintIndirect(int pass, ShaderType shaderType);
+    void paintBatches(DrawList const &drawList);
+    void uploadStaticBatches(StaticBatcher const &batcher, ObjectTable &objects);
+    void releaseStaticBatches(ObjectTable &objects);
+    void setShadingUniforms(QOpenGLShaderProgram &shaderProgram);
+    void setViewUniforms(QOpenGLShaderProgram &shaderProgram);
+    void setViewClipping(bool enabled);
+    void bindObjectUniforms(GLintptr offset);
+    void bindEffectUniforms(GLintptr offset);
+    void createBoundsMesh();
+    void readBackDepth();
+    void updateHiZBuffer();
+    void queryOcclusion(std::vector<DrawItem> const &items);
+    void destroyOcclusionCulling();
+    void paintProfilerOverlay();
+    void checkGLErrors(char const *where, RenderSettings::GL_ERROR_CHECKS granularity);
+    void updateWorldStreaming();
+    World uploadWorld(WorldData &data);
+    void requestTextureLevels(ObjectTable const &objects, WorldEffect const &effect,
+                              MultiView const &views, QVector3D const &cameraOffset, float maxPixels);
+    void updateTextureStreaming();
+    float focalPixels() const;
+    void releaseWorld(World &world);
+    ObjectTable *getWorldObjects(int worldId);
 
-    QVector<quint8> imageToBytes(const QImage &image);
+    static Scene loadScene();
+    // Of the --world-budget and distance arguments
+    static WorldStreamer::Settings worldStreamerSettings();
+    // Logs how the replay ran and quits
+    void finishReplay();
 
     QOpenGLDebugLogger debugLogger;
     QTimer timer;  // timer used for animation
 
     std::unordered_map<ShaderType, QOpenGLShaderProgram> shaders;
 
-    // User Input
-    KeyboardStatus keyboardStatus;
+    // The camera interpolated between the last two simulation ticks, or
+    // predicted from the last one with --predict-camera
     Camera camera;
-    QMatrix4x4 projectionTransform;
+    // What the frame is rendered from, in one pass: the camera, or views
+    // placed relative to it with --views or --stereo
+    MultiView views;
+
+    // Spreads the per-frame CPU work over all cores. MANY_WORLDS_THREADS
+    // overrides the number of threads, to measure scaling.
+    JobSystem jobSystem{static_cast<unsigned>(qEnvironmentVariableIntValue("MANY_WORLDS_THREADS"))};
+
+    // The draws of every portal world, and of the scene itself, for this frame
+    std::vector<DrawList> portalDrawLists;
+    DrawList sceneDrawList;
+    // The stencil value every portal's world is drawn at this frame, numbered
+    // over the portals drawn in full only, and 0 for the others
+    std::vector<int> portalStencils;
+
+    // The GL 4.3 path, with its own programs for the world shader types. The
+    // passes are numbered as for the draw lists: 0 is the scene, portal p is p + 1.
+    IndirectDraws indirectDraws;
+    std::unordered_map<ShaderType, QOpenGLShaderProgram> indirectShaders;
+
+    // Draw the static batches of the worlds on the GL 3.3 path, see staticbatching.cpp
+    std::unordered_map<ShaderType, QOpenGLShaderProgram> batchShaders;
+
+    // The ObjectUniforms of every draw on the GL 3.3 path, written anew each
+    // frame, at offsets that are multiples of uniformAlignment
+    StreamBuffer objectUniforms;
+    GLint uniformAlignment = 256;
+
+    // Occlusion culling against the depth of earlier frames, read back
+    // asynchronously through a pair of pixel buffers
+    struct DepthReadback {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint64_t frame = 0;
+        size_t capacity = 0;
+        int width = 0;
+        int height = 0;
+        // Of the window, as a readback from before a resize is of no use
+        int windowWidth = 0;
+        int windowHeight = 0;
+        int passCount = 0;
+        // The Hi-Z pass of every portal, its stencil value that frame, or -1
+        std::vector<int> portalPasses;
+    };
+    std::array<DepthReadback, 2> depthReadbacks;
+    uint64_t frameCount = 0;
+    HiZBuffer hiZBuffer;
+    // The portalPasses of the readback the Hi-Z buffer is built from
+    std::vector<int> hiZPortalPasses;
+
+    // A cube around the unit sphere, drawn for the occlusion queries
+    RenderHandle boundsMesh;
+    std::vector<GLuint> occlusionQueries;
+
+    // Scales the resolution of the frame, and of every portal world, to keep
+    // to the --frame-budget (see resolutionscaling.cpp). screenVao is the
+    // empty vertex array the full screen passes draw with.
+    DynamicResolution dynamicResolution;
+    RenderTarget frameTarget;
+    RenderTarget portalTarget;
+    GLuint screenVao = 0;
+    // The portals past the nearest --full-portals, drawn from images rather
+    // than in full (see portalimpostors.cpp)
+    ImpostorAtlas impostorAtlas;
+    // The pixels the scene renders at this frame
+    int renderWidth = 0;
+    int renderHeight = 0;
+
+    // F1 toggles the overlay, F2 exports a trace
+    Profiler profiler;
+    bool showProfilerOverlay = false;
+    // Heap allocations of the last frame, 0 once the frames are steady. Of the
+    // whole process, so allocations of the simulation, the loader and the
+    // streamers that happen to fall within the frame count as well.
+    uint64_t frameHeapAllocations = 0;
+    // Times of the input events applied by the simulation that no frame has
+    // shown yet, and of those the frame being presented shows
+    std::vector<std::chrono::steady_clock::time_point> pendingInputs;
+    std::vector<std::chrono::steady_clock::time_point> presentedInputs;
+
+    // Scenes, loaded from the --scene file if there is one
+    Scene currentScene = loadScene();
+    WorldStreamer worldStreamer{currentScene.worlds, worldStreamerSettings()};
+
+    // The meshes shared by all objects / portals of the scene
+    RenderHandle objectMesh;
+    RenderHandle portalMesh;
+    std::vector<GLuint> sceneMaterialPages;
+
+    // Keeps the mip levels of all material pages that are seen, see requestTextureLevels
+    TextureStreamer textureStreamer;
+
+    // Runs input, camera movement and portal crossing
+    Simulation simulation{currentScene.portalObjects};
 
-    // Scenes
-    Scene currentScene = Scene::createScene3();
+    // The --replay recording, empty when the simulation runs on live input
+    InputRecording replay;
+    size_t replayedTicks = 0;
+    size_t divergedTicks = 0;
+    QElapsedTimer replayTimer;
 
+    // Copied from the latest simulation tick every frame
     bool inPortal = false;
+    // The world the camera is in, -1 if it is the scene itself
+    int currentWorldId = -1;
 
     // Rendering transformations
-    QMatrix4x4 currentWorldEffectTransform;
+    WorldEffect currentWorldEffect;
+    // The time the world effects are animated to this frame, in seconds of simulation
+    float effectTime = 0;
+    // An EffectUniforms block of no effect, for what is drawn outside of any world
+    GLintptr identityEffectOffset = 0;
     ShaderType currentShaderType = ShaderType::PHONG;
 
 };
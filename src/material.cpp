@@ -0,0 +1,34 @@
+#include "material.h"
+
+#include <algorithm>
+
+#include "world.h"
+
+std::vector<MaterialPageLayout> MaterialPacking::pack(std::vector<TextureData> const &textures, int maxLayers) {
+    std::vector<MaterialPageLayout> pages;
+    // The page of each size that still has room
+    std::vector<size_t> openPages;
+
+    for (size_t i = 0; i < textures.size(); ++i) {
+        TextureData const &texture = textures[i];
+
+        auto open = std::find_if(openPages.begin(), openPages.end(), [&](size_t page) {
+            return pages[page].width == texture.width && pages[page].height == texture.height;
+        });
+
+        if (open == openPages.end()) {
+            openPages.push_back(pages.size());
+            open = openPages.end() - 1;
+            pages.push_back({texture.width, texture.height, {}});
+        }
+
+        MaterialPageLayout &page = pages[*open];
+        page.textures.push_back(i);
+
+        if (static_cast<int>(page.textures.size()) >= maxLayers) {
+            openPages.erase(open);
+        }
+    }
+
+    return pages;
+}
@@ -0,0 +1,44 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <GL/gl.h>
+
+#include <cstddef>
+#include <vector>
+
+struct TextureData;
+
+/*
+ * Where the texture of an object lives: one layer of a GL_TEXTURE_2D_ARRAY
+ * page. Textures of the same size share a page, so objects with different
+ * textures are drawn without binding another texture in between, only the
+ * layer changes.
+ */
+struct Material
+{
+    GLuint page = 0;
+    GLint layer = 0;
+};
+
+/*
+ * The textures that go into one page, in layer order.
+ */
+struct MaterialPageLayout
+{
+    int width = 0;
+    int height = 0;
+    // Indices into the packed textures
+    std::vector<size_t> textures;
+};
+
+class MaterialPacking
+{
+public:
+    /*
+     * Groups the textures into pages of the same size, of at most maxLayers
+     * layers each. Textures keep their relative order within a page.
+     */
+    static std::vector<MaterialPageLayout> pack(std::vector<TextureData> const &textures, int maxLayers);
+};
+
+#endif // MATERIAL_H
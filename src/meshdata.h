@@ -0,0 +1,23 @@
+#ifndef MESHDATA_H
+#define MESHDATA_H
+
+#include <QString>
+#include <QVector>
+#include <QVector2D>
+#include <QVector3D>
+
+/*
+ * CPU-side data of a mesh, ready to be encoded for the GPU, see
+ * VertexEncoding. Unique vertices, with every three indices forming a
+ * triangle.
+ */
+struct MeshData
+{
+    QString fileName;
+    QVector<QVector3D> coords;
+    QVector<QVector3D> normals;
+    QVector<QVector2D> textureCoords;
+    QVector<unsigned> indices;
+};
+
+#endif // MESHDATA_H
@@ -0,0 +1,229 @@
+#include "meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "vectormath.h"
+
+namespace {
+
+// Unused triangles looked at for the nearest one, when a meshlet has no neighbours left to grow into
+constexpr size_t NEAREST_SEARCH = 512;
+
+// Meshlets smaller than this take in triangles that are not connected to them,
+// from small separate parts of the mesh. Larger ones stay connected, which
+// keeps their normals closer together.
+constexpr size_t MIN_TRIANGLES = 16;
+
+// Triangles only join a meshlet if their normal is within about 45 degrees of
+// its average one, so the normal cones stay narrow enough to cull with
+constexpr float MAX_NORMAL_SPREAD_DOT = 0.7F;
+
+// Triangle normals this close to perpendicular to the axis leave too little of a cone to cull with
+constexpr float MIN_CONE_DOT = 0.1F;
+
+// The triangles around every vertex, as offsets into one shared list
+struct Adjacency {
+    std::vector<unsigned> offsets;
+    std::vector<unsigned> triangles;
+};
+
+Adjacency buildAdjacency(size_t vertexCount, QVector<unsigned> const &indices) {
+    Adjacency adjacency;
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (unsigned index : indices) {
+        ++adjacency.offsets[index + 1];
+    }
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
+    }
+
+    adjacency.triangles.resize(indices.size());
+    std::vector<unsigned> filled(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < static_cast<size_t>(indices.size()); ++i) {
+        adjacency.triangles[filled[indices[i]]++] = static_cast<unsigned>(i / 3);
+    }
+    return adjacency;
+}
+
+void computeBounds(Meshlet &meshlet, QVector<QVector3D> const &coords, QVector<unsigned> const &indices) {
+    QVector<QVector3D> points;
+    points.reserve(meshlet.count);
+    QVector3D normalSum;
+    std::vector<QVector3D> normals;
+    normals.reserve(meshlet.count / 3);
+
+    for (GLuint i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.count; i += 3) {
+        QVector3D const &a = coords[indices[i]];
+        QVector3D const &b = coords[indices[i + 1]];
+        QVector3D const &c = coords[indices[i + 2]];
+        points.push_back(a);
+        points.push_back(b);
+        points.push_back(c);
+
+        QVector3D normal = QVector3D::crossProduct(b - a, c - a);
+        if (normal.lengthSquared() > 0) {
+            normal.normalize();
+            normals.push_back(normal);
+            normalSum += normal;
+        }
+    }
+
+    auto sphere = VectorMath::boundingSphere(points);
+    meshlet.center = sphere.first;
+    meshlet.radius = sphere.second;
+
+    meshlet.coneAxis = normalSum.normalized();
+    meshlet.coneCutoff = 1;
+    if (normals.empty() || normalSum.lengthSquared() == 0) {
+        return;
+    }
+
+    float minDot = 1;
+    for (auto const &normal : normals) {
+        minDot = std::min(minDot, QVector3D::dotProduct(normal, meshlet.coneAxis));
+    }
+    if (minDot >= MIN_CONE_DOT) {
+        // The sine of the spread of the normals around the axis
+        meshlet.coneCutoff = std::sqrt(1 - minDot * minDot);
+    }
+}
+
+}
+
+MeshletMesh Meshlets::build(QVector<QVector3D> const &coords, QVector<unsigned> const &indices) {
+    size_t triangleCount = indices.size() / 3;
+    Adjacency adjacency = buildAdjacency(coords.size(), indices);
+
+    MeshletMesh mesh;
+    mesh.indices.reserve(indices.size());
+
+    std::vector<bool> used(triangleCount, false);
+    // Unused triangles around every vertex. Vertices with few left are on
+    // the rim of what is used, taking their triangles first leaves no islands.
+    size_t vertexCount = coords.size();
+    std::vector<unsigned> liveTriangles(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; ++vertex) {
+        liveTriangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+    }
+    // The meshlet a vertex was last added to, to tell which vertices are new
+    std::vector<size_t> vertexMeshlet(coords.size(), std::numeric_limits<size_t>::max());
+    std::vector<unsigned> vertices;
+    vertices.reserve(MAX_VERTICES);
+
+    auto newVertices = [&](size_t triangle) {
+        size_t count = 0;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            count += vertexMeshlet[indices[3 * triangle + corner]] != mesh.meshlets.size() ? 1 : 0;
+        }
+        return count;
+    };
+    auto triangleCenter = [&](size_t triangle) {
+        return (coords[indices[3 * triangle]] + coords[indices[3 * triangle + 1]] +
+                coords[indices[3 * triangle + 2]]) / 3;
+    };
+    auto triangleNormal = [&](size_t triangle) {
+        QVector3D const &a = coords[indices[3 * triangle]];
+        return QVector3D::crossProduct(coords[indices[3 * triangle + 1]] - a,
+                                       coords[indices[3 * triangle + 2]] - a).normalized();
+    };
+    // What the current meshlet has grown to
+    struct {
+        size_t triangles = 0;
+        QVector3D centerSum;
+        QVector3D normalSum;
+    } current;
+    auto fits = [&](size_t triangle) {
+        if (vertices.size() + newVertices(triangle) > MAX_VERTICES) return false;
+        // Degenerate triangles face nowhere, so they fit any cone
+        QVector3D normal = triangleNormal(triangle);
+        QVector3D axis = current.normalSum.normalized();
+        return normal.lengthSquared() == 0 || axis.lengthSquared() == 0 ||
+               QVector3D::dotProduct(normal, axis) >= MAX_NORMAL_SPREAD_DOT;
+    };
+    auto add = [&](size_t triangle) {
+        used[triangle] = true;
+        ++current.triangles;
+        current.centerSum += triangleCenter(triangle);
+        current.normalSum += triangleNormal(triangle);
+        for (size_t corner = 0; corner < 3; ++corner) {
+            unsigned vertex = indices[3 * triangle + corner];
+            --liveTriangles[vertex];
+            if (vertexMeshlet[vertex] != mesh.meshlets.size()) {
+                vertexMeshlet[vertex] = mesh.meshlets.size();
+                vertices.push_back(vertex);
+            }
+            mesh.indices.push_back(vertex);
+        }
+    };
+
+    size_t seed = 0;
+    while (true) {
+        while (seed < triangleCount && used[seed]) {
+            ++seed;
+        }
+        if (seed == triangleCount) break;
+
+        Meshlet meshlet;
+        meshlet.firstIndex = static_cast<GLuint>(mesh.indices.size());
+        vertices.clear();
+        current = {};
+        add(seed);
+
+        while (current.triangles < MAX_TRIANGLES) {
+            // The unused neighbour that adds the fewest vertices and still fits,
+            // of those the one with the fewest unused neighbours itself
+            size_t best = triangleCount;
+            std::pair<size_t, unsigned> bestScore{4, 0};
+            for (unsigned vertex : vertices) {
+                for (unsigned a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a) {
+                    unsigned triangle = adjacency.triangles[a];
+                    if (used[triangle] || !fits(triangle)) continue;
+
+                    unsigned live = liveTriangles[indices[3 * triangle]] + liveTriangles[indices[3 * triangle + 1]] +
+                                    liveTriangles[indices[3 * triangle + 2]];
+                    std::pair<size_t, unsigned> score{newVertices(triangle), live};
+                    if (score < bestScore) {
+                        best = triangle;
+                        bestScore = score;
+                    }
+                }
+            }
+            if (best == triangleCount && current.triangles < MIN_TRIANGLES) {
+                // A separate part of the mesh, or a hole: continue with the nearest
+                // triangle that fits, among the next unused ones in mesh order
+                QVector3D center = current.centerSum / static_cast<float>(current.triangles);
+                float bestDistance = std::numeric_limits<float>::max();
+                size_t searched = 0;
+                for (size_t triangle = seed; triangle < triangleCount && searched < NEAREST_SEARCH; ++triangle) {
+                    if (used[triangle]) continue;
+                    ++searched;
+                    if (!fits(triangle)) continue;
+
+                    float distance = (triangleCenter(triangle) - center).lengthSquared();
+                    if (distance < bestDistance) {
+                        best = triangle;
+                        bestDistance = distance;
+                    }
+                }
+            }
+            if (best == triangleCount) break;
+
+            add(best);
+        }
+
+        meshlet.count = static_cast<GLuint>(mesh.indices.size()) - meshlet.firstIndex;
+        computeBounds(meshlet, coords, mesh.indices);
+        mesh.meshlets.push_back(meshlet);
+    }
+
+    return mesh;
+}
+
+bool Meshlets::isBackfacing(QVector3D const &center, float radius, QVector3D const &coneAxis, float coneCutoff) {
+    // The eye is far enough behind the cone that every point of the sphere
+    // sees every triangle from behind
+    return QVector3D::dotProduct(center, coneAxis) >= coneCutoff * center.length() + radius;
+}
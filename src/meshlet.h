@@ -0,0 +1,63 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <GL/gl.h>
+
+#include <vector>
+
+#include <QVector3D>
+#include <QVector>
+
+/*
+ * A small cluster of neighbouring triangles, culled on its own. Its triangles
+ * are one contiguous range of the index buffer of the mesh.
+ */
+struct Meshlet
+{
+    // Bounding sphere, in model space
+    QVector3D center;
+    float radius = 0;
+
+    // All triangles face within the cone around the axis. A cutoff of 1
+    // means the triangles spread too far to ever cull the meshlet as a whole.
+    QVector3D coneAxis;
+    float coneCutoff = 1;
+
+    // The range in the index buffer
+    GLuint firstIndex = 0;
+    GLuint count = 0;
+};
+
+/*
+ * A mesh split into meshlets, with its indices reordered so the triangles of
+ * every meshlet are contiguous.
+ */
+struct MeshletMesh
+{
+    std::vector<Meshlet> meshlets;
+    QVector<unsigned> indices;
+};
+
+class Meshlets
+{
+public:
+    static constexpr size_t MAX_VERTICES = 64;
+    static constexpr size_t MAX_TRIANGLES = 124;
+
+    /*
+     * Partitions the triangles greedily: a meshlet grows by the neighbouring
+     * triangle that adds the fewest new vertices, until it is full or has no
+     * neighbours left that face about the same way as it does. Small
+     * meshlets also take in nearby triangles they are not connected to.
+     */
+    static MeshletMesh build(QVector<QVector3D> const &coords, QVector<unsigned> const &indices);
+
+    /*
+     * Whether every triangle of the meshlet faces away from an eye at the
+     * origin. The meshlet is given after a transform that preserves angles
+     * and orientation.
+     */
+    static bool isBackfacing(QVector3D const &center, float radius, QVector3D const &coneAxis, float coneCutoff);
+};
+
+#endif // MESHLET_H
@@ -4,16 +4,51 @@
 #include <QFile>
 #include <QTextStream>
 #include <QtCore/qlogging.h>
-#include <tuple>
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+namespace {
+
+// Frees the memory of a vector, clear() may keep it allocated
+template <typename T>
+void release(QVector<T> &vector) {
+    QVector<T>().swap(vector);
+}
+
+// What line.split(" ", Qt::SkipEmptyParts).size() would be, without
+// allocating the parts
+qsizetype countFields(QString const &line) {
+    qsizetype count = 0;
+    bool inField = false;
+    for (QChar c : line) {
+        bool separator = c == QLatin1Char(' ');
+        if (!separator && !inField) ++count;
+        inField = !separator;
+    }
+    return count;
+}
+
+}
 
 /**
  * @brief Model::Model Constructs a new model from a Wavefront .obj file.
+ *
+ * Faces go straight into the requested layout while parsing, so the per
+ * corner indices are never stored. Everything is reserved up front from a
+ * first pass over the file, so no buffer grows past its final size.
+ *
  * @param filename The filename. Should be a .obj file
+ * @param layout The layout to build, the getters of the other one return
+ * nothing.
  */
-Model::Model(const QString& filename) {
+Model::Model(const QString& filename, LAYOUT layout) : layout(layout) {
     qDebug() << ":: Loading model:" << filename;
     QFile file(filename);
     if (file.open(QIODevice::ReadOnly)) {
+        reserve(file);
+        file.seek(0);
+
         QTextStream in(&file);
 
         QString line;
@@ -24,6 +59,7 @@ Model::Model(const QString& filename) {
             if (line.startsWith("#")) continue;  // skip comments
 
             tokens = line.split(" ", Qt::SkipEmptyParts);
+            if (tokens.isEmpty()) continue;
 
             // Switch depending on first element
             if (tokens[0] == "v") {
@@ -45,14 +81,81 @@ Model::Model(const QString& filename) {
 
         file.close();
 
-        // create an array version of the data
-        unpackIndexes();
+        // Remove old data
+        release(vert);
+        release(norm);
+        release(tex);
+        std::vector<CornerSlot>().swap(cornerTable);
+
+        // The number of unique vertices was only estimated
+        vertices_indexed.squeeze();
+        normals_indexed.squeeze();
+        textureCoords_indexed.squeeze();
 
-        // Allign all vertex indices with the right normal/texturecoord indices
-        alignData();
+        qDebug() << ":: Loaded" << getNumTriangles() << "triangles, peak RSS"
+                 << getPeakResidentKilobytes() << "kB";
     }
 }
 
+/**
+ * @brief Model::reserve Counts the elements in the .obj file, to reserve
+ * exactly what is needed.
+ * @param file The opened .obj file.
+ */
+void Model::reserve(QFile &file) {
+    QTextStream in(&file);
+
+    qsizetype vertexCount = 0;
+    qsizetype normalCount = 0;
+    qsizetype textureCount = 0;
+    qsizetype cornerCount = 0;
+
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (line.startsWith("v ")) {
+            ++vertexCount;
+        } else if (line.startsWith("vn")) {
+            ++normalCount;
+        } else if (line.startsWith("vt")) {
+            ++textureCount;
+        } else if (line.startsWith("f ")) {
+            cornerCount += countFields(line) - 1;
+        }
+    }
+
+    vert.reserve(vertexCount);
+    norm.reserve(normalCount);
+    tex.reserve(textureCount);
+
+    if (layout == LAYOUT::INDEXED) {
+        // At least one vertex per position, normal or texture coordinate
+        qsizetype uniqueCount = std::max({vertexCount, normalCount, textureCount});
+        vertices_indexed.reserve(uniqueCount);
+        normals_indexed.reserve(uniqueCount);
+        textureCoords_indexed.reserve(uniqueCount);
+        indices.reserve(cornerCount);
+
+        size_t tableSize = 16;
+        while (tableSize < 2 * static_cast<size_t>(uniqueCount)) tableSize *= 2;
+        cornerTable.assign(tableSize, CornerSlot{});
+    } else {
+        vertices.reserve(cornerCount);
+        if (normalCount > 0) normals.reserve(cornerCount);
+        if (textureCount > 0) textureCoords.reserve(cornerCount);
+    }
+}
+
+bool Model::Corner::operator==(Corner const &other) const {
+    return vertex == other.vertex && textureCoords == other.textureCoords && normal == other.normal;
+}
+
+size_t Model::Corner::hash() const {
+    uint64_t hash = static_cast<uint32_t>(vertex) * 0x9E3779B97F4A7C15ULL;
+    hash ^= static_cast<uint32_t>(textureCoords) * 0xC2B2AE3D27D4EB4FULL;
+    hash ^= static_cast<uint32_t>(normal) * 0x165667B19E3779F9ULL;
+    return static_cast<size_t>(hash ^ (hash >> 29));
+}
+
 /**
  * @brief Model::parseVertex Parses the coordinates of a vertex from the
  * .obj file.
@@ -62,7 +165,7 @@ void Model::parseVertex(QStringList tokens) {
     float x = tokens[1].toFloat();
     float y = tokens[2].toFloat();
     float z = tokens[3].toFloat();
-    vertices_indexed.append(QVector3D(x, y, z));
+    vert.append(QVector3D(x, y, z));
 }
 
 /**
@@ -98,15 +201,22 @@ void Model::parseFace(QStringList tokens) {
 
     for (int i = 1; i != tokens.size(); ++i) {
         elements = tokens[i].split("/");
+
         // -1 since .obj count from 1
-        indices.append(elements[0].toInt() - 1);
+        Corner corner{elements[0].toInt() - 1, -1, -1};
 
         if (elements.size() > 1 && !elements[1].isEmpty()) {
-            texcoord_indices.append(elements[1].toInt() - 1);
+            corner.textureCoords = elements[1].toInt() - 1;
         }
 
         if (elements.size() > 2 && !elements[2].isEmpty()) {
-            normal_indices.append(elements[2].toInt() - 1);
+            corner.normal = elements[2].toInt() - 1;
+        }
+
+        if (layout == LAYOUT::INDEXED) {
+            alignData(corner);
+        } else {
+            unpackIndexes(corner);
         }
     }
 }
@@ -117,80 +227,60 @@ void Model::parseFace(QStringList tokens) {
  * Make sure that the indices from the vertices align with those
  * of the normals and the texture coordinates, create extra vertices
  * if vertex has multiple normals or texturecoords
+ *
+ * @param corner A corner of a face.
  */
-void Model::alignData() {
-    QVector<QVector3D> verts;
-    verts.reserve(vertices_indexed.size());
-    QVector<QVector3D> norms;
-    norms.reserve(vertices_indexed.size());
-    QVector<QVector2D> texcs;
-    texcs.reserve(vertices_indexed.size());
-    QVector<std::tuple<QVector3D, QVector3D, QVector2D>> vs;
-
-    QVector<unsigned> ind;
-    ind.reserve(indices.size());
-
-    unsigned currentIndex = 0;
-
-    for (int i = 0; i != indices.size(); ++i) {
-        QVector3D v = vertices_indexed[indices[i]];
-
-        QVector3D n(0, 0, 0);
-        if (hNorms) {
-            n = norm[normal_indices[i]];
-        }
-
-        QVector2D t(0, 0);
-        if (hTexs) {
-            t = tex[texcoord_indices[i]];
+void Model::alignData(Corner const &corner) {
+    if (2 * (static_cast<size_t>(vertices_indexed.size()) + 1) > cornerTable.size()) {
+        // Keep the table at most half full
+        std::vector<CornerSlot> old(2 * cornerTable.size());
+        old.swap(cornerTable);
+        for (auto const &slot : old) {
+            if (slot.corner.vertex < 0) continue;
+            size_t mask = cornerTable.size() - 1;
+            size_t i = slot.corner.hash() & mask;
+            while (cornerTable[i].corner.vertex >= 0) i = (i + 1) & mask;
+            cornerTable[i] = slot;
         }
+    }
 
-        std::tuple<QVector3D, QVector3D, QVector2D> k(v, n, t);
-        if (vs.contains(k)) {
+    // Corners with the same indices share a vertex
+    size_t mask = cornerTable.size() - 1;
+    size_t i = corner.hash() & mask;
+    while (cornerTable[i].corner.vertex >= 0) {
+        if (cornerTable[i].corner == corner) {
             // Vertex already exists, use that index
-            ind.append(vs.indexOf(k));
-        } else {
-            // Create a new vertex
-            verts.append(v);
-            norms.append(n);
-            texcs.append(t);
-            vs.append(k);
-            ind.append(currentIndex);
-            ++currentIndex;
+            indices.append(cornerTable[i].index);
+            return;
         }
+        i = (i + 1) & mask;
     }
-    // Remove old data
-    vertices_indexed.clear();
-    normals_indexed.clear();
-    textureCoords_indexed.clear();
-    indices.clear();
-
-    // Set the new data
-    vertices_indexed = verts;
-    normals_indexed = norms;
-    textureCoords_indexed = texcs;
-    indices = ind;
+
+    // Create a new vertex
+    unsigned index = static_cast<unsigned>(vertices_indexed.size());
+    cornerTable[i] = {corner, index};
+
+    vertices_indexed.append(vert[corner.vertex]);
+    normals_indexed.append(hNorms && corner.normal >= 0 ? norm[corner.normal] : QVector3D(0, 0, 0));
+    textureCoords_indexed.append(hTexs && corner.textureCoords >= 0 ? tex[corner.textureCoords] : QVector2D(0, 0));
+    indices.append(index);
 }
 
 /**
  * @brief Model::unpackIndexes Unpack indices so that they are available for
  * glDrawArrays()
  *
+ * @param corner A corner of a face.
  */
-void Model::unpackIndexes() {
-    vertices.clear();
-    normals.clear();
-    textureCoords.clear();
-    for (int i = 0; i != indices.size(); ++i) {
-        vertices.append(vertices_indexed[indices[i]]);
-
-        if (hNorms) {
-            normals.append(norm[normal_indices[i]]);
-        }
+void Model::unpackIndexes(Corner const &corner) {
+    vertices.append(vert[corner.vertex]);
 
-        if (hTexs) {
-            textureCoords.append(tex[texcoord_indices[i]]);
-        }
+    if (hNorms) {
+        normals.append(corner.normal >= 0 ? norm[corner.normal] : QVector3D(0, 0, 0));
+    }
+
+    if (hTexs) {
+        textureCoords.append(corner.textureCoords >= 0 ? tex[corner.textureCoords] : QVector2D(0, 0));
     }
 }
 
@@ -209,7 +299,7 @@ void Model::unitize() { qDebug() << "Implement this yourself (optional)"; }
  * c3, c4, etc.
  * @return The coordinates in the mesh.
  */
-QVector<QVector3D> Model::getCoords() { return vertices; }
+QVector<QVector3D> const &Model::getCoords() const { return vertices; }
 
 /**
  * @brief Model::getCoords Get all normals in the mesh. The normals are
@@ -218,7 +308,7 @@ QVector<QVector3D> Model::getCoords() { return vertices; }
  * n4, etc.
  * @return The normals in the mesh.
  */
-QVector<QVector3D> Model::getNormals() { return normals; }
+QVector<QVector3D> const &Model::getNormals() const { return normals; }
 
 /**
  * @brief Model::getCoords Get all texture coordinates in the mesh. The texture
@@ -227,7 +317,7 @@ QVector<QVector3D> Model::getNormals() { return normals; }
  * tx3, tx2, tx3, tx4, etc.
  * @return The texture coordinates in the mesh.
  */
-QVector<QVector2D> Model::getTextureCoords() { return textureCoords; }
+QVector<QVector2D> const &Model::getTextureCoords() const { return textureCoords; }
 
 /**
  * @brief Model::getCoords Get all unique coordinates in the mesh. The
@@ -237,7 +327,7 @@ QVector<QVector2D> Model::getTextureCoords() { return textureCoords; }
  * getIndices().
  * @return The unique coordinates in the mesh.
  */
-QVector<QVector3D> Model::getCoordsIndexed() { return vertices_indexed; }
+QVector<QVector3D> const &Model::getCoordsIndexed() const { return vertices_indexed; }
 
 /**
  * @brief Model::getCoords Get all unique normals in the mesh. The
@@ -247,7 +337,7 @@ QVector<QVector3D> Model::getCoordsIndexed() { return vertices_indexed; }
  * getIndices().
  * @return The unique normals in the mesh.
  */
-QVector<QVector3D> Model::getNormalsIndexed() { return normals_indexed; }
+QVector<QVector3D> const &Model::getNormalsIndexed() const { return normals_indexed; }
 
 /**
  * @brief Model::getCoords Get all unique texture coordinates in the mesh. The
@@ -257,7 +347,7 @@ QVector<QVector3D> Model::getNormalsIndexed() { return normals_indexed; }
  * getIndices().
  * @return The unique texture coordinates in the mesh.
  */
-QVector<QVector2D> Model::getTextureCoordsIndexed() {
+QVector<QVector2D> const &Model::getTextureCoordsIndexed() const {
     return textureCoords_indexed;
 }
 
@@ -268,7 +358,42 @@ QVector<QVector2D> Model::getTextureCoordsIndexed() {
  * different triangles in the mesh. Intended to be used with glDrawElements.
  * @return A list of indices.
  */
-QVector<unsigned> Model::getIndices() { return indices; }
+QVector<unsigned> const &Model::getIndices() const { return indices; }
+
+/**
+ * @brief Model::takeCoords Moves the coordinates of the layout that was built
+ * out of the model.
+ * @return The coordinates, as getCoords() or getCoordsIndexed() would.
+ */
+QVector<QVector3D> Model::takeCoords() {
+    return std::move(layout == LAYOUT::INDEXED ? vertices_indexed : vertices);
+}
+
+/**
+ * @brief Model::takeNormals Moves the normals of the layout that was built out
+ * of the model.
+ * @return The normals, as getNormals() or getNormalsIndexed() would.
+ */
+QVector<QVector3D> Model::takeNormals() {
+    return std::move(layout == LAYOUT::INDEXED ? normals_indexed : normals);
+}
+
+/**
+ * @brief Model::takeTextureCoords Moves the texture coordinates of the layout
+ * that was built out of the model.
+ * @return The texture coordinates, as getTextureCoords() or
+ * getTextureCoordsIndexed() would.
+ */
+QVector<QVector2D> Model::takeTextureCoords() {
+    return std::move(layout == LAYOUT::INDEXED ? textureCoords_indexed : textureCoords);
+}
+
+/**
+ * @brief Model::takeIndices Moves the indices out of the model. Empty for the
+ * ARRAYS layout.
+ * @return The indices, as getIndices() would.
+ */
+QVector<unsigned> Model::takeIndices() { return std::move(indices); }
 
 /**
  * @brief Model::getVNInterleaved Retrieves the coordinates and normals of a
@@ -380,7 +505,25 @@ QVector<float> Model::getVNTInterleavedIndexed() {
  * @brief Model::getNumTriangles Retrieves the number of triangles in this mesh.
  * @return The number of triangles in this mesh.
  */
-int Model::getNumTriangles() { return vertices.size() / 3; }
+int Model::getNumTriangles() {
+    return static_cast<int>(layout == LAYOUT::INDEXED ? indices.size() : vertices.size()) / 3;
+}
+
+/**
+ * @brief Model::getPeakResidentKilobytes Reads the high water mark of the
+ * resident set size of the process (VmHWM), to see what loading costs.
+ * @return The peak resident set size in kB, or -1 where /proc is not available.
+ */
+long Model::getPeakResidentKilobytes() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::stol(line.substr(6));
+        }
+    }
+    return -1;
+}
 
 QVector<QVector3D> Model::getRandomColors() {
     auto size = vertices.size();
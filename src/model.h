@@ -1,12 +1,15 @@
 #ifndef MODEL_H
 #define MODEL_H
 
+#include <QFile>
 #include <QString>
 #include <QStringList>
 #include <QVector2D>
 #include <QVector3D>
 #include <QVector>
 
+#include <vector>
+
 /**
  * @brief A simple Model class. Represents a 3D triangle mesh and is able to
  * load this data from a Wavefront .obj file. IMPORTANT: Current only supports
@@ -17,12 +20,23 @@
  */
 class Model {
 public:
-    Model(const QString& filename);
+    /*
+     * The vertex layout to build. Only that one is kept, everything parsed to
+     * get there is freed along the way.
+     */
+    enum class LAYOUT {
+        // One vertex per triangle corner, for glDrawArrays()
+        ARRAYS,
+        // Unique vertices plus indices, for glDrawElements()
+        INDEXED
+    };
+
+    Model(const QString& filename, LAYOUT layout = LAYOUT::ARRAYS);
 
     // Used for glDrawArrays()
-    QVector<QVector3D> getCoords();
-    QVector<QVector3D> getNormals();
-    QVector<QVector2D> getTextureCoords();
+    QVector<QVector3D> const &getCoords() const;
+    QVector<QVector3D> const &getNormals() const;
+    QVector<QVector2D> const &getTextureCoords() const;
     QVector<QVector3D> getRandomColors();
 
     // Used for interleaving into one buffer for glDrawArrays()
@@ -30,22 +44,50 @@ public:
     QVector<float> getVNTInterleaved();
 
     // Used for glDrawElements()
-    QVector<QVector3D> getCoordsIndexed();
-    QVector<QVector3D> getNormalsIndexed();
-    QVector<QVector2D> getTextureCoordsIndexed();
-    QVector<unsigned> getIndices();
+    QVector<QVector3D> const &getCoordsIndexed() const;
+    QVector<QVector3D> const &getNormalsIndexed() const;
+    QVector<QVector2D> const &getTextureCoordsIndexed() const;
+    QVector<unsigned> const &getIndices() const;
 
     // Used for interleaving into one buffer for glDrawElements()
     QVector<float> getVNInterleavedIndexed();
     QVector<float> getVNTInterleavedIndexed();
 
+    // Move the buffers of the layout that was built out of the model, without
+    // copying. The model is left without them.
+    QVector<QVector3D> takeCoords();
+    QVector<QVector3D> takeNormals();
+    QVector<QVector2D> takeTextureCoords();
+    QVector<unsigned> takeIndices();
+
     bool hasNormals();
     bool hasTextureCoords();
     int getNumTriangles();
 
     void unitize();
 
+    // The peak resident set size of the process so far, in kB, or -1 if unknown
+    static long getPeakResidentKilobytes();
+
 private:
+    // The indices of one triangle corner into vert, tex and norm, -1 if absent
+    struct Corner {
+        int vertex;
+        int textureCoords;
+        int normal;
+
+        bool operator==(Corner const &other) const;
+        size_t hash() const;
+    };
+
+    // An open addressing hash table entry, empty while corner.vertex is -1
+    struct CornerSlot {
+        Corner corner{-1, -1, -1};
+        unsigned index = 0;
+    };
+
+    void reserve(QFile &file);
+
     // OBJ parsing
     void parseVertex(QStringList tokens);
     void parseNormal(QStringList tokens);
@@ -53,24 +95,28 @@ private:
     void parseFace(QStringList tokens);
 
     // Alignment of data
-    void alignData();
-    void unpackIndexes();
+    void alignData(Corner const &corner);
+    void unpackIndexes(Corner const &corner);
+
+    LAYOUT layout;
 
-    // Intermediate storage of values
+    // Output for glDrawElements()
     QVector<QVector3D> vertices_indexed;
     QVector<QVector3D> normals_indexed;
     QVector<QVector2D> textureCoords_indexed;
     QVector<unsigned> indices;
 
+    // Output for glDrawArrays()
     QVector<QVector3D> vertices;
     QVector<QVector3D> normals;
     QVector<QVector2D> textureCoords;
 
-    // Utility storage
-    QVector<unsigned> normal_indices;
-    QVector<unsigned> texcoord_indices;
+    // Intermediate storage, as parsed
+    QVector<QVector3D> vert;
     QVector<QVector3D> norm;
     QVector<QVector2D> tex;
+    // The vertex of every unique corner so far, for the INDEXED layout
+    std::vector<CornerSlot> cornerTable;
 
     bool hNorms = false;
     bool hTexs = false;
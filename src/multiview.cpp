@@ -0,0 +1,130 @@
+#include "multiview.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QtMath>
+
+#include "meshlet.h"
+
+MultiView::MultiView(std::vector<QMatrix4x4> const &eyeTransforms)
+    : viewCount{std::clamp(static_cast<int>(eyeTransforms.size()), 1, MAX_VIEWS)} {
+    std::copy_n(eyeTransforms.begin(), std::min(eyeTransforms.size(), this->eyeTransforms.size()),
+                this->eyeTransforms.begin());
+}
+
+MultiView MultiView::stereo(float eyeDistance) {
+    // Moving an eye to the left moves what it sees to the right
+    std::vector<QMatrix4x4> eyeTransforms(2);
+    eyeTransforms[0].translate(eyeDistance / 2, 0, 0);
+    eyeTransforms[1].translate(-eyeDistance / 2, 0, 0);
+    return MultiView{eyeTransforms};
+}
+
+MultiView MultiView::surround(int count) {
+    std::vector<QMatrix4x4> eyeTransforms(std::clamp(count, 1, MAX_VIEWS));
+    for (size_t view = 0; view < eyeTransforms.size(); ++view) {
+        eyeTransforms[view].rotate(360.0F * view / eyeTransforms.size(), 0, 1, 0);
+    }
+    return MultiView{eyeTransforms};
+}
+
+void MultiView::update(QMatrix4x4 const &cameraRotation, float fieldOfView, float aspectRatio,
+                       float nearPlane, float farPlane) {
+    QMatrix4x4 perspective;
+    perspective.perspective(fieldOfView, aspectRatio / viewCount, nearPlane, farPlane);
+    this->nearPlane = nearPlane;
+
+    float halfHeight = farPlane * std::tan(qDegreesToRadians(fieldOfView / 2));
+    float halfWidth = halfHeight * aspectRatio / viewCount;
+    reach = std::sqrt(farPlane * farPlane + halfHeight * halfHeight + halfWidth * halfWidth);
+
+    for (int view = 0; view < viewCount; ++view) {
+        QMatrix4x4 eyeTransform = eyeTransforms[view] * cameraRotation;
+        projections[view] = perspective * eyeTransform;
+        frusta[view] = Frustum::fromMatrix(projections[view]);
+        eyes[view] = eyeTransform.inverted().map(QVector3D{});
+    }
+}
+
+MultiView MultiView::narrowedTo(QVector3D const &center, float radius) const {
+    MultiView narrowed = *this;
+    for (int view = 0; view < viewCount; ++view) {
+        if (!frusta[view].intersectsSphere(center, radius)) {
+            narrowed.frusta[view] = Frustum::none();
+            continue;
+        }
+
+        float left, right, bottom, top;
+        if (!screenBounds(view, center, radius, left, right, bottom, top)) continue;
+
+        narrowed.frusta[view] = Frustum::fromMatrix(projections[view], std::max(left, -1.0F),
+                                                    std::min(right, 1.0F), std::max(bottom, -1.0F),
+                                                    std::min(top, 1.0F));
+    }
+    return narrowed;
+}
+
+bool MultiView::croppedTo(QVector3D const &center, float radius, MultiView &cropped) const {
+    float left, right, bottom, top;
+    if (!frusta[0].intersectsSphere(center, radius) || !screenBounds(0, center, radius, left, right, bottom, top)) {
+        return false;
+    }
+
+    // From the bounds in normalized device coordinates to all of [-1, 1]
+    QMatrix4x4 crop;
+    crop(0, 0) = 2 / (right - left);
+    crop(0, 3) = -(right + left) / (right - left);
+    crop(1, 1) = 2 / (top - bottom);
+    crop(1, 3) = -(top + bottom) / (top - bottom);
+
+    cropped = *this;
+    cropped.viewCount = 1;
+    cropped.projections[0] = crop * projections[0];
+    cropped.frusta[0] = Frustum::fromMatrix(cropped.projections[0]);
+    return true;
+}
+
+bool MultiView::screenBounds(int view, QVector3D const &center, float radius,
+                             float &left, float &right, float &bottom, float &top) const {
+    // The corners of a cube around the sphere bound it on screen too, as long
+    // as all of them are in front of the eye
+    left = std::numeric_limits<float>::max();
+    right = -left;
+    bottom = left;
+    top = -left;
+    for (int corner = 0; corner < 8; ++corner) {
+        QVector3D offset{corner & 1 ? radius : -radius, corner & 2 ? radius : -radius,
+                         corner & 4 ? radius : -radius};
+        QVector4D clip = projections[view] * QVector4D{center + offset, 1};
+        if (clip.w() < nearPlane) {
+            return false;
+        }
+        left = std::min(left, clip.x() / clip.w());
+        right = std::max(right, clip.x() / clip.w());
+        bottom = std::min(bottom, clip.y() / clip.w());
+        top = std::max(top, clip.y() / clip.w());
+    }
+    return true;
+}
+
+bool MultiView::intersectsSphere(QVector3D const &center, float radius) const {
+    return std::any_of(frusta.begin(), frusta.begin() + viewCount,
+                       [&](Frustum const &frustum) { return frustum.intersectsSphere(center, radius); });
+}
+
+bool MultiView::isBackfacing(QVector3D const &center, float radius, QVector3D const &coneAxis,
+                             float coneCutoff) const {
+    return std::all_of(eyes.begin(), eyes.begin() + viewCount, [&](QVector3D const &eye) {
+        return Meshlets::isBackfacing(center - eye, radius, coneAxis, coneCutoff);
+    });
+}
+
+float MultiView::distance(QVector3D const &point) const {
+    float nearest = std::numeric_limits<float>::max();
+    for (int view = 0; view < viewCount; ++view) {
+        nearest = std::min(nearest, (point - eyes[view]).length());
+    }
+    return nearest;
+}
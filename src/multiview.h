@@ -0,0 +1,96 @@
+#ifndef MULTIVIEW_H
+#define MULTIVIEW_H
+
+#include <array>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "frustum.h"
+
+/*
+ * The views a frame is rendered from in one pass, side by side across the
+ * frame: the two eyes of a stereo pair, or split-screen views turned away
+ * from the camera.
+ *
+ * Every draw is instanced once per view, and the vertex shaders
+ * (shaders/multiview.glsl) project instance i with the projection of view
+ * i % count() into that view's slot of the frame, clipped to the slot. All
+ * the work before the draws, the culling, draw lists, uniforms and GPU
+ * culling dispatches, is done once for all views: an object is kept if any
+ * view sees it.
+ *
+ * The views are placed relative to the camera's eye, and move with it.
+ */
+class MultiView
+{
+public:
+    // Must match MAX_VIEWS in shaders/multiview.glsl and shaders/cullcompshader.glsl
+    static constexpr int MAX_VIEWS = 4;
+
+    // The camera alone. Every pass of every frame starts from one, so it
+    // does not go through a vector of transforms.
+    MultiView() = default;
+    // Takes the first MAX_VIEWS transforms, from the camera's eye space to each view's
+    explicit MultiView(std::vector<QMatrix4x4> const &eyeTransforms);
+
+    // A left and a right eye, eyeDistance apart
+    static MultiView stereo(float eyeDistance);
+    // count views, the first the camera's and the others turned evenly around it
+    static MultiView surround(int count);
+
+    /*
+     * Updates the views for the camera's rotation and the aspect ratio of the
+     * whole frame, which the views split evenly between them.
+     */
+    void update(QMatrix4x4 const &cameraRotation, float fieldOfView, float aspectRatio,
+                float nearPlane, float farPlane);
+
+    /*
+     * The views as seen through an opening with the given bounding sphere, in
+     * the space of the modelview transforms: the frustum of each view cut to
+     * where the sphere is on screen, or to nothing if the view does not see
+     * it. Views whose near plane the sphere crosses are kept as they are.
+     */
+    MultiView narrowedTo(QVector3D const &center, float radius) const;
+
+    /*
+     * The first view alone, its projection cropped to where a sphere is on
+     * screen, on or off it, so the sphere fills the view. Returns false if the
+     * view does not see the sphere or it crosses the near plane.
+     */
+    bool croppedTo(QVector3D const &center, float radius, MultiView &cropped) const;
+
+    int count() const { return viewCount; }
+    // From the space of the modelview transforms to the clip space of a view, before it is put in its slot
+    std::array<QMatrix4x4, MAX_VIEWS> const &getProjections() const { return projections; }
+    std::array<Frustum, MAX_VIEWS> const &getFrusta() const { return frusta; }
+    // Where the eyes are, in the space of the modelview transforms
+    std::array<QVector3D, MAX_VIEWS> const &getEyes() const { return eyes; }
+    // How far a view sees from its eye, to the corners of its far plane
+    float getReach() const { return reach; }
+
+    // Whether a sphere is at least partially inside the frustum of any view
+    bool intersectsSphere(QVector3D const &center, float radius) const;
+    // Whether all views see a meshlet from behind, see Meshlets::isBackfacing
+    bool isBackfacing(QVector3D const &center, float radius, QVector3D const &coneAxis, float coneCutoff) const;
+    // From the nearest eye to a point
+    float distance(QVector3D const &point) const;
+
+private:
+    // The bounds of a sphere in the normalized device coordinates of a view,
+    // false if it reaches in front of the near plane
+    bool screenBounds(int view, QVector3D const &center, float radius,
+                      float &left, float &right, float &bottom, float &top) const;
+
+    int viewCount = 1;
+    std::array<QMatrix4x4, MAX_VIEWS> eyeTransforms;
+    std::array<QMatrix4x4, MAX_VIEWS> projections;
+    std::array<Frustum, MAX_VIEWS> frusta;
+    std::array<QVector3D, MAX_VIEWS> eyes;
+    float reach = 0;
+    float nearPlane = 0;
+};
+
+#endif // MULTIVIEW_H
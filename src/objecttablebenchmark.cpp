@@ -0,0 +1,226 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "scenestore.h"
+
+/*
+ * Times the per-frame loops over the objects of a scene, on 100k objects,
+ * once with ObjectTable and once with the array of structs the scene kept its
+ * objects in before (one object per element, its GL names, position and
+ * transform interleaved). Touches no GL, so it runs without a window:
+ *
+ *     ObjectTableBenchmark [object count] [repetitions]
+ *
+ * Prints the median time of every loop for both layouts, and the cache lines
+ * each loop touches. The objects take up far more than the caches hold, so
+ * every line a loop touches is a miss on a cold pass: the count is what the
+ * layout changes, and the time shows how much of the loop that is. Hardware
+ * counters measure the same with, e.g., perf stat -e cache-misses, where the
+ * machine has them.
+ */
+
+namespace {
+
+// As the scene stored its objects before ObjectTable
+struct LegacyObject
+{
+    GLuint vao = 0;
+    GLuint positionVBO = 0;
+    GLuint normalVBO = 0;
+    GLuint textureVBO = 0;
+    GLuint size = 0;
+    QVector3D position;
+    QMatrix4x4 modelTransform;
+    GLuint texture = 0;
+};
+
+constexpr uintptr_t CACHE_LINE = 64;
+
+// The objects spread over a cube, as in the stress scene
+QVector3D positionOf(size_t object, size_t count) {
+    int side = std::max(1, static_cast<int>(std::cbrt(static_cast<double>(count))));
+    int i = static_cast<int>(object);
+    return {static_cast<float>(i % side) * 3, static_cast<float>(i / side % side) * 3,
+            -static_cast<float>(i / (side * side)) * 3};
+}
+
+template <typename Loop>
+double medianMilliseconds(int repetitions, Loop &&loop) {
+    std::vector<double> times;
+    QElapsedTimer timer;
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+        timer.start();
+        loop();
+        times.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+// The distinct cache lines of the memory that touches(touch) passes to touch
+template <typename Touches>
+size_t cacheLines(Touches &&touches) {
+    std::vector<uintptr_t> lines;
+    touches([&](void const *memory, size_t size) {
+        uintptr_t begin = reinterpret_cast<uintptr_t>(memory);
+        for (uintptr_t line = begin / CACHE_LINE; line <= (begin + size - 1) / CACHE_LINE; ++line) {
+            lines.push_back(line);
+        }
+    });
+    std::sort(lines.begin(), lines.end());
+    return static_cast<size_t>(std::unique(lines.begin(), lines.end()) - lines.begin());
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 100000;
+    int repetitions = argc > 2 ? std::max(1, std::atoi(argv[2])) : 50;
+
+    QMatrix4x4 cameraTransform;
+    cameraTransform.translate(0, -2, -20);
+    QVector3D center{30, 30, -30};
+    float radius = 40;
+
+    std::vector<LegacyObject> legacy(count);
+    ObjectTable table;
+    table.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        QVector3D position = positionOf(i, count);
+        legacy[i].position = position;
+        legacy[i].size = static_cast<GLuint>(i % 7);
+        table.add(position);
+        table.renderHandles[i].size = static_cast<GLuint>(i % 7);
+    }
+
+    // What the loops compute, printed so none of them is optimized away
+    double checksum = 0;
+
+    // MainView::updateModelTransforms, every tick
+    double legacyTransforms = medianMilliseconds(repetitions, [&] {
+        for (LegacyObject &object : legacy) {
+            object.modelTransform.setToIdentity();
+            object.modelTransform.translate(object.position);
+            object.modelTransform = object.modelTransform * cameraTransform;
+        }
+    });
+    double tableTransforms = medianMilliseconds(repetitions, [&] {
+        for (size_t i = 0; i < table.size(); ++i) {
+            QMatrix4x4 &modelTransform = table.modelTransforms[i];
+            modelTransform.setToIdentity();
+            modelTransform.translate(table.positions[i]);
+            modelTransform = modelTransform * cameraTransform;
+        }
+    });
+
+    // The visibility test of a pass, which only reads the positions
+    double legacyVisibility = medianMilliseconds(repetitions, [&] {
+        size_t visible = 0;
+        for (LegacyObject const &object : legacy) {
+            visible += (object.position - center).lengthSquared() < radius * radius;
+        }
+        checksum += visible;
+    });
+    double tableVisibility = medianMilliseconds(repetitions, [&] {
+        size_t visible = 0;
+        for (QVector3D const &position : table.positions) {
+            visible += (position - center).lengthSquared() < radius * radius;
+        }
+        checksum += visible;
+    });
+
+    // Gathering the draws of the visible objects: their transforms and meshes
+    double legacyDraws = medianMilliseconds(repetitions, [&] {
+        float sum = 0;
+        for (LegacyObject const &object : legacy) {
+            if ((object.position - center).lengthSquared() >= radius * radius) continue;
+            sum += object.modelTransform(2, 3) + object.size;
+        }
+        checksum += sum;
+    });
+    double tableDraws = medianMilliseconds(repetitions, [&] {
+        ObjectTable const &objects = table;
+        float sum = 0;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            if ((objects.positions[i] - center).lengthSquared() >= radius * radius) continue;
+            sum += objects.modelTransforms[i](2, 3) + objects.renderHandles[i].size;
+        }
+        checksum += sum;
+    });
+
+    // What each loop above reads and writes, in the same order
+    auto isVisible = [&](QVector3D const &position) {
+        return (position - center).lengthSquared() < radius * radius;
+    };
+    size_t legacyTransformLines = cacheLines([&](auto touch) {
+        for (LegacyObject const &object : legacy) {
+            touch(&object.position, sizeof(object.position));
+            touch(&object.modelTransform, sizeof(object.modelTransform));
+        }
+    });
+    size_t tableTransformLines = cacheLines([&](auto touch) {
+        for (size_t i = 0; i < table.size(); ++i) {
+            touch(&table.positions[i], sizeof(table.positions[i]));
+            touch(&table.modelTransforms[i], sizeof(table.modelTransforms[i]));
+        }
+    });
+    size_t legacyVisibilityLines = cacheLines([&](auto touch) {
+        for (LegacyObject const &object : legacy) {
+            touch(&object.position, sizeof(object.position));
+        }
+    });
+    size_t tableVisibilityLines = cacheLines([&](auto touch) {
+        touch(table.positions.data(), table.positions.size() * sizeof(QVector3D));
+    });
+    size_t legacyDrawLines = cacheLines([&](auto touch) {
+        for (LegacyObject const &object : legacy) {
+            touch(&object.position, sizeof(object.position));
+            if (!isVisible(object.position)) continue;
+            touch(&object.modelTransform(2, 3), sizeof(float));
+            touch(&object.size, sizeof(object.size));
+        }
+    });
+    size_t tableDrawLines = cacheLines([&](auto touch) {
+        ObjectTable const &objects = table;
+        for (size_t i = 0; i < objects.size(); ++i) {
+            touch(&objects.positions[i], sizeof(objects.positions[i]));
+            if (!isVisible(objects.positions[i])) continue;
+            touch(&objects.modelTransforms[i](2, 3), sizeof(float));
+            touch(&objects.renderHandles[i].size, sizeof(objects.renderHandles[i].size));
+        }
+    });
+
+    // Removing a tenth of the objects by handle and adding them back, which
+    // the array of structs had no stable handles for
+    std::vector<EntityHandle> handles;
+    for (size_t i = 0; i < table.size(); i += 10) {
+        handles.push_back(table.handles.handleAt(i));
+    }
+    double tableChurn = medianMilliseconds(repetitions, [&] {
+        for (EntityHandle &handle : handles) {
+            QVector3D position = table.positions[table.handles.indexOf(handle)];
+            table.remove(handle);
+            handle = table.add(position);
+        }
+    });
+
+    qDebug() << ":: Benchmarked" << count << "objects, median of" << repetitions << "runs in ms"
+             << "(array of structs / ObjectTable)";
+    qDebug() << ":: updateModelTransforms" << legacyTransforms << "/" << tableTransforms << "ms,"
+             << legacyTransformLines << "/" << tableTransformLines << "cache lines";
+    qDebug() << ":: Visibility" << legacyVisibility << "/" << tableVisibility << "ms," << legacyVisibilityLines
+             << "/" << tableVisibilityLines << "cache lines";
+    qDebug() << ":: Draw gathering" << legacyDraws << "/" << tableDraws << "ms," << legacyDrawLines << "/"
+             << tableDrawLines << "cache lines";
+    qDebug() << ":: Removing and adding a tenth (ObjectTable only)" << tableChurn;
+    qDebug() << ":: Checksum" << checksum;
+    return 0;
+}
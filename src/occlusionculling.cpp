@@ -0,0 +1,196 @@
+#include "mainview.h"
+
+#include <algorithm>
+
+/*
+ * Occlusion culling happens in two phases.
+ *
+ * While building the draw lists, objects are tested against the Hi-Z pyramids
+ * of an earlier frame, read back asynchronously. While drawing, the objects
+ * that test hid are not skipped outright: their bounds are drawn against the
+ * depth of the current frame under an occlusion query, and the objects
+ * themselves are drawn conditionally on it. That way objects that just came
+ * into view show up without popping in a frame late.
+ */
+
+void MainView::createBoundsMesh() {
+    // Two triangles for every side of the cube [-1, 1]^3
+    MeshData cube;
+    cube.fileName = "bounds";
+    for (int axis = 0; axis < 3; ++axis) {
+        for (float side : {-1.0F, 1.0F}) {
+            QVector3D corners[4];
+            for (int i = 0; i < 4; ++i) {
+                corners[i][axis] = side;
+                corners[i][(axis + 1) % 3] = i == 1 || i == 2 ? 1 : -1;
+                corners[i][(axis + 2) % 3] = i >= 2 ? 1 : -1;
+            }
+
+            QVector3D normal;
+            normal[axis] = side;
+            unsigned first = cube.coords.size();
+            for (int i = 0; i < 4; ++i) {
+                cube.coords.append(corners[i]);
+                cube.normals.append(normal);
+                cube.textureCoords.append(QVector2D{0, 0});
+            }
+            for (unsigned i : {0, 1, 2, 0, 2, 3}) {
+                cube.indices.append(first + i);
+            }
+        }
+    }
+
+    loadIntoRenderHandle(cube, boundsMesh);
+}
+
+void MainView::readBackDepth() {
+    // The pyramids are tested with a single projection, so with several views
+    // nothing is culled on occlusion, and the views share all other culling
+    if (views.count() > 1) {
+        return;
+    }
+
+    // Skip a frame rather than stall when both buffers are still in flight
+    auto readback = std::find_if(depthReadbacks.begin(), depthReadbacks.end(),
+                                 [](DepthReadback const &r) { return r.fence == nullptr; });
+    if (readback == depthReadbacks.end()) {
+        return;
+    }
+
+    // Of the frame as rendered, which with dynamic resolution is smaller than the window
+    size_t size = static_cast<size_t>(renderWidth) * renderHeight * sizeof(uint32_t);
+
+    if (readback->pbo == 0) {
+        glGenBuffers(1, &readback->pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+    // Only grows, the scale changes more often than the window does
+    if (readback->capacity < size) {
+        readback->capacity = size;
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    readback->width = renderWidth;
+    readback->height = renderHeight;
+    readback->windowWidth = width();
+    readback->windowHeight = height();
+
+    // Returns right away, the copy into the buffer happens on the GPU
+    glReadPixels(0, 0, renderWidth, renderHeight,
+                 GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback->frame = frameCount++;
+    // The stencil values of the portals drawn in full are numbered over those only
+    readback->portalPasses.assign(portalStencils.begin(), portalStencils.end());
+    readback->passCount = 1;
+    for (int &pass : readback->portalPasses) {
+        readback->passCount = std::max(readback->passCount, pass + 1);
+        pass = pass > 0 ? pass : -1;
+    }
+}
+
+void MainView::updateHiZBuffer() {
+    // Use the newest readback that has finished, without waiting on any
+    DepthReadback *newest = nullptr;
+    for (auto &readback : depthReadbacks) {
+        if (readback.fence == nullptr) continue;
+
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        if (newest == nullptr || readback.frame > newest->frame) {
+            newest = &readback;
+        }
+    }
+
+    if (newest == nullptr) {
+        return;
+    }
+
+    // Read back before a resize. The pyramids are tested in normalized device
+    // coordinates, so a readback at another scale of the same window still fits.
+    if (newest->windowWidth != width() || newest->windowHeight != height()) {
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->pbo);
+    auto const *depthStencil = static_cast<uint32_t const *>(glMapBufferRange(
+        GL_PIXEL_PACK_BUFFER, 0, newest->width * newest->height * sizeof(uint32_t), GL_MAP_READ_BIT));
+    if (depthStencil != nullptr) {
+        hiZBuffer.build(depthStencil, newest->width, newest->height, newest->passCount, jobSystem);
+        hiZPortalPasses = newest->portalPasses;
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void MainView::queryOcclusion(std::vector<DrawItem> const &items) {
+    if (occlusionQueries.size() < items.size()) {
+        size_t first = occlusionQueries.size();
+        occlusionQueries.resize(items.size());
+        glGenQueries(static_cast<GLsizei>(items.size() - first), occlusionQueries.data() + first);
+    }
+
+    // The proxies of all items, uploaded in one go
+    FrameVector<GLintptr> occlusionProxies;
+    occlusionProxies.reserve(items.size());
+    for (auto const &item : items) {
+        StreamBuffer::Allocation uniforms = objectUniforms.allocate(sizeof(ObjectUniforms), uniformAlignment);
+        if (uniforms.data == nullptr) {
+            break;
+        }
+        QMatrix4x4 proxyTransform;
+        proxyTransform.translate(item.boundsCenter);
+        proxyTransform.scale(item.boundsRadius);
+        ObjectUniforms::write(uniforms.data, proxyTransform, boundsMesh.positionOffset, boundsMesh.positionScale);
+        occlusionProxies.push_back(uniforms.offset);
+    }
+    objectUniforms.flush();
+
+    QOpenGLShaderProgram &shaderProgram = shaders[ShaderType::BOUNDS];
+    shaderProgram.bind();
+    setViewUniforms(shaderProgram);
+    // The bounds are in view space already, with the effect of the pass applied
+    bindEffectUniforms(identityEffectOffset);
+
+    // Only test against the depth buffer, under the stencil of the pass
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    // Count the back faces too, in case the front ones are clipped
+    glDisable(GL_CULL_FACE);
+
+    glBindVertexArray(boundsMesh.vao);
+    for (size_t i = 0; i < items.size(); ++i) {
+        // An item without room for its proxy stays hidden
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, occlusionQueries[i]);
+        if (i < occlusionProxies.size()) {
+            bindObjectUniforms(occlusionProxies[i]);
+            glDrawElementsInstanced(GL_TRIANGLES, boundsMesh.size, GL_UNSIGNED_INT, nullptr, views.count());
+        }
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+    }
+
+    glEnable(GL_CULL_FACE);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    shaderProgram.release();
+}
+
+void MainView::destroyOcclusionCulling() {
+    for (auto &readback : depthReadbacks) {
+        if (readback.fence != nullptr) {
+            glDeleteSync(readback.fence);
+        }
+        glDeleteBuffers(1, &readback.pbo);
+        readback = DepthReadback{};
+    }
+
+    glDeleteQueries(static_cast<GLsizei>(occlusionQueries.size()), occlusionQueries.data());
+    occlusionQueries.clear();
+
+    cleanUpRenderHandle(boundsMesh);
+}
@@ -0,0 +1,36 @@
+#include "mainview.h"
+
+/*
+ * The impostors being refreshed are rendered into their tiles before the
+ * frame, each from the view of its tile, with the draw list its pass built.
+ * See ImpostorAtlas.
+ */
+
+/**
+ * @brief MainView::refreshImpostors Renders the worlds behind the impostors
+ * that are refreshed this frame into their tiles of the atlas.
+ */
+void MainView::refreshImpostors() {
+    PortalTable &portals = currentScene.portalObjects;
+    MultiView frameViews = views;
+    bool refreshed = false;
+
+    for (size_t portal = 0; portal < portals.size(); ++portal) {
+        if (impostorAtlas.getMode(portal) != ImpostorAtlas::MODE::REFRESH) continue;
+        Profiler::Zone zone{profiler, "refreshImpostor", static_cast<int>(portal)};
+
+        impostorAtlas.beginRefresh(portal);
+        // Everything drawn reads the views of the frame, of which the tile has one of its own
+        views = impostorAtlas.getTileViews(portal);
+        paintDrawList(portalDrawLists[portal], static_cast<int>(portal) + 1);
+        // A world still being loaded is tried again next frame
+        int worldId = inPortal ? -1 : portals.effects[portal].worldId;
+        impostorAtlas.endRefresh(portal, getWorldObjects(worldId) != nullptr);
+        refreshed = true;
+    }
+
+    if (!refreshed) return;
+    views = frameViews;
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(0, 0, static_cast<int>(width() * devicePixelRatioF()), static_cast<int>(height() * devicePixelRatioF()));
+}
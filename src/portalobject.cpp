@@ -1,13 +1,10 @@
 #include "portalobject.h"
 
-PortalObject::PortalObject(QVector3D position, QMatrix4x4 effect, ShaderType shaderType)
-    : SceneObject{position}, effectTransform{effect}, shaderType{shaderType} {}
-
-QDebug operator<<(QDebug dbg, PortalObject::COLLISION_STATE state) {
+QDebug operator<<(QDebug dbg, PortalCollision::COLLISION_STATE state) {
     switch (state) {
-    case PortalObject::COLLISION_STATE::FRONT: return dbg << "FRONT";
-    case PortalObject::COLLISION_STATE::BACK: return dbg << "BACK";
-    case PortalObject::COLLISION_STATE::NO_COLLISION: return dbg << "NO_COLLISION";
+    case PortalCollision::COLLISION_STATE::FRONT: return dbg << "FRONT";
+    case PortalCollision::COLLISION_STATE::BACK: return dbg << "BACK";
+    case PortalCollision::COLLISION_STATE::NO_COLLISION: return dbg << "NO_COLLISION";
     default: return dbg;
     }
 }
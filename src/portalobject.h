@@ -1,15 +1,31 @@
 #ifndef PORTALOBJECT_H
 #define PORTALOBJECT_H
 
-#include <QOpenGLShaderProgram>
+#include <QDebug>
+#include <limits>
 
-#include "qmatrix4x4.h"
-#include "sceneobject.h"
 #include "ShaderType.h"
+#include "worldeffect.h"
 
+/*
+ * What a portal leads into.
+ */
+struct PortalEffect
+{
+    WorldEffect worldEffect;
+
+     // The shader to use inside this world
+    ShaderType shaderType = ShaderType::PHONG;
 
+    // The world (index into Scene::worlds) behind this portal. If negative,
+    // the portal shows the objects of the current scene under the effect.
+    int worldId = -1;
+};
 
-struct PortalObject : public SceneObject
+/*
+ * Where the camera is, relative to a portal.
+ */
+struct PortalCollision
 {
     enum class COLLISION_STATE {
         FRONT,
@@ -17,16 +33,12 @@ struct PortalObject : public SceneObject
         NO_COLLISION
     };
 
-    QMatrix4x4 effectTransform;
-    COLLISION_STATE collisionState;
-
-     // The shader to use inside this world
-    ShaderType shaderType;
+    COLLISION_STATE collisionState = COLLISION_STATE::NO_COLLISION;
 
-    PortalObject() = default;
-    PortalObject(QVector3D position, QMatrix4x4 effect, ShaderType shaderType = ShaderType::PHONG);
+    // Distance from the camera to the portal, as of the last collision check
+    float cameraDistance = std::numeric_limits<float>::max();
 };
 
-QDebug operator<<(QDebug dbg, PortalObject::COLLISION_STATE state);
+QDebug operator<<(QDebug dbg, PortalCollision::COLLISION_STATE state);
 
 #endif // PORTALOBJECT_H
@@ -0,0 +1,68 @@
+#include "portalsweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+PortalSweep::PortalSweep(std::vector<QVector3D> const &positions)
+    : positions{positions} {
+    sortedPortals.resize(positions.size());
+    std::iota(sortedPortals.begin(), sortedPortals.end(), 0);
+    std::sort(sortedPortals.begin(), sortedPortals.end(), [&](uint32_t a, uint32_t b) {
+        return positions[a].x() < positions[b].x();
+    });
+
+    sortedX.reserve(positions.size());
+    for (uint32_t portal : sortedPortals) {
+        sortedX.push_back(positions[portal].x());
+    }
+}
+
+void PortalSweep::sweep(QVector3D const &from, QVector3D const &to, std::vector<Crossing> &crossings) const {
+    crossings.clear();
+
+    // Broadphase: the portals whose outline overlaps the bounding box of the segment
+    float minX = std::min(from.x(), to.x()) - HALF_WIDTH;
+    float maxX = std::max(from.x(), to.x()) + HALF_WIDTH;
+    float minY = std::min(from.y(), to.y()) - HALF_HEIGHT;
+    float maxY = std::max(from.y(), to.y()) + HALF_HEIGHT;
+    float minZ = std::min(from.z(), to.z());
+    float maxZ = std::max(from.z(), to.z());
+
+    auto first = std::lower_bound(sortedX.begin(), sortedX.end(), minX);
+    auto last = std::upper_bound(first, sortedX.end(), maxX);
+    for (auto it = first; it != last; ++it) {
+        size_t portal = sortedPortals[it - sortedX.begin()];
+        QVector3D const &position = positions[portal];
+        if (position.y() < minY || position.y() > maxY ||
+            position.z() < minZ || position.z() > maxZ) {
+            continue;
+        }
+
+        // Narrowphase: the segment has to change sides of the plane...
+        float fromDistance = from.z() - position.z();
+        float toDistance = to.z() - position.z();
+        bool fromFront = fromDistance > 0;
+        if (fromFront == (toDistance > 0)) continue;
+
+        // ...within the outline of the portal
+        float t = fromDistance / (fromDistance - toDistance);
+        QVector3D hit = from + t * (to - from) - position;
+        if (std::abs(hit.x()) > HALF_WIDTH || std::abs(hit.y()) > HALF_HEIGHT) continue;
+
+        crossings.push_back({portal, t});
+    }
+
+    std::sort(crossings.begin(), crossings.end(), [](Crossing const &a, Crossing const &b) {
+        return a.t < b.t || (a.t == b.t && a.portal < b.portal);
+    });
+}
+
+PortalCollision::COLLISION_STATE PortalSweep::side(size_t portal, QVector3D const &position) const {
+    QVector3D relative = position - positions[portal];
+    if (std::abs(relative.x()) > HALF_WIDTH || std::abs(relative.y()) > HALF_HEIGHT ||
+        std::abs(relative.z()) > NEAR_DISTANCE) {
+        return PortalCollision::COLLISION_STATE::NO_COLLISION;
+    }
+    return relative.z() > 0 ? PortalCollision::COLLISION_STATE::FRONT : PortalCollision::COLLISION_STATE::BACK;
+}
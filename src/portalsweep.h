@@ -0,0 +1,60 @@
+#ifndef PORTALSWEEP_H
+#define PORTALSWEEP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <QVector3D>
+
+#include "portalobject.h"
+
+/*
+ * Finds the portals the camera passed through in between two ticks, by
+ * intersecting the segment it moved along with the portal quads, so no
+ * crossing is missed however far the camera moves in a tick.
+ *
+ * Portals are the quad of models/portal.obj: HALF_WIDTH by HALF_HEIGHT around
+ * their position, in the plane z = position.z(). Their front faces +z.
+ *
+ * As broadphase, the portals are sorted on x once, so a sweep only looks at
+ * the portals within the x range of the segment.
+ */
+class PortalSweep
+{
+public:
+    static constexpr float HALF_WIDTH = 1.5F;
+    static constexpr float HALF_HEIGHT = 3.0F;
+    // How close to its plane the camera has to be to be at a portal
+    static constexpr float NEAR_DISTANCE = 1.0F;
+
+    struct Crossing {
+        size_t portal;
+        // Where along the segment, from 0 to 1
+        float t;
+    };
+
+    explicit PortalSweep(std::vector<QVector3D> const &positions);
+
+    /*
+     * Replaces crossings with the portals the segment from -> to crosses, in
+     * the order it crosses them. A segment starting exactly on a portal plane
+     * counts as coming from the back, so it is not crossed twice.
+     */
+    void sweep(QVector3D const &from, QVector3D const &to, std::vector<Crossing> &crossings) const;
+
+    /*
+     * The side of the portal's plane a position is on, or NO_COLLISION if it
+     * is not within NEAR_DISTANCE of the portal's outline.
+     */
+    PortalCollision::COLLISION_STATE side(size_t portal, QVector3D const &position) const;
+
+private:
+    std::vector<QVector3D> positions;
+
+    // Portal indices sorted on the x of their position, and those x
+    std::vector<uint32_t> sortedPortals;
+    std::vector<float> sortedX;
+};
+
+#endif // PORTALSWEEP_H
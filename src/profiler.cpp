@@ -0,0 +1,291 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QDebug>
+#include <QFile>
+#include <QFont>
+#include <QTextStream>
+
+Profiler::CpuZone::CpuZone(Profiler &profiler, char const *name, int index)
+    : profiler(profiler), active(profiler.enabled) {
+    if (active) profiler.beginZone(name, index, false);
+}
+
+Profiler::CpuZone::~CpuZone() {
+    if (active) profiler.endZone(false);
+}
+
+Profiler::Zone::Zone(Profiler &profiler, char const *name, int index)
+    : profiler(profiler), active(profiler.enabled) {
+    if (active) profiler.beginZone(name, index, true);
+}
+
+Profiler::Zone::~Zone() {
+    if (active) profiler.endZone(true);
+}
+
+bool Profiler::Key::operator<(Key const &other) const {
+    int order = std::strcmp(name, other.name);
+    if (order != 0) return order < 0;
+    if (index != other.index) return index < other.index;
+    return track < other.track;
+}
+
+void Profiler::initialize(QOpenGLFunctions_3_3_Core *gl) {
+    this->gl = gl;
+    epoch = Clock::now();
+    events.resize(HISTORY * EVENTS_PER_FRAME);
+    firstEvent = 0;
+    eventCount = 0;
+}
+
+void Profiler::destroy() {
+    if (gl == nullptr) return;
+
+    for (auto &gpuFrame : gpuFrames) {
+        gl->glDeleteQueries(static_cast<GLsizei>(gpuFrame.queries.size()), gpuFrame.queries.data());
+        gpuFrame = GpuFrame{};
+    }
+    currentGpuFrame = nullptr;
+    gl = nullptr;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled) return;
+
+    if (gl != nullptr) {
+        // Pick up every earlier frame the GPU is done with, oldest first
+        std::array<GpuFrame *, FRAME_LATENCY> pending;
+        for (size_t i = 0; i < FRAME_LATENCY; ++i) {
+            pending[i] = &gpuFrames[i];
+        }
+        std::sort(pending.begin(), pending.end(),
+                  [](GpuFrame const *a, GpuFrame const *b) { return a->frame < b->frame; });
+        for (GpuFrame *gpuFrame : pending) {
+            if (gpuFrame->pending) collect(*gpuFrame);
+        }
+
+        currentGpuFrame = &gpuFrames[frameCount % FRAME_LATENCY];
+        if (currentGpuFrame->pending) {
+            // Still not done after FRAME_LATENCY frames, rather lose it than wait
+            currentGpuFrame->pending = false;
+            ++droppedFrames;
+        }
+        currentGpuFrame->frame = frameCount;
+        currentGpuFrame->cpuStart = now();
+        currentGpuFrame->usedQueries = 0;
+        currentGpuFrame->zones.clear();
+    }
+
+    beginZone("frame", -1, true);
+}
+
+void Profiler::endFrame() {
+    // Enabled by the frame, so the frame zone is open
+    if (openCpuZones.empty()) return;
+
+    endZone(true);
+
+    if (currentGpuFrame != nullptr) {
+        currentGpuFrame->pending = !currentGpuFrame->zones.empty();
+        currentGpuFrame = nullptr;
+    }
+
+    ++frameCount;
+    while (eventCount > 0 && events[firstEvent].frame + HISTORY < frameCount) {
+        firstEvent = (firstEvent + 1) % events.size();
+        --eventCount;
+    }
+}
+
+int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count();
+}
+
+GLuint Profiler::nextQuery() {
+    std::vector<GLuint> &queries = currentGpuFrame->queries;
+    if (currentGpuFrame->usedQueries == queries.size()) {
+        // Only grows until the frame with the most zones has been seen
+        GLuint query;
+        gl->glGenQueries(1, &query);
+        queries.push_back(query);
+    }
+    return queries[currentGpuFrame->usedQueries++];
+}
+
+void Profiler::beginZone(char const *name, int index, bool gpu) {
+    size_t gpuZone = 0;
+    if (gpu && currentGpuFrame != nullptr) {
+        gpuZone = currentGpuFrame->zones.size();
+        currentGpuFrame->zones.push_back({name, index, currentGpuFrame->usedQueries, 0});
+        gl->glQueryCounter(nextQuery(), GL_TIMESTAMP);
+        openGpuZones.push_back({name, index, 0, gpuZone});
+    }
+
+    openCpuZones.push_back({name, index, now(), gpuZone});
+}
+
+void Profiler::endZone(bool gpu) {
+    OpenZone zone = openCpuZones.back();
+    openCpuZones.pop_back();
+
+    int64_t end = now();
+    record({zone.name, zone.index, Track::CPU, frameCount, zone.start, end - zone.start});
+
+    if (gpu && currentGpuFrame != nullptr) {
+        OpenZone gpuZone = openGpuZones.back();
+        openGpuZones.pop_back();
+
+        currentGpuFrame->zones[gpuZone.gpuZone].endQuery = currentGpuFrame->usedQueries;
+        gl->glQueryCounter(nextQuery(), GL_TIMESTAMP);
+    }
+}
+
+void Profiler::collect(GpuFrame &gpuFrame) {
+    // Queries finish in order, so if the last one is available all of them are
+    GLint available = 0;
+    gl->glGetQueryObjectiv(gpuFrame.queries[gpuFrame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+
+    auto timestamp = [&](size_t query) {
+        GLuint64 result = 0;
+        gl->glGetQueryObjectui64v(gpuFrame.queries[query], GL_QUERY_RESULT, &result);
+        return static_cast<int64_t>(result);
+    };
+
+    // The first zone is the whole frame, it started when the frame did on the CPU
+    int64_t origin = timestamp(gpuFrame.zones.front().beginQuery);
+    for (auto const &zone : gpuFrame.zones) {
+        int64_t begin = timestamp(zone.beginQuery);
+        int64_t end = timestamp(zone.endQuery);
+        record({zone.name, zone.index, Track::GPU, gpuFrame.frame, gpuFrame.cpuStart + begin - origin, end - begin});
+    }
+
+    gpuFrame.pending = false;
+}
+
+void Profiler::recordLatency(char const *name, Clock::time_point from, Clock::time_point to) {
+    if (!enabled) return;
+
+    auto nanoseconds = [](Clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    };
+    record({name, -1, Track::LATENCY, frameCount, nanoseconds(from - epoch), nanoseconds(to - from)});
+}
+
+void Profiler::record(Event const &event) {
+    events[(firstEvent + eventCount) % events.size()] = event;
+    if (eventCount < events.size()) {
+        ++eventCount;
+    } else {
+        firstEvent = (firstEvent + 1) % events.size();
+    }
+
+    Samples &zoneSamples = samples[{event.name, event.index, event.track}];
+    float milliseconds = static_cast<float>(event.duration) / 1e6F;
+    if (zoneSamples.durations.size() < HISTORY) {
+        zoneSamples.durations.push_back(milliseconds);
+    } else {
+        zoneSamples.durations[zoneSamples.next] = milliseconds;
+    }
+    zoneSamples.next = (zoneSamples.next + 1) % HISTORY;
+}
+
+QString Profiler::zoneName(char const *name, int index) {
+    return index < 0 ? QString(name) : QString("%1 %2").arg(name).arg(index);
+}
+
+char const *Profiler::trackName(Track track) {
+    switch (track) {
+    case Track::CPU:
+        return "cpu";
+    case Track::GPU:
+        return "gpu";
+    case Track::LATENCY:
+        return "latency";
+    }
+    return "";
+}
+
+std::vector<Profiler::Statistics> Profiler::getStatistics() const {
+    std::vector<Statistics> statistics;
+    std::vector<float> sorted;
+
+    for (auto const &pair : samples) {
+        sorted = pair.second.durations;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&](double p) {
+            size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+            return static_cast<double>(sorted[rank]);
+        };
+
+        statistics.push_back({
+            zoneName(pair.first.name, pair.first.index),
+            pair.first.track,
+            percentile(0.50),
+            percentile(0.95),
+            percentile(0.99)
+        });
+    }
+
+    return statistics;
+}
+
+void Profiler::paintOverlay(QPainter &painter) const {
+    std::vector<Statistics> statistics = getStatistics();
+
+    int const lineHeight = 14;
+    QRect background{0, 0, 460, lineHeight * static_cast<int>(statistics.size() + 2) + 8};
+    painter.fillRect(background, QColor(0, 0, 0, 170));
+
+    QFont font("monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    font.setPointSize(8);
+    painter.setFont(font);
+    painter.setPen(QColor(255, 255, 255));
+
+    int y = lineHeight;
+    painter.drawText(8, y, QString("%1     p50     p95     p99 ms  (%2 GPU frames dropped, %3 allocations)")
+                               .arg("zone", -30).arg(static_cast<qulonglong>(droppedFrames))
+                               .arg(static_cast<qulonglong>(heapAllocations)));
+    for (auto const &zone : statistics) {
+        y += lineHeight;
+        painter.drawText(8, y, QString("%1 %2 %3 %4")
+                                   .arg(QString("%1 (%2)").arg(zone.name).arg(trackName(zone.track)), -30)
+                                   .arg(zone.p50, 7, 'f', 2)
+                                   .arg(zone.p95, 7, 'f', 2)
+                                   .arg(zone.p99, 7, 'f', 2));
+    }
+}
+
+bool Profiler::exportChromeTrace(QString const &fileName) const {
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qWarning() << "Could not write trace to" << fileName;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"GL thread\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":2,\"args\":{\"name\":\"Input latency\"}}";
+
+    // Timestamps and durations are in microseconds
+    for (size_t i = 0; i < eventCount; ++i) {
+        Event const &event = events[(firstEvent + i) % events.size()];
+        out << ",\n{\"name\":\"" << zoneName(event.name, event.index)
+            << "\",\"cat\":\"" << trackName(event.track)
+            << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << static_cast<int>(event.track)
+            << ",\"ts\":" << QString::number(event.start / 1000.0, 'f', 3)
+            << ",\"dur\":" << QString::number(event.duration / 1000.0, 'f', 3)
+            << "}";
+    }
+    out << "\n]}\n";
+
+    qDebug() << "Wrote" << eventCount << "trace events to" << fileName;
+    return true;
+}
@@ -0,0 +1,191 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QPainter>
+#include <QString>
+
+/*
+ * Measures how long the parts of a frame take, on the CPU and on the GPU.
+ *
+ * Zones are scoped and may nest. GPU zones are timed with timestamp queries,
+ * which, unlike GL_TIME_ELAPSED queries, can nest. The queries of the last
+ * FRAME_LATENCY frames are kept in a ring and only read once they are
+ * available, so the profiler never waits on the GPU. A frame whose queries are
+ * still pending when its slot comes around again is dropped.
+ *
+ * When disabled, zones cost a branch and nothing is recorded.
+ *
+ * Only to be used from the GL thread.
+ */
+class Profiler
+{
+public:
+    // Frames of GPU queries in flight
+    static constexpr size_t FRAME_LATENCY = 4;
+    // Frames kept for the percentiles and the trace export
+    static constexpr size_t HISTORY = 240;
+    // Events kept per frame of the HISTORY, on average. Frames with more
+    // push the oldest events out of the trace early.
+    static constexpr size_t EVENTS_PER_FRAME = 256;
+
+    using Clock = std::chrono::steady_clock;
+
+    // What a duration was measured on
+    enum class Track {
+        CPU,
+        GPU,
+        // From an input event to the presentation of the first frame showing it
+        LATENCY
+    };
+
+    /*
+     * A zone timed on the CPU only.
+     */
+    class CpuZone
+    {
+    public:
+        CpuZone(Profiler &profiler, char const *name, int index = -1);
+        ~CpuZone();
+
+    private:
+        Profiler &profiler;
+        bool active;
+    };
+
+    /*
+     * A zone timed both on the CPU and on the GPU.
+     */
+    class Zone
+    {
+    public:
+        Zone(Profiler &profiler, char const *name, int index = -1);
+        ~Zone();
+
+    private:
+        Profiler &profiler;
+        bool active;
+    };
+
+    struct Statistics {
+        QString name;
+        Track track;
+        // In milliseconds, over the last HISTORY frames
+        double p50;
+        double p95;
+        double p99;
+    };
+
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLFunctions_3_3_Core *gl);
+    void destroy();
+
+    // Only to be toggled in between frames
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    void beginFrame();
+    void endFrame();
+
+    std::vector<Statistics> getStatistics() const;
+
+    // Shown in the overlay, as measured by the caller over its frame
+    void setHeapAllocations(uint64_t perFrame) { heapAllocations = perFrame; }
+
+    // Records a latency measured by the caller, from one time to a later one
+    void recordLatency(char const *name, Clock::time_point from, Clock::time_point to);
+
+    void paintOverlay(QPainter &painter) const;
+
+    /*
+     * Writes the zones of the last HISTORY frames in the Chrome trace event
+     * format, for chrome://tracing or Perfetto.
+     */
+    bool exportChromeTrace(QString const &fileName) const;
+
+private:
+    struct Event {
+        char const *name;
+        int index;
+        Track track;
+        uint64_t frame;
+        // Nanoseconds since the profiler was initialized
+        int64_t start;
+        int64_t duration;
+    };
+
+    struct GpuZone {
+        char const *name;
+        int index;
+        size_t beginQuery;
+        size_t endQuery;
+    };
+
+    struct GpuFrame {
+        bool pending = false;
+        uint64_t frame = 0;
+        // When the frame started on the CPU, to line up the GPU clock with
+        int64_t cpuStart = 0;
+        std::vector<GLuint> queries;
+        size_t usedQueries = 0;
+        std::vector<GpuZone> zones;
+    };
+
+    struct OpenZone {
+        char const *name;
+        int index;
+        int64_t start;
+        size_t gpuZone;
+    };
+
+    // Identifies a zone across frames, for the percentiles
+    struct Key {
+        char const *name;
+        int index;
+        Track track;
+
+        bool operator<(Key const &other) const;
+    };
+
+    struct Samples {
+        std::vector<float> durations;
+        size_t next = 0;
+    };
+
+    int64_t now() const;
+    GLuint nextQuery();
+    void beginZone(char const *name, int index, bool gpu);
+    void endZone(bool gpu);
+    void collect(GpuFrame &gpuFrame);
+    void record(Event const &event);
+
+    static QString zoneName(char const *name, int index);
+    static char const *trackName(Track track);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    bool enabled = true;
+    Clock::time_point epoch;
+    uint64_t frameCount = 0;
+
+    std::array<GpuFrame, FRAME_LATENCY> gpuFrames;
+    GpuFrame *currentGpuFrame = nullptr;
+    std::vector<OpenZone> openCpuZones;
+    std::vector<OpenZone> openGpuZones;
+
+    // A ring of HISTORY * EVENTS_PER_FRAME, allocated once by initialize()
+    // so recording an event never touches the heap
+    std::vector<Event> events;
+    size_t firstEvent = 0;
+    size_t eventCount = 0;
+    std::map<Key, Samples> samples;
+    size_t droppedFrames = 0;
+    uint64_t heapAllocations = 0;
+};
+
+#endif // PROFILER_H
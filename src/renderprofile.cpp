@@ -0,0 +1,168 @@
+#include "renderprofile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <QDebug>
+
+// Set by the build type, see CMakeLists.txt
+#ifndef MANY_WORLDS_DEFAULT_PROFILE
+#define MANY_WORLDS_DEFAULT_PROFILE 1
+#endif
+
+namespace {
+
+RenderSettings currentSettings = RenderSettings::forProfile(
+    static_cast<RenderProfile>(MANY_WORLDS_DEFAULT_PROFILE));
+
+bool parseProfile(QString const &name, RenderProfile &profile) {
+    for (RenderProfile candidate : {RenderProfile::DEBUG, RenderProfile::PROFILE, RenderProfile::RELEASE}) {
+        if (name.compare(toString(candidate), Qt::CaseInsensitive) == 0) {
+            profile = candidate;
+            return true;
+        }
+    }
+    qWarning() << "Unknown render profile" << name << "- expected debug, profile or release";
+    return false;
+}
+
+}
+
+RenderSettings RenderSettings::forProfile(RenderProfile profile) {
+    RenderSettings settings;
+    settings.profile = profile;
+
+    switch (profile) {
+    case RenderProfile::DEBUG:
+        settings.debugContext = true;
+        settings.logging = true;
+        settings.synchronousLogging = true;
+        settings.minimumSeverity = QOpenGLDebugMessage::NotificationSeverity;
+        settings.glErrorChecks = GL_ERROR_CHECKS::PER_PASS;
+        settings.profiler = true;
+        break;
+    case RenderProfile::PROFILE:
+        settings.debugContext = true;
+        settings.logging = true;
+        settings.synchronousLogging = false;
+        settings.minimumSeverity = QOpenGLDebugMessage::MediumSeverity;
+        settings.glErrorChecks = GL_ERROR_CHECKS::PER_FRAME;
+        settings.profiler = true;
+        break;
+    case RenderProfile::RELEASE:
+        settings.debugContext = false;
+        settings.logging = false;
+        settings.synchronousLogging = false;
+        settings.minimumSeverity = QOpenGLDebugMessage::HighSeverity;
+        settings.glErrorChecks = GL_ERROR_CHECKS::NONE;
+        settings.profiler = false;
+        break;
+    }
+
+    return settings;
+}
+
+RenderSettings RenderSettings::fromCommandLine(int argc, char *argv[]) {
+    RenderProfile profile = static_cast<RenderProfile>(MANY_WORLDS_DEFAULT_PROFILE);
+    bool indirectDraws = true;
+    QString sceneFile;
+    bool predictCamera = false;
+    QString recordFile;
+    QString replayFile;
+    bool headless = false;
+    bool timeDrawLists = false;
+    size_t textureBudget = RenderSettings{}.textureBudget;
+    size_t worldBudget = RenderSettings{}.worldBudget;
+    float worldLoadDistance = RenderSettings{}.worldLoadDistance;
+    float worldEvictDistance = RenderSettings{}.worldEvictDistance;
+    float frameBudget = RenderSettings{}.frameBudget;
+    int viewCount = 1;
+    float stereoEyeDistance = 0;
+    int fullPortals = RenderSettings{}.fullPortals;
+    int impostorRefreshes = RenderSettings{}.impostorRefreshes;
+
+    QString environment = qEnvironmentVariable("MANY_WORLDS_PROFILE");
+    if (!environment.isEmpty()) {
+        parseProfile(environment, profile);
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            parseProfile(argv[++i], profile);
+        } else if (std::strncmp(argv[i], "--profile=", 10) == 0) {
+            parseProfile(argv[i] + 10, profile);
+        } else if (std::strcmp(argv[i], "--direct-draws") == 0) {
+            indirectDraws = false;
+        } else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+            sceneFile = QString::fromLocal8Bit(argv[++i]);
+        } else if (std::strcmp(argv[i], "--predict-camera") == 0) {
+            predictCamera = true;
+        } else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = QString::fromLocal8Bit(argv[++i]);
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = QString::fromLocal8Bit(argv[++i]);
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (std::strcmp(argv[i], "--time-draw-lists") == 0) {
+            timeDrawLists = true;
+        } else if (std::strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc) {
+            textureBudget = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) * 1024 * 1024;
+        } else if (std::strcmp(argv[i], "--world-budget") == 0 && i + 1 < argc) {
+            worldBudget = static_cast<size_t>(std::max(1, std::atoi(argv[++i]))) * 1024 * 1024;
+        } else if (std::strcmp(argv[i], "--world-load-distance") == 0 && i + 1 < argc) {
+            worldLoadDistance = std::max(0.0F, static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--world-evict-distance") == 0 && i + 1 < argc) {
+            worldEvictDistance = std::max(0.0F, static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc) {
+            frameBudget = std::max(0.0F, static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--views") == 0 && i + 1 < argc) {
+            viewCount = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--stereo") == 0 && i + 1 < argc) {
+            stereoEyeDistance = std::max(0.0F, static_cast<float>(std::atof(argv[++i])));
+        } else if (std::strcmp(argv[i], "--full-portals") == 0 && i + 1 < argc) {
+            fullPortals = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--impostor-refreshes") == 0 && i + 1 < argc) {
+            impostorRefreshes = std::max(0, std::atoi(argv[++i]));
+        }
+    }
+
+    RenderSettings settings = forProfile(profile);
+    settings.indirectDraws = indirectDraws;
+    settings.sceneFile = sceneFile;
+    settings.predictCamera = predictCamera;
+    settings.recordFile = recordFile;
+    settings.replayFile = replayFile;
+    settings.headless = headless;
+    settings.timeDrawLists = timeDrawLists;
+    settings.textureBudget = textureBudget;
+    settings.worldBudget = worldBudget;
+    settings.worldLoadDistance = worldLoadDistance;
+    settings.worldEvictDistance = worldEvictDistance;
+    settings.frameBudget = frameBudget;
+    settings.viewCount = viewCount;
+    settings.stereoEyeDistance = stereoEyeDistance;
+    settings.fullPortals = fullPortals;
+    settings.impostorRefreshes = impostorRefreshes;
+    return settings;
+}
+
+RenderSettings const &RenderSettings::current() {
+    return currentSettings;
+}
+
+void RenderSettings::setCurrent(RenderSettings const &settings) {
+    currentSettings = settings;
+}
+
+QString toString(RenderProfile profile) {
+    switch (profile) {
+    case RenderProfile::DEBUG:
+        return "debug";
+    case RenderProfile::PROFILE:
+        return "profile";
+    case RenderProfile::RELEASE:
+        return "release";
+    }
+    return "unknown";
+}
@@ -0,0 +1,106 @@
+#ifndef RENDERPROFILE_H
+#define RENDERPROFILE_H
+
+#include <QOpenGLDebugMessage>
+#include <QString>
+
+/*
+ * How much diagnostics the renderer runs with.
+ *
+ * DEBUG: a debug context, synchronous logging of every GL message and a
+ * glGetError check after every pass. For tracking down GL errors.
+ * PROFILE: a debug context with asynchronous logging of medium and high
+ * severity messages only, a glGetError check once per frame and the
+ * profiler running.
+ * RELEASE: no debug context, no logging, no error checks, and the profiler
+ * only runs while its overlay is shown.
+ */
+enum class RenderProfile {
+    DEBUG = 0,
+    PROFILE,
+    RELEASE
+};
+
+struct RenderSettings
+{
+    enum class GL_ERROR_CHECKS {
+        NONE,
+        PER_FRAME,
+        PER_PASS
+    };
+
+    RenderProfile profile = RenderProfile::PROFILE;
+
+    bool debugContext = true;
+    bool logging = true;
+    bool synchronousLogging = false;
+    // Messages below this severity are filtered out by the driver
+    QOpenGLDebugMessage::Severity minimumSeverity = QOpenGLDebugMessage::MediumSeverity;
+    GL_ERROR_CHECKS glErrorChecks = GL_ERROR_CHECKS::PER_FRAME;
+    bool profiler = true;
+    // Cull and draw on the GPU where the context supports GL 4.3 (see IndirectDraws)
+    bool indirectDraws = true;
+    // The scene to load, in either form of SceneFile. Empty for the built-in one.
+    QString sceneFile;
+    // Draw the camera extrapolated from the last tick rather than interpolated
+    // between the last two, which shows input a tick sooner
+    bool predictCamera = false;
+    // Where to record the input of the session to, if anywhere
+    QString recordFile;
+    // A recording to replay instead of live input, at uncapped speed, with or
+    // without rendering it
+    QString replayFile;
+    bool headless = false;
+    // With headless, build the draw lists of every replayed frame on the CPU
+    // and time that instead, see DrawListBenchmark
+    bool timeDrawLists = false;
+    // Bytes the mip levels of all textures may take up, see TextureStreamer
+    size_t textureBudget = 256 * 1024 * 1024;
+    // Bytes the resident portal worlds may take up, and the camera distances
+    // to a portal at which its world loads and within which it is never
+    // evicted, see WorldStreamer
+    size_t worldBudget = 64 * 1024 * 1024;
+    float worldLoadDistance = 8;
+    float worldEvictDistance = 12;
+    // GPU milliseconds a frame may take before its resolution is scaled down,
+    // 0 to always render at the window's (see DynamicResolution)
+    float frameBudget = 1000.0F / 60.0F;
+    // Views rendered side by side in one pass, see MultiView: viewCount
+    // turned evenly around the camera or, if stereoEyeDistance is above 0, a
+    // stereo pair
+    int viewCount = 1;
+    float stereoEyeDistance = 0;
+    // Portals drawn in full, the nearest ones (at most 254, one per stencil
+    // value), and impostors refreshed per frame, see ImpostorAtlas
+    int fullPortals = 16;
+    int impostorRefreshes = 4;
+
+    static RenderSettings forProfile(RenderProfile profile);
+
+    /*
+     * The profile the build defaults to, overridden by the MANY_WORLDS_PROFILE
+     * environment variable, overridden by a --profile argument. Each is one of
+     * "debug", "profile" or "release". --direct-draws keeps to the GL 3.3 draw
+     * path, even where the indirect one is supported. --scene <file> loads a
+     * scene from disk. --predict-camera extrapolates the camera. --record
+     * <file> records the session's input, --replay <file> replays it, in a
+     * window or, with --headless, only through the simulation.
+     * --texture-budget <megabytes> sets the texture memory budget,
+     * --world-budget <megabytes> that of the portal worlds, which load within
+     * --world-load-distance <d> of their portals and stay within
+     * --world-evict-distance <d>. --frame-budget <milliseconds> sets the GPU
+     * frame time budget. --views <n>
+     * renders n views side by side, --stereo <eye distance> a stereo pair.
+     * --full-portals <k> draws only the k nearest portals in full, the others
+     * as impostors, of which --impostor-refreshes <n> are refreshed per frame.
+     */
+    static RenderSettings fromCommandLine(int argc, char *argv[]);
+
+    // The settings of this run, set once at startup
+    static RenderSettings const &current();
+    static void setCurrent(RenderSettings const &settings);
+};
+
+QString toString(RenderProfile profile);
+
+#endif // RENDERPROFILE_H
@@ -0,0 +1,67 @@
+#include "rendertarget.h"
+
+#include <QDebug>
+
+void RenderTarget::initialize(QOpenGLFunctions_3_3_Core *gl) {
+    this->gl = gl;
+}
+
+void RenderTarget::destroy() {
+    if (gl == nullptr) return;
+
+    release();
+    gl = nullptr;
+}
+
+void RenderTarget::release() {
+    gl->glDeleteFramebuffers(1, &framebuffer);
+    gl->glDeleteTextures(1, &color);
+    gl->glDeleteTextures(1, &depthStencil);
+    framebuffer = 0;
+    color = 0;
+    depthStencil = 0;
+    width = 0;
+    height = 0;
+}
+
+void RenderTarget::resize(int width, int height) {
+    if (width == this->width && height == this->height) {
+        return;
+    }
+    release();
+    this->width = width;
+    this->height = height;
+
+    // Sampled in between pixels when scaled up
+    gl->glGenTextures(1, &color);
+    gl->glBindTexture(GL_TEXTURE_2D, color);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // Depth does not interpolate across edges, so it is sampled as is
+    gl->glGenTextures(1, &depthStencil);
+    gl->glBindTexture(GL_TEXTURE_2D, depthStencil);
+    gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL,
+                     GL_UNSIGNED_INT_24_8, nullptr);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl->glGenFramebuffers(1, &framebuffer);
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+    gl->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthStencil, 0);
+    if (gl->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        qWarning() << "Render target of" << width << "x" << height << "is incomplete";
+    }
+}
+
+void RenderTarget::bind(int viewportWidth, int viewportHeight) {
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gl->glViewport(0, 0, viewportWidth, viewportHeight);
+}
@@ -0,0 +1,45 @@
+#ifndef RENDERTARGET_H
+#define RENDERTARGET_H
+
+#include <QOpenGLFunctions_3_3_Core>
+
+/*
+ * An offscreen framebuffer with a colour and a depth / stencil texture, both
+ * of which can be sampled afterwards.
+ *
+ * Passes at a reduced scale render to the lower left corner of the target,
+ * so changing the scale only changes the viewport and never reallocates.
+ *
+ * Only to be used from the GL thread.
+ */
+class RenderTarget
+{
+public:
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLFunctions_3_3_Core *gl);
+    void destroy();
+
+    // (Re)allocates the textures if the size changed
+    void resize(int width, int height);
+
+    // Binds the framebuffer, and sets the viewport to the part rendered to
+    void bind(int viewportWidth, int viewportHeight);
+
+    GLuint getFramebuffer() const { return framebuffer; }
+    GLuint getColor() const { return color; }
+    GLuint getDepthStencil() const { return depthStencil; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    void release();
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depthStencil = 0;
+    int width = 0;
+    int height = 0;
+};
+
+#endif // RENDERTARGET_H
@@ -0,0 +1,142 @@
+#include "mainview.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * With dynamic resolution, a frame is rendered to the lower left of
+ * frameTarget, at the scene scale, and scaled up to the window at the end.
+ *
+ * A portal world with a scale of its own is rendered to portalTarget
+ * instead, under a stencil of its own there, and composited into the frame
+ * under the portal's stencil. The composite writes the depth of the world
+ * too, so the depth readback and the Hi-Z pyramids see the frame as if the
+ * world had been drawn into it directly.
+ */
+
+namespace {
+
+// Of the upscale at the lowest scene scale, less sharpening the less the frame was scaled down
+constexpr float MAX_SHARPNESS = 0.5F;
+
+int scaled(int size, float scale) {
+    return std::max(1, static_cast<int>(std::lround(size * scale)));
+}
+
+}
+
+/**
+ * @brief MainView::bindFrameTarget Binds what this frame renders to, and
+ * sets renderWidth and renderHeight to the size it renders at.
+ */
+void MainView::bindFrameTarget() {
+    int windowWidth = static_cast<int>(width() * devicePixelRatioF());
+    int windowHeight = static_cast<int>(height() * devicePixelRatioF());
+    if (!dynamicResolution.isEnabled()) {
+        renderWidth = windowWidth;
+        renderHeight = windowHeight;
+        return;
+    }
+
+    renderWidth = scaled(windowWidth, dynamicResolution.getSceneScale());
+    renderHeight = scaled(windowHeight, dynamicResolution.getSceneScale());
+    frameTarget.resize(windowWidth, windowHeight);
+    frameTarget.bind(renderWidth, renderHeight);
+}
+
+/**
+ * @brief MainView::paintPortalWorld Draws the world behind a portal, where
+ * the portal is on screen.
+ * @param portal The portal.
+ * @param stencilVal The stencil value the world is drawn at.
+ */
+void MainView::paintPortalWorld(size_t portal, int stencilVal) {
+    int pass = static_cast<int>(portal) + 1;
+    float scale = dynamicResolution.getPortalScale(portal);
+    if (!dynamicResolution.isEnabled() || scale >= 1.0F) {
+        setPortalStencil(portal, stencilVal);
+        glStencilFunc(GL_EQUAL, stencilVal, 0xFF);
+        paintDrawList(portalDrawLists[portal], pass);
+        return;
+    }
+
+    int portalWidth = scaled(renderWidth, scale);
+    int portalHeight = scaled(renderHeight, scale);
+    portalTarget.resize(frameTarget.getWidth(), frameTarget.getHeight());
+    portalTarget.bind(portalWidth, portalHeight);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, portalWidth, portalHeight);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+
+    setPortalStencil(portal, 1);
+    glStencilFunc(GL_EQUAL, 1, 0xFF);
+    paintDrawList(portalDrawLists[portal], pass);
+
+    frameTarget.bind(renderWidth, renderHeight);
+    setPortalStencil(portal, stencilVal);
+    glStencilFunc(GL_EQUAL, stencilVal, 0xFF);
+
+    QOpenGLShaderProgram &shaderProgram = shaders[ShaderType::PORTAL_COMPOSITE];
+    shaderProgram.bind();
+    shaderProgram.setUniformValue("sourceColor", 0);
+    shaderProgram.setUniformValue("sourceDepth", 1);
+    shaderProgram.setUniformValue("sourceScale",
+                                  QVector2D{static_cast<float>(portalWidth) / portalTarget.getWidth(),
+                                            static_cast<float>(portalHeight) / portalTarget.getHeight()});
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, portalTarget.getDepthStencil());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, portalTarget.getColor());
+
+    setViewClipping(false);
+    glBindVertexArray(screenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    setViewClipping(true);
+
+    shaderProgram.release();
+}
+
+/**
+ * @brief MainView::upscaleFrame Scales the frame up to the window, sharpened
+ * by how far it was scaled down.
+ */
+void MainView::upscaleFrame() {
+    if (!dynamicResolution.isEnabled()) return;
+    Profiler::Zone zone{profiler, "upscaleFrame"};
+
+    int windowWidth = frameTarget.getWidth();
+    int windowHeight = frameTarget.getHeight();
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    glViewport(0, 0, windowWidth, windowHeight);
+    glDisable(GL_DEPTH_TEST);
+
+    DynamicResolution::Settings const &settings = dynamicResolution.getSettings();
+    float scale = dynamicResolution.getSceneScale();
+    float sharpness = settings.minScale < 1 ? MAX_SHARPNESS * (1 - scale) / (1 - settings.minScale) : 0.0F;
+
+    QOpenGLShaderProgram &shaderProgram = shaders[ShaderType::UPSCALE];
+    shaderProgram.bind();
+    shaderProgram.setUniformValue("source", 0);
+    shaderProgram.setUniformValue("sourceScale", QVector2D{static_cast<float>(renderWidth) / windowWidth,
+                                                           static_cast<float>(renderHeight) / windowHeight});
+    shaderProgram.setUniformValue("texelSize", QVector2D{1.0F / windowWidth, 1.0F / windowHeight});
+    shaderProgram.setUniformValue("sharpness", sharpness);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, frameTarget.getColor());
+
+    glBindVertexArray(screenVao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    shaderProgram.release();
+    glEnable(GL_DEPTH_TEST);
+}
+
+void MainView::destroyRenderTargets() {
+    dynamicResolution.destroy();
+    frameTarget.destroy();
+    portalTarget.destroy();
+    glDeleteVertexArrays(1, &screenVao);
+    screenVao = 0;
+}
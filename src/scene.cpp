@@ -1,17 +1,19 @@
 #include "scene.h"
 
+#include <cmath>
+
 Scene Scene::createScene0() {
     Scene scene;
-    scene.texturedObjects.emplace_back(QVector3D{0,0,-10});
+    scene.texturedObjects.add(QVector3D{0,0,-10});
 
     // Portal 1 - Simple scaling
     QMatrix4x4 portal1Effect;
     portal1Effect.setToIdentity();
     portal1Effect.scale(2);
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
         QVector3D{0,0,0},
         portal1Effect
-    });
+    );
 
     return scene;
 
@@ -19,17 +21,17 @@ Scene Scene::createScene0() {
 
 Scene Scene::createScene1() {
     Scene scene;
-    scene.texturedObjects.emplace_back(QVector3D{0,0,-10});
+    scene.texturedObjects.add(QVector3D{0,0,-10});
 
     // Portal 2 - Complex affine
     QMatrix4x4 portal2Effect;
     portal2Effect.setToIdentity();
     portal2Effect.rotate(45,{1,1,0});
     portal2Effect.scale(3,2,1);
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
         QVector3D{0,0,0},
         portal2Effect
-    });
+    );
 
     return scene;
 
@@ -37,16 +39,16 @@ Scene Scene::createScene1() {
 
 Scene Scene::createScene2() {
     Scene scene;
-    scene.texturedObjects.emplace_back(QVector3D{0,0,-10});
+    scene.texturedObjects.add(QVector3D{0,0,-10});
 
     // Portal 3 - Normal Map
     QMatrix4x4 portal3Effect;
     portal3Effect.setToIdentity();
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
                                  QVector3D{0,0,0},
                                  portal3Effect,
                                  ShaderType::NORMAL
-    });
+    );
 
     return scene;
 
@@ -54,37 +56,115 @@ Scene Scene::createScene2() {
 
 Scene Scene::createScene3() {
     Scene scene;
-    scene.texturedObjects.emplace_back(QVector3D{0,0,-10});
-    scene.texturedObjects.emplace_back(QVector3D{10,0,-10});
-    scene.texturedObjects.emplace_back(QVector3D{-10,0,-10});
+    scene.texturedObjects.add(QVector3D{0,0,-10});
+    scene.texturedObjects.add(QVector3D{10,0,-10});
+    scene.texturedObjects.add(QVector3D{-10,0,-10});
 
     // Portal 1 - Simple scaling
     QMatrix4x4 portal1Effect;
     portal1Effect.setToIdentity();
     portal1Effect.scale(3);
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
         QVector3D{0,0,0},
         portal1Effect
-    });
+    );
 
     // Portal 2 - Complex affine
     QMatrix4x4 portal2Effect;
     portal2Effect.setToIdentity();
     portal2Effect.scale(.5);
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
         QVector3D{10,0,0},
         portal2Effect
-    });
+    );
 
     // Portal 3 - Normal Map
     QMatrix4x4 portal3Effect;
     portal3Effect.setToIdentity();
-    scene.portalObjects.push_back({
+    scene.portalObjects.add(
                                  QVector3D{-10,0,0},
                                  portal3Effect,
                                  ShaderType::NORMAL
-    });
+    );
 
     return scene;
 }
 
+Scene Scene::createScene4() {
+    Scene scene;
+    scene.texturedObjects.add(QVector3D{0,0,-10});
+
+    // World 0 - A ring of cats
+    WorldDescription ring;
+    for (int i = 0; i < 8; ++i) {
+        float angle = static_cast<float>(i * 2 * M_PI / 8);
+        ring.objects.push_back({
+            ":/models/cat.obj",
+            ":/textures/cat_diff.png",
+            QVector3D{8 * std::cos(angle), 0, -10 + 8 * std::sin(angle)}
+        });
+    }
+    scene.worlds.push_back(ring);
+
+    // World 1 - A row of cats
+    WorldDescription row;
+    for (int i = -2; i <= 2; ++i) {
+        row.objects.push_back({
+            ":/models/cat.obj",
+            ":/textures/cat_diff.png",
+            QVector3D{5.0F * i, 0, -20}
+        });
+    }
+    scene.worlds.push_back(row);
+
+    // Portal 1 - Leads into the ring world
+    QMatrix4x4 portal1Effect;
+    portal1Effect.setToIdentity();
+    scene.portalObjects.add(
+        QVector3D{-5,0,0},
+        portal1Effect,
+        ShaderType::PHONG,
+        0
+    );
+
+    // Portal 2 - Leads into the row world, rendered with normals
+    QMatrix4x4 portal2Effect;
+    portal2Effect.setToIdentity();
+    scene.portalObjects.add(
+        QVector3D{5,0,0},
+        portal2Effect,
+        ShaderType::NORMAL,
+        1
+    );
+
+    return scene;
+}
+
+Scene Scene::createScene5() {
+    Scene scene;
+
+    // A large grid of cats, to benchmark with
+    for (int i = 0; i < 32; ++i) {
+        for (int j = 0; j < 32; ++j) {
+            scene.texturedObjects.add(QVector3D{4.0F * (i - 16), 0, -10 - 4.0F * j});
+        }
+    }
+
+    // A row of portals, alternating between the effects of the other scenes
+    for (int i = 0; i < 8; ++i) {
+        QMatrix4x4 portalEffect;
+        portalEffect.setToIdentity();
+        if (i % 2 == 0) {
+            portalEffect.scale(2);
+        } else {
+            portalEffect.rotate(45,{1,1,0});
+        }
+        scene.portalObjects.add(
+            QVector3D{4.0F * (i - 4), 0, 0},
+            portalEffect,
+            i % 3 == 0 ? ShaderType::NORMAL : ShaderType::PHONG
+        );
+    }
+
+    return scene;
+}
@@ -2,18 +2,31 @@
 #define SCENE_H
 
 #include <vector>
-#include "texturedobject.h"
-#include "portalobject.h"
+
+#include <QString>
+
+#include "scenestore.h"
+#include "world.h"
 
 struct Scene
 {
-    std::vector<TexturedObject> texturedObjects;
-    std::vector<PortalObject> portalObjects;
+    ObjectTable texturedObjects;
+    PortalTable portalObjects;
+
+    // The worlds portals can lead to, streamed in on demand
+    std::vector<WorldDescription> worlds;
+
+    // What the objects and portals of the scene itself are drawn with
+    QString objectMesh = ":/models/cat.obj";
+    QString objectTexture = ":/textures/cat_diff.png";
+    QString portalMesh = ":/models/portal.obj";
 
     static Scene createScene0();
     static Scene createScene1();
     static Scene createScene2();
     static Scene createScene3();
+    static Scene createScene4();
+    static Scene createScene5();
 };
 
 #endif // SCENE_H
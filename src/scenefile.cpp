@@ -0,0 +1,546 @@
+#include "scenefile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QtGlobal>
+
+namespace {
+
+constexpr char MAGIC[4] = {'M', 'W', 'S', 'B'};
+constexpr uint32_t VERSION = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t objectCount;
+    uint32_t portalCount;
+    uint32_t worldCount;
+    uint32_t worldObjectCount;
+    uint32_t stringCount;
+    uint32_t stringBytes;
+    // Indices into the string table
+    uint32_t objectMesh;
+    uint32_t objectTexture;
+    uint32_t portalMesh;
+    uint32_t reserved;
+};
+
+struct ObjectRecord {
+    float position[3];
+};
+
+struct PortalRecord {
+    float position[3];
+    // Column-major, as QMatrix4x4 stores it
+    float effect[16];
+    // The rest of the WorldEffect
+    float spinAxis[3];
+    float spinSpeed;
+    int32_t deformation;
+    float strength;
+    float pulseSpeed;
+    int32_t shaderType;
+    int32_t worldId;
+};
+
+struct WorldRecord {
+    uint32_t firstObject;
+    uint32_t objectCount;
+};
+
+struct WorldObjectRecord {
+    uint32_t modelFile;
+    uint32_t textureFile;
+    float position[3];
+};
+
+// After the header: objects, portals, worlds, world objects, then the string
+// table as stringCount + 1 offsets into the string bytes that follow them
+static_assert(sizeof(FileHeader) == 48, "FileHeader should not be padded");
+static_assert(sizeof(ObjectRecord) == 12, "ObjectRecord should not be padded");
+static_assert(sizeof(PortalRecord) == 112, "PortalRecord should not be padded");
+static_assert(sizeof(WorldRecord) == 8, "WorldRecord should not be padded");
+static_assert(sizeof(WorldObjectRecord) == 20, "WorldObjectRecord should not be padded");
+
+QVector3D toVector(float const from[3]) {
+    return {from[0], from[1], from[2]};
+}
+
+void fromVector(QVector3D const &from, float to[3]) {
+    to[0] = from.x();
+    to[1] = from.y();
+    to[2] = from.z();
+}
+
+// Where the statement being parsed is, for the warnings
+struct TextPosition {
+    QString const &fileName;
+    int line;
+};
+
+QDebug warn(TextPosition const &position) {
+    return qWarning().nospace() << qPrintable(position.fileName) << ":" << position.line << ": ";
+}
+
+bool parseFloats(QStringList const &tokens, int first, int count, float *values, TextPosition const &position) {
+    if (first + count > tokens.size()) {
+        warn(position) << "expected " << count << " numbers after " << tokens[first - 1];
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        bool ok;
+        values[i] = tokens[first + i].toFloat(&ok);
+        if (!ok) {
+            warn(position) << "not a number: " << tokens[first + i];
+            return false;
+        }
+    }
+    return true;
+}
+
+// The number of tokens from first on that are numbers
+int countFloats(QStringList const &tokens, int first) {
+    int count = 0;
+    bool ok = true;
+    while (first + count < tokens.size()) {
+        tokens[first + count].toFloat(&ok);
+        if (!ok) break;
+        ++count;
+    }
+    return count;
+}
+
+bool parseVector(QStringList const &tokens, int first, QVector3D &vector, TextPosition const &position) {
+    float values[3];
+    if (!parseFloats(tokens, first, 3, values, position)) return false;
+    vector = toVector(values);
+    return true;
+}
+
+bool parsePortal(QStringList const &tokens, Scene &scene, TextPosition const &position) {
+    QVector3D portalPosition;
+    if (!parseVector(tokens, 1, portalPosition, position)) return false;
+
+    WorldEffect effect;
+    ShaderType shaderType = ShaderType::PHONG;
+    int worldId = -1;
+
+    int i = 4;
+    while (i < tokens.size()) {
+        QString const &keyword = tokens[i++];
+        float values[16];
+        if (keyword == "shader" && i < tokens.size()) {
+            QString const &name = tokens[i++];
+            if (name == "phong") {
+                shaderType = ShaderType::PHONG;
+            } else if (name == "normal") {
+                shaderType = ShaderType::NORMAL;
+            } else {
+                warn(position) << "unknown shader " << name << ", expected phong or normal";
+                return false;
+            }
+        } else if (keyword == "world" && i < tokens.size()) {
+            bool ok;
+            worldId = tokens[i++].toInt(&ok);
+            if (!ok || worldId < 0) {
+                warn(position) << "not a world id: " << tokens[i - 1];
+                return false;
+            }
+        } else if (keyword == "scale") {
+            int count = countFloats(tokens, i) >= 3 ? 3 : 1;
+            if (!parseFloats(tokens, i, count, values, position)) return false;
+            if (count == 3) {
+                effect.transform.scale(values[0], values[1], values[2]);
+            } else {
+                effect.transform.scale(values[0]);
+            }
+            i += count;
+        } else if (keyword == "rotate") {
+            if (!parseFloats(tokens, i, 4, values, position)) return false;
+            effect.transform.rotate(values[0], values[1], values[2], values[3]);
+            i += 4;
+        } else if (keyword == "translate") {
+            if (!parseFloats(tokens, i, 3, values, position)) return false;
+            effect.transform.translate(values[0], values[1], values[2]);
+            i += 3;
+        } else if (keyword == "matrix") {
+            if (!parseFloats(tokens, i, 16, values, position)) return false;
+            effect.transform = effect.transform * QMatrix4x4{values};
+            i += 16;
+        } else if (keyword == "spin") {
+            if (!parseFloats(tokens, i, 4, values, position)) return false;
+            effect.spinSpeed = values[0];
+            effect.spinAxis = QVector3D{values[1], values[2], values[3]};
+            i += 4;
+        } else if (keyword == "twist" || keyword == "bend") {
+            if (!parseFloats(tokens, i, 1, values, position)) return false;
+            effect.deformation = keyword == "twist" ? WorldEffect::DEFORMATION::TWIST : WorldEffect::DEFORMATION::BEND;
+            effect.strength = values[0];
+            i += 1;
+        } else if (keyword == "pulse") {
+            if (!parseFloats(tokens, i, 1, values, position)) return false;
+            effect.pulseSpeed = values[0];
+            i += 1;
+        } else {
+            warn(position) << "unexpected " << keyword << " in portal";
+            return false;
+        }
+    }
+
+    scene.portalObjects.add(portalPosition, effect, shaderType, worldId);
+    return true;
+}
+
+bool parseStatement(QStringList const &tokens, Scene &scene, TextPosition const &position) {
+    QString const &keyword = tokens[0];
+    if (keyword == "object-mesh" || keyword == "object-texture" || keyword == "portal-mesh") {
+        if (tokens.size() != 2) {
+            warn(position) << keyword << " takes one path";
+            return false;
+        }
+        QString &path = keyword == "object-mesh" ? scene.objectMesh
+                      : keyword == "object-texture" ? scene.objectTexture : scene.portalMesh;
+        path = tokens[1];
+    } else if (keyword == "object") {
+        QVector3D objectPosition;
+        if (!parseVector(tokens, 1, objectPosition, position)) return false;
+        scene.texturedObjects.add(objectPosition);
+    } else if (keyword == "portal") {
+        return parsePortal(tokens, scene, position);
+    } else if (keyword == "world") {
+        if (tokens.size() != 1) {
+            warn(position) << "world takes no arguments, its objects follow it";
+            return false;
+        }
+        scene.worlds.emplace_back();
+    } else if (keyword == "world-object") {
+        if (scene.worlds.empty()) {
+            warn(position) << "world-object before the first world";
+            return false;
+        }
+        WorldObjectDescription object;
+        if (tokens.size() < 3 || !parseVector(tokens, 3, object.position, position)) return false;
+        object.modelFile = tokens[1];
+        object.textureFile = tokens[2];
+        scene.worlds.back().objects.push_back(object);
+    } else {
+        warn(position) << "unknown statement " << keyword;
+        return false;
+    }
+    return true;
+}
+
+// Deduplicates the strings of a scene while it is written
+class StringTable
+{
+public:
+    uint32_t add(QString const &string) {
+        auto it = indices.find(string);
+        if (it != indices.end()) return it->second;
+
+        uint32_t index = static_cast<uint32_t>(offsets.size());
+        offsets.push_back(static_cast<uint32_t>(bytes.size()));
+        bytes.append(string.toUtf8());
+        indices.emplace(string, index);
+        return index;
+    }
+
+    uint32_t size() const { return static_cast<uint32_t>(offsets.size()); }
+
+    void write(QFile &file) {
+        offsets.push_back(static_cast<uint32_t>(bytes.size()));
+        file.write(reinterpret_cast<char const *>(offsets.data()), offsets.size() * sizeof(uint32_t));
+        file.write(bytes);
+        offsets.pop_back();
+    }
+
+    uint32_t byteCount() const { return static_cast<uint32_t>(bytes.size()); }
+
+private:
+    struct Hash {
+        size_t operator()(QString const &string) const { return qHash(string); }
+    };
+
+    std::unordered_map<QString, uint32_t, Hash> indices;
+    std::vector<uint32_t> offsets;
+    QByteArray bytes;
+};
+
+template <typename T>
+void writeRecords(QFile &file, std::vector<T> const &records) {
+    file.write(reinterpret_cast<char const *>(records.data()), records.size() * sizeof(T));
+}
+
+}
+
+bool SceneFile::load(QString const &fileName, Scene &scene) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open scene" << fileName;
+        return false;
+    }
+    QByteArray start = file.read(sizeof(MAGIC));
+    file.close();
+
+    QElapsedTimer timer;
+    timer.start();
+    bool loaded = start == QByteArray(MAGIC, sizeof(MAGIC)) ? loadBinary(fileName, scene)
+                                                             : loadText(fileName, scene);
+    if (loaded) {
+        qDebug() << ":: Loaded scene" << fileName << "with" << scene.texturedObjects.size() << "objects,"
+                 << scene.portalObjects.size() << "portals and" << scene.worlds.size() << "worlds in"
+                 << timer.elapsed() << "ms";
+    }
+    return loaded;
+}
+
+Scene SceneFile::loadOrBuiltIn(QString const &fileName) {
+    Scene scene;
+    if (fileName.isEmpty() || !load(fileName, scene)) {
+        return Scene::createScene3();
+    }
+    return scene;
+}
+
+bool SceneFile::loadText(QString const &fileName, Scene &scene) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Could not open scene" << fileName;
+        return false;
+    }
+
+    scene = Scene{};
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        ++lineNumber;
+
+        int comment = line.indexOf('#');
+        if (comment >= 0) {
+            line.truncate(comment);
+        }
+        QStringList tokens = line.split(" ", Qt::SkipEmptyParts);
+        if (tokens.isEmpty()) continue;
+
+        if (!parseStatement(tokens, scene, {fileName, lineNumber})) {
+            return false;
+        }
+    }
+
+    for (auto const &effect : scene.portalObjects.effects) {
+        if (effect.worldId >= static_cast<int>(scene.worlds.size())) {
+            qWarning() << "Scene" << fileName << "has a portal into world" << effect.worldId << "but only"
+                       << scene.worlds.size() << "worlds";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SceneFile::loadBinary(QString const &fileName, Scene &scene) {
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    qWarning() << "Binary scenes are little endian, compile" << fileName << "from its text form instead";
+    return false;
+#endif
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Could not open scene" << fileName;
+        return false;
+    }
+
+    // Compressed resources cannot be mapped, those are read instead
+    QByteArray contents;
+    uchar const *data = file.map(0, file.size());
+    if (data == nullptr) {
+        contents = file.readAll();
+        data = reinterpret_cast<uchar const *>(contents.constData());
+    }
+
+    auto invalid = [&](char const *reason) {
+        qWarning() << "Invalid binary scene" << fileName << "-" << reason;
+        return false;
+    };
+
+    quint64 size = static_cast<quint64>(file.size());
+    FileHeader header;
+    if (size < sizeof(header)) return invalid("no header");
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) return invalid("wrong magic");
+    if (header.version != VERSION) return invalid("unsupported version");
+
+    quint64 objectsOffset = sizeof(FileHeader);
+    quint64 portalsOffset = objectsOffset + quint64{header.objectCount} * sizeof(ObjectRecord);
+    quint64 worldsOffset = portalsOffset + quint64{header.portalCount} * sizeof(PortalRecord);
+    quint64 worldObjectsOffset = worldsOffset + quint64{header.worldCount} * sizeof(WorldRecord);
+    quint64 stringOffsetsOffset = worldObjectsOffset + quint64{header.worldObjectCount} * sizeof(WorldObjectRecord);
+    quint64 stringBytesOffset = stringOffsetsOffset + (quint64{header.stringCount} + 1) * sizeof(uint32_t);
+    if (stringBytesOffset + header.stringBytes != size) return invalid("wrong size");
+
+    // The string table, checked up front so the records can index it freely
+    std::vector<uint32_t> stringOffsets(header.stringCount + 1);
+    std::memcpy(stringOffsets.data(), data + stringOffsetsOffset, stringOffsets.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < header.stringCount; ++i) {
+        if (stringOffsets[i] > stringOffsets[i + 1]) return invalid("bad string table");
+    }
+    if (stringOffsets.back() != header.stringBytes) return invalid("bad string table");
+
+    std::vector<QString> strings(header.stringCount);
+    char const *stringBytes = reinterpret_cast<char const *>(data + stringBytesOffset);
+    for (size_t i = 0; i < header.stringCount; ++i) {
+        strings[i] = QString::fromUtf8(stringBytes + stringOffsets[i],
+                                       static_cast<int>(stringOffsets[i + 1] - stringOffsets[i]));
+    }
+    auto string = [&](uint32_t index, QString &to) {
+        if (index >= strings.size()) return false;
+        to = strings[index];
+        return true;
+    };
+
+    scene = Scene{};
+    if (!string(header.objectMesh, scene.objectMesh) || !string(header.objectTexture, scene.objectTexture) ||
+        !string(header.portalMesh, scene.portalMesh)) {
+        return invalid("bad string index");
+    }
+
+    scene.texturedObjects.reserve(header.objectCount);
+    for (uint32_t i = 0; i < header.objectCount; ++i) {
+        ObjectRecord record;
+        std::memcpy(&record, data + objectsOffset + i * sizeof(record), sizeof(record));
+        scene.texturedObjects.add(toVector(record.position));
+    }
+
+    scene.portalObjects.reserve(header.portalCount);
+    for (uint32_t i = 0; i < header.portalCount; ++i) {
+        PortalRecord record;
+        std::memcpy(&record, data + portalsOffset + i * sizeof(record), sizeof(record));
+        if (record.shaderType != static_cast<int32_t>(ShaderType::PHONG) &&
+            record.shaderType != static_cast<int32_t>(ShaderType::NORMAL)) {
+            return invalid("bad shader type");
+        }
+        if (record.worldId >= static_cast<int32_t>(header.worldCount)) return invalid("bad world id");
+        if (record.deformation < static_cast<int32_t>(WorldEffect::DEFORMATION::NONE) ||
+            record.deformation > static_cast<int32_t>(WorldEffect::DEFORMATION::BEND)) {
+            return invalid("bad deformation");
+        }
+
+        WorldEffect effect;
+        std::memcpy(effect.transform.data(), record.effect, sizeof(record.effect));
+        effect.spinAxis = toVector(record.spinAxis);
+        effect.spinSpeed = record.spinSpeed;
+        effect.deformation = static_cast<WorldEffect::DEFORMATION>(record.deformation);
+        effect.strength = record.strength;
+        effect.pulseSpeed = record.pulseSpeed;
+        scene.portalObjects.add(toVector(record.position), effect, static_cast<ShaderType>(record.shaderType),
+                                record.worldId < 0 ? -1 : record.worldId);
+    }
+
+    scene.worlds.resize(header.worldCount);
+    for (uint32_t i = 0; i < header.worldCount; ++i) {
+        WorldRecord world;
+        std::memcpy(&world, data + worldsOffset + i * sizeof(world), sizeof(world));
+        if (quint64{world.firstObject} + world.objectCount > header.worldObjectCount) {
+            return invalid("bad world");
+        }
+
+        auto &objects = scene.worlds[i].objects;
+        objects.resize(world.objectCount);
+        for (uint32_t j = 0; j < world.objectCount; ++j) {
+            WorldObjectRecord record;
+            std::memcpy(&record, data + worldObjectsOffset + (world.firstObject + j) * sizeof(record),
+                        sizeof(record));
+            if (!string(record.modelFile, objects[j].modelFile) ||
+                !string(record.textureFile, objects[j].textureFile)) {
+                return invalid("bad string index");
+            }
+            objects[j].position = toVector(record.position);
+        }
+    }
+
+    return true;
+}
+
+bool SceneFile::saveBinary(Scene const &scene, QString const &fileName) {
+    StringTable strings;
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.objectMesh = strings.add(scene.objectMesh);
+    header.objectTexture = strings.add(scene.objectTexture);
+    header.portalMesh = strings.add(scene.portalMesh);
+
+    std::vector<ObjectRecord> objects(scene.texturedObjects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        fromVector(scene.texturedObjects.positions[i], objects[i].position);
+    }
+
+    PortalTable const &portalTable = scene.portalObjects;
+    std::vector<PortalRecord> portals(portalTable.size());
+    for (size_t i = 0; i < portals.size(); ++i) {
+        fromVector(portalTable.positions[i], portals[i].position);
+        WorldEffect const &effect = portalTable.effects[i].worldEffect;
+        std::memcpy(portals[i].effect, effect.transform.constData(), sizeof(portals[i].effect));
+        fromVector(effect.spinAxis, portals[i].spinAxis);
+        portals[i].spinSpeed = effect.spinSpeed;
+        portals[i].deformation = static_cast<int32_t>(effect.deformation);
+        portals[i].strength = effect.strength;
+        portals[i].pulseSpeed = effect.pulseSpeed;
+        portals[i].shaderType = static_cast<int32_t>(portalTable.effects[i].shaderType);
+        portals[i].worldId = portalTable.effects[i].worldId;
+    }
+
+    std::vector<WorldRecord> worlds;
+    std::vector<WorldObjectRecord> worldObjects;
+    for (auto const &world : scene.worlds) {
+        worlds.push_back({static_cast<uint32_t>(worldObjects.size()), static_cast<uint32_t>(world.objects.size())});
+        for (auto const &object : world.objects) {
+            WorldObjectRecord record;
+            record.modelFile = strings.add(object.modelFile);
+            record.textureFile = strings.add(object.textureFile);
+            fromVector(object.position, record.position);
+            worldObjects.push_back(record);
+        }
+    }
+
+    header.objectCount = static_cast<uint32_t>(objects.size());
+    header.portalCount = static_cast<uint32_t>(portals.size());
+    header.worldCount = static_cast<uint32_t>(worlds.size());
+    header.worldObjectCount = static_cast<uint32_t>(worldObjects.size());
+    header.stringCount = strings.size();
+    header.stringBytes = strings.byteCount();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write scene" << fileName;
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    writeRecords(file, objects);
+    writeRecords(file, portals);
+    writeRecords(file, worlds);
+    writeRecords(file, worldObjects);
+    strings.write(file);
+
+    if (file.error() != QFileDevice::NoError) {
+        qWarning() << "Could not write scene" << fileName << "-" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SceneFile::compile(QString const &textFileName, QString const &binaryFileName) {
+    Scene scene;
+    if (!loadText(textFileName, scene) || !saveBinary(scene, binaryFileName)) {
+        return false;
+    }
+    qDebug() << ":: Compiled" << textFileName << "into" << binaryFileName;
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <QString>
+
+#include "scene.h"
+
+/*
+ * Reads and writes scenes on disk, in one of two forms.
+ *
+ * The text form is for authoring, one statement per line, '#' starts a
+ * comment. Paths may not contain spaces.
+ *
+ *   object-mesh <path>            mesh of the objects of the scene
+ *   object-texture <path>         texture of the objects of the scene
+ *   portal-mesh <path>            mesh of the portals
+ *   object <x> <y> <z>
+ *   portal <x> <y> <z> [shader phong|normal] [world <id>] [<effect>...]
+ *   world                         starts the next world, numbered from 0
+ *   world-object <mesh> <texture> <x> <y> <z>
+ *
+ * The effect of a portal is built from the operations in order, as on a
+ * QMatrix4x4: scale <s>, scale <x> <y> <z>, rotate <degrees> <x> <y> <z>,
+ * translate <x> <y> <z>, or matrix followed by 16 values in row-major order.
+ * It may also spin <degrees per second> <x> <y> <z>, deform with
+ * twist <radians per unit> or bend <radians per unit>, and pulse <radians per
+ * second> to swing the deformation back and forth (see WorldEffect).
+ *
+ * The binary form is compiled from the text one. It is little endian and
+ * consists of a header followed by flat arrays of fixed size records and a
+ * string table, so loading maps the file and copies the records straight into
+ * the tables of the Scene.
+ */
+class SceneFile
+{
+public:
+    /*
+     * Loads either form, told apart by the first bytes of the file. Returns
+     * false, having warned about what is wrong, if the file does not load.
+     */
+    static bool load(QString const &fileName, Scene &scene);
+
+    // The scene in the file, or the built-in one if there is none or it does not load
+    static Scene loadOrBuiltIn(QString const &fileName);
+
+    static bool loadText(QString const &fileName, Scene &scene);
+    static bool loadBinary(QString const &fileName, Scene &scene);
+    static bool saveBinary(Scene const &scene, QString const &fileName);
+
+    // Converts a scene in the text form into the binary one
+    static bool compile(QString const &textFileName, QString const &binaryFileName);
+};
+
+#endif // SCENEFILE_H
@@ -1,4 +0,0 @@
-#include "sceneobject.h"
-
-SceneObject::SceneObject(QVector3D position)
-    : position{position} {}
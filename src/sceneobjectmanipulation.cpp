@@ -1,93 +1,123 @@
 #include "mainview.h"
 
+#include <cstddef>
+
 #include "model.h"
+#include "texturefile.h"
+#include "vertexencoding.h"
+
+void MainView::loadIntoRenderHandle(QString const &fileName, RenderHandle &rh) {
+  Model model(fileName, Model::LAYOUT::INDEXED);
+  loadIntoRenderHandle(
+      MeshData{fileName, model.takeCoords(), model.takeNormals(), model.takeTextureCoords(),
+               model.takeIndices()},
+      rh);
+}
 
-void MainView::loadIntoSceneObject(QString const &fileName, SceneObject &so) {
-  Model model(fileName);
-  QVector<QVector3D> meshCoords = model.getCoords();
-  QVector<QVector3D> meshNormals = model.getNormals();
-  QVector<QVector2D> meshTextureCoords = model.getTextureCoords();
+void MainView::loadIntoRenderHandle(MeshData const &mesh, RenderHandle &rh) {
+  loadIntoRenderHandle(PreparedMesh::prepare(mesh), rh);
+}
 
-  so.size = meshCoords.size();
+/**
+ * @brief MainView::loadIntoRenderHandle Uploads a mesh that is prepared for
+ * the GPU already, see PreparedMesh.
+ * @param mesh The prepared mesh.
+ * @param rh Gets the buffers, on top of the rest of the mesh's handle.
+ */
+void MainView::loadIntoRenderHandle(PreparedMesh const &mesh, RenderHandle &rh) {
+  rh = mesh.handle;
+  EncodedMesh const &encoded = mesh.encoded;
+  QVector<unsigned> const &indices = mesh.indices;
 
   // Generate VAO
-  glGenVertexArrays(1, &so.vao);
-  glBindVertexArray(so.vao);
+  glGenVertexArrays(1, &rh.vao);
+  glBindVertexArray(rh.vao);
+
+  // Generate VBO, all attributes are interleaved in it
+  glGenBuffers(1, &rh.vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, rh.vbo);
+  glBufferData(GL_ARRAY_BUFFER, encoded.vertices.size() * sizeof(PackedVertex),
+               encoded.vertices.data(), GL_STATIC_DRAW);
+  setVertexAttributes();
+
+  // The VAO keeps track of the element buffer bound while it is bound
+  glGenBuffers(1, &rh.ebo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, rh.ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned),
+               indices.data(), GL_STATIC_DRAW);
 
-  // Generate VBO
-  glGenBuffers(1, &so.positionVBO);
-  glGenBuffers(1, &so.normalVBO);
-  glGenBuffers(1, &so.textureVBO);
+  // Generally good practice to unbind the buffers to prevent anything after
+  // this from accidentally modifying it.
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
 
-  // Copy the vertex coordinates into the position VBO
-  glBindBuffer(GL_ARRAY_BUFFER, so.positionVBO);
-  glBufferData(GL_ARRAY_BUFFER, meshCoords.size() * sizeof(QVector3D),
-               meshCoords.data(), GL_STATIC_DRAW);
+}
 
-  // Set vertex coordinates to location 0
+/**
+ * @brief MainView::setVertexAttributes Points the attributes of the vertex
+ * array that is bound at the PackedVertex data in GL_ARRAY_BUFFER.
+ */
+void MainView::setVertexAttributes() {
+  // Set vertex coordinates to location 0, as normalized unsigned shorts
   // Note: glVertexAttribPointer implicitly reference the VBO currently bound to
   // GL_ARRAY_BUFFER
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D),
-                        reinterpret_cast<GLvoid *>(0));
+  glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+                        reinterpret_cast<GLvoid *>(offsetof(PackedVertex, coords)));
   glEnableVertexAttribArray(0);
 
-  // Copy the normals into the normal VBO
-  glBindBuffer(GL_ARRAY_BUFFER, so.normalVBO);
-  glBufferData(GL_ARRAY_BUFFER, meshNormals.size() * sizeof(QVector3D),
-               meshNormals.data(), GL_STATIC_DRAW);
-
-  // Set normals values to location 1
-  // Note: glVertexAttribPointer implicitly reference the VBO currently bound to
-  // GL_ARRAY_BUFFER
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(QVector3D),
-                        reinterpret_cast<GLvoid *>(0));
+  // Set the octahedral normals to location 1, as normalized shorts
+  glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex),
+                        reinterpret_cast<GLvoid *>(offsetof(PackedVertex, normal)));
   glEnableVertexAttribArray(1);
 
-  glBindBuffer(GL_ARRAY_BUFFER, so.textureVBO);
-  glBufferData(GL_ARRAY_BUFFER, meshTextureCoords.size() * sizeof(QVector2D),
-               meshTextureCoords.data(), GL_STATIC_DRAW);
-
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(QVector2D),
-                        reinterpret_cast<GLvoid *>(0));
+  // Set the texture coordinates to location 2, as half floats
+  glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                        reinterpret_cast<GLvoid *>(offsetof(PackedVertex, textureCoords)));
   glEnableVertexAttribArray(2);
 
-  // Generally good practice to unbind the buffers to prevent anything after
-  // this from accidentally modifying it.
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-
+  // The record index of the indirect draw path
+  indirectDraws.attachDrawIds();
 }
 
-void MainView::loadIntoSceneObject(
-    QString const &fileName, TexturedObject &tso,
+void MainView::loadIntoRenderHandle(
+    QString const &fileName, RenderHandle &rh,
     QString const &textureFile
 ) {
-    loadIntoSceneObject(fileName, static_cast<SceneObject &>(tso));
-    generateTexture(textureFile, tso);
+    loadIntoRenderHandle(fileName, rh);
+    rh.material = generateMaterials({loadTexture(textureFile)}, sceneMaterialPages).front();
 }
 
-void MainView::generateTexture(QString const &fileName, TexturedObject &tso) {
-  QImage textureImage{fileName};
-  // Texture image data
-  QVector<quint8> textureData = imageToBytes(textureImage);
+TextureData MainView::loadTexture(QString const &fileName) {
+  // The finer levels are streamed in by textureStreamer
+  return TextureFile::loadResident(fileName);
+}
 
-  // Generate Texture
-  glGenTextures(1, &tso.texture);
-  glBindTexture(GL_TEXTURE_2D, tso.texture);
+std::vector<Material> MainView::generateMaterials(std::vector<TextureData> const &textures,
+                                                  std::vector<GLuint> &pages) {
+  GLint maxLayers = 0;
+  glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
 
-  // Set texture parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  std::vector<Material> materials(textures.size());
+  for (auto const &layout : MaterialPacking::pack(textures, maxLayers)) {
+    std::vector<TextureData const *> layers;
+    for (size_t texture : layout.textures) {
+      layers.push_back(&textures[texture]);
+    }
 
-  // Upload texture data
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, textureImage.width(),
-               textureImage.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE,
-               textureData.data());
+    // Only the resident levels, the streamer takes it from there
+    GLuint page = textureStreamer.createPage(layers);
+    pages.push_back(page);
+    for (size_t layer = 0; layer < layout.textures.size(); ++layer) {
+      materials[layout.textures[layer]] = {page, static_cast<GLint>(layer)};
+    }
+  }
+
+  return materials;
 }
 
-void MainView::setPortalStencil(PortalObject &po, int stencilVal) {
+void MainView::setPortalStencil(size_t portal, int stencilVal) {
+  Profiler::Zone zone{profiler, "setPortalStencil", static_cast<int>(portal)};
+
   // TODO: There is an error here, objects that are in front of the portal will also be transformed as if they were behind portal.
 
   // Set the stencil test to always pass
@@ -100,23 +130,14 @@ void MainView::setPortalStencil(PortalObject &po, int stencilVal) {
   glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
   glDepthMask(GL_FALSE);
 
-  paintPortal(po, false);
+  paintPortal(portal, false);
 
   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
   glDepthMask(GL_TRUE);
   glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 }
 
-void MainView::paintMeshWithPortalEffectAtStencil(TexturedObject &to, PortalObject &po) {
-    // If we are in a portal world, make sure to set portal door to render the default world instead
-    QOpenGLShaderProgram &shaderProgram = inPortal ? shaders[ShaderType::PHONG] : shaders[po.shaderType];
-    QMatrix4x4 portalEffect = po.effectTransform;
-    if (inPortal) {
-        portalEffect.setToIdentity();
-    }
-
-    shaderProgram.bind();
-
+void MainView::setShadingUniforms(QOpenGLShaderProgram &shaderProgram) {
     // Scene constants
     shaderProgram.setUniformValue("materialColor", QVector3D{1, 1, 1});
     shaderProgram.setUniformValue("ka", 0.4F);
@@ -125,41 +146,165 @@ void MainView::paintMeshWithPortalEffectAtStencil(TexturedObject &to, PortalObje
     shaderProgram.setUniformValue("p", 8);
     shaderProgram.setUniformValue("lightCoordinates", QVector3D{100, 50, 0});
     shaderProgram.setUniformValue("lightColor", QVector3D{1, 1, 1});
+}
 
-    // Transformation Constants
-    QMatrix4x4 meshWithEffectTransform = to.modelTransform * portalEffect;
-    shaderProgram.setUniformValue("projectionTransform", projectionTransform);
-    shaderProgram.setUniformValue("modelViewTransform", meshWithEffectTransform);
-    shaderProgram.setUniformValue("normalMatrix", meshWithEffectTransform.normalMatrix());
+void MainView::setViewUniforms(QOpenGLShaderProgram &shaderProgram) {
+    shaderProgram.setUniformValue("viewCount", views.count());
+    shaderProgram.setUniformValueArray("viewProjections", views.getProjections().data(), views.count());
+    shaderProgram.setUniformValueArray("viewEyes", views.getEyes().data(), views.count());
+}
 
-    shaderProgram.setUniformValue("sampler", 0);
+/**
+ * @brief MainView::setViewClipping Clips what is drawn for a view to the
+ * view's slot of the frame, which only the world shaders can be drawn under.
+ * @param enabled Whether to clip, only done if there is more than one view.
+ */
+void MainView::setViewClipping(bool enabled) {
+    if (views.count() == 1) return;
+
+    if (enabled) {
+        glEnable(GL_CLIP_DISTANCE0);
+        glEnable(GL_CLIP_DISTANCE1);
+    } else {
+        glDisable(GL_CLIP_DISTANCE0);
+        glDisable(GL_CLIP_DISTANCE1);
+    }
+}
 
+void MainView::bindObjectUniforms(GLintptr offset) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, ObjectUniforms::BINDING, objectUniforms.getBuffer(),
+                      offset, sizeof(ObjectUniforms));
+}
+
+void MainView::bindEffectUniforms(GLintptr offset) {
+    glBindBufferRange(GL_UNIFORM_BUFFER, EffectUniforms::BINDING, objectUniforms.getBuffer(),
+                      offset, sizeof(EffectUniforms));
+}
+
+void MainView::paintDrawList(DrawList const &drawList, int pass) {
+    bindEffectUniforms(drawList.effectUniformsOffset);
+    if (drawList.indirect) {
+        paintIndirect(pass, drawList.shaderType);
+        return;
+    }
+
+    QOpenGLShaderProgram &shaderProgram = shaders[drawList.shaderType];
+    shaderProgram.bind();
+    setShadingUniforms(shaderProgram);
+
+    // Transformation Constants
+    setViewUniforms(shaderProgram);
+    shaderProgram.setUniformValue("sampler", 0);
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, to.texture);
 
-    glBindVertexArray(to.vao);
-    glDrawArrays(GL_TRIANGLES, 0, to.size);
+    // The items are sorted on page and mesh, only bind them when they change
+    GLuint boundPage = 0;
+    GLuint boundVao = 0;
+    auto paintItem = [&](DrawItem const &item) {
+        bindObjectUniforms(item.uniformsOffset);
+
+        if (item.material.page != boundPage) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, item.material.page);
+            boundPage = item.material.page;
+        }
+        if (item.vao != boundVao) {
+            glBindVertexArray(item.vao);
+            boundVao = item.vao;
+        }
+        if (views.count() == 1) {
+            glMultiDrawElements(GL_TRIANGLES, drawList.rangeCounts.data() + item.firstRange, GL_UNSIGNED_INT,
+                                drawList.rangeOffsets.data() + item.firstRange,
+                                static_cast<GLsizei>(item.rangeCount));
+            return;
+        }
+        // There is no instanced glMultiDrawElements in GL 3.3
+        for (uint32_t range = item.firstRange; range < item.firstRange + item.rangeCount; ++range) {
+            glDrawElementsInstanced(GL_TRIANGLES, drawList.rangeCounts[range], GL_UNSIGNED_INT,
+                                    drawList.rangeOffsets[range], views.count());
+        }
+    };
+
+    for (auto const &item : drawList.items) {
+        paintItem(item);
+    }
+
+    shaderProgram.release();
+
+    paintBatches(drawList);
+    boundPage = 0;
+
+    if (drawList.occludedItems.empty()) {
+        return;
+    }
+
+    // Hidden in the previous frame. Test the bounds against the depth drawn so
+    // far, and only draw the objects that turn out visible after all.
+    queryOcclusion(drawList.occludedItems);
+    boundVao = 0;
+    bindEffectUniforms(drawList.effectUniformsOffset);
+
+    shaderProgram.bind();
+    for (size_t i = 0; i < drawList.occludedItems.size(); ++i) {
+        glBeginConditionalRender(occlusionQueries[i], GL_QUERY_WAIT);
+        paintItem(drawList.occludedItems[i]);
+        glEndConditionalRender();
+    }
+
+    shaderProgram.release();
+}
+
+void MainView::paintIndirect(int pass, ShaderType shaderType) {
+    QOpenGLShaderProgram &shaderProgram = indirectShaders[shaderType];
+    shaderProgram.bind();
+    setShadingUniforms(shaderProgram);
+
+    QMatrix4x4 const &passTransform = indirectDraws.getPassTransform(pass);
+    setViewUniforms(shaderProgram);
+    shaderProgram.setUniformValue("passTransform", passTransform);
+    shaderProgram.setUniformValue("normalMatrix", passTransform.normalMatrix());
+    shaderProgram.setUniformValue("sampler", 0);
+
+    indirectDraws.draw(pass);
 
     shaderProgram.release();
 }
 
-void MainView::paintPortal(PortalObject &po, bool renderBorder) {
+void MainView::paintPortal(size_t portal, bool renderBorder, bool drawImpostor) {
+    Profiler::Zone zone{profiler, "paintPortal", static_cast<int>(portal)};
+
+    PortalTable &portals = currentScene.portalObjects;
+    QMatrix4x4 const &modelTransform = portals.modelTransforms[portal];
+    RenderHandle const &rh = portals.renderHandles[portal];
+
+    StreamBuffer::Allocation uniforms = objectUniforms.allocate(sizeof(ObjectUniforms), uniformAlignment);
+    if (uniforms.data == nullptr) {
+        return;
+    }
+    ObjectUniforms::write(uniforms.data, modelTransform, rh.positionOffset, rh.positionScale);
+    objectUniforms.flush();
+    bindEffectUniforms(identityEffectOffset);
+
     QOpenGLShaderProgram &shaderProgram = shaders[ShaderType::PORTAL];
     shaderProgram.bind();
-    shaderProgram.setUniformValue("modelViewTransform",
-                  po.modelTransform);
-    shaderProgram.setUniformValue("normalMatrix", po.modelTransform.normalMatrix());
-    shaderProgram.setUniformValue("projectionTransform",
-                  projectionTransform);
+    bindObjectUniforms(uniforms.offset);
+    setViewUniforms(shaderProgram);
     shaderProgram.setUniformValue("borderWidth", 0.1F);
     shaderProgram.setUniformValue("renderBorder", renderBorder);
+    shaderProgram.setUniformValue("drawImpostor", drawImpostor);
+    if (drawImpostor) {
+        shaderProgram.setUniformValue("impostorAtlas", 0);
+        shaderProgram.setUniformValue("impostorTransform", impostorAtlas.getImageTransform(
+                                          portal, camera.getModelTransform().column(3).toVector3D()));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, impostorAtlas.getAtlas());
+    }
 
     // Assumes that no mesh will be infornt of the portal.
     if (renderBorder)
         glDisable(GL_CULL_FACE);
 
-    glBindVertexArray(po.vao);
-    glDrawArrays(GL_TRIANGLES, 0, po.size);
+    glBindVertexArray(rh.vao);
+    glDrawElementsInstanced(GL_TRIANGLES, rh.size, GL_UNSIGNED_INT, nullptr, views.count());
 
     if (renderBorder)
         glEnable(GL_CULL_FACE);
@@ -167,56 +312,24 @@ void MainView::paintPortal(PortalObject &po, bool renderBorder) {
     shaderProgram.release();
 }
 
-void MainView::updateModelTransforms(SceneObject &so) {
-  so.modelTransform.setToIdentity();
-  so.modelTransform.translate(so.position);
-
-  so.modelTransform = so.modelTransform * camera.getModelTransform();
-
-  update();
-}
-
-void MainView::updatePortalEffectTransforms(PortalObject &po) {
-    PortalObject::COLLISION_STATE newCollisionState = getPortalCollision(po);
+void MainView::updateModelTransforms(ObjectTable &objects) {
+  QMatrix4x4 cameraTransform = camera.getModelTransform();
 
-    if (po.collisionState == newCollisionState) {
-    return;
-    }
-    if (newCollisionState == PortalObject::COLLISION_STATE::NO_COLLISION
-        || po.collisionState == PortalObject::COLLISION_STATE::NO_COLLISION
-    ) {
-        po.collisionState = newCollisionState;
-        return;
-    }
+  jobSystem.parallelFor(objects.size(), 1024, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      QMatrix4x4 &modelTransform = objects.modelTransforms[i];
+      modelTransform.setToIdentity();
+      modelTransform.translate(objects.positions[i]);
 
-    if (inPortal) {
-        inPortal = false;
-        currentWorldEffectTransform.setToIdentity();
-        currentShaderType = ShaderType::PHONG;
-    } else {
-        currentWorldEffectTransform = po.effectTransform;
-        currentShaderType = po.shaderType;
-        inPortal = true;
+      modelTransform = modelTransform * cameraTransform;
     }
+  });
 
-    po.collisionState = newCollisionState;
-}
-PortalObject::COLLISION_STATE MainView::getPortalCollision(PortalObject &po) {
-    auto portalPosition = po.modelTransform.map(QVector3D{0,0,0});
-    double distance = portalPosition.length();
-    if (distance < 1) {
-        if (camera.getPosition().z() + 0.2*camera.viewVector().z() < 0) {
-            return PortalObject::COLLISION_STATE::FRONT; // Camera is in front of the portal
-        } else {
-            return PortalObject::COLLISION_STATE::BACK; // Camera is in back of portal
-        }
-    }
-    return PortalObject::COLLISION_STATE::NO_COLLISION; // No collision
+  update();
 }
 
-void MainView::cleanUpSceneObject(SceneObject &so) {
-    glDeleteBuffers(1, &so.positionVBO);
-    glDeleteBuffers(1, &so.normalVBO);
-    glDeleteBuffers(1, &so.textureVBO);
-    glDeleteVertexArrays(1, &so.vao);
+void MainView::cleanUpRenderHandle(RenderHandle &rh) {
+    glDeleteBuffers(1, &rh.vbo);
+    glDeleteBuffers(1, &rh.ebo);
+    glDeleteVertexArrays(1, &rh.vao);
 }
@@ -0,0 +1,113 @@
+#include "scenestore.h"
+
+#include <utility>
+
+namespace {
+
+// Moves the last element into index and drops the last element
+template <typename T>
+void swapRemove(std::vector<T> &components, size_t index) {
+    if (index != components.size() - 1) {
+        components[index] = std::move(components.back());
+    }
+    components.pop_back();
+}
+
+}
+
+EntityHandle HandleTable::create() {
+    uint32_t slot;
+    if (freeSlots.empty()) {
+        slot = static_cast<uint32_t>(entries.size());
+        entries.push_back({0, 0});
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    entries[slot].denseIndex = static_cast<uint32_t>(denseToSlot.size());
+    denseToSlot.push_back(slot);
+
+    return {slot, entries[slot].generation};
+}
+
+void HandleTable::reserve(size_t count) {
+    entries.reserve(count);
+    denseToSlot.reserve(count);
+}
+
+size_t HandleTable::remove(EntityHandle handle) {
+    size_t index = entries[handle.slot].denseIndex;
+
+    // The last element takes over the freed dense index
+    uint32_t movedSlot = denseToSlot.back();
+    entries[movedSlot].denseIndex = static_cast<uint32_t>(index);
+    swapRemove(denseToSlot, index);
+
+    // Invalidate outstanding handles to the removed entity
+    ++entries[handle.slot].generation;
+    freeSlots.push_back(handle.slot);
+
+    return index;
+}
+
+bool HandleTable::isValid(EntityHandle handle) const {
+    return handle.slot < entries.size() && entries[handle.slot].generation == handle.generation;
+}
+
+EntityHandle HandleTable::handleAt(size_t index) const {
+    uint32_t slot = denseToSlot[index];
+    return {slot, entries[slot].generation};
+}
+
+EntityHandle ObjectTable::add(QVector3D position) {
+    EntityHandle handle = handles.create();
+    cells.clear();
+
+    positions.push_back(position);
+    modelTransforms.emplace_back();
+    renderHandles.emplace_back();
+
+    return handle;
+}
+
+void ObjectTable::reserve(size_t count) {
+    handles.reserve(count);
+    positions.reserve(count);
+    modelTransforms.reserve(count);
+    renderHandles.reserve(count);
+}
+
+void ObjectTable::remove(EntityHandle handle) {
+    if (!handles.isValid(handle)) return;
+
+    size_t index = handles.remove(handle);
+    cells.clear();
+    swapRemove(positions, index);
+    swapRemove(modelTransforms, index);
+    swapRemove(renderHandles, index);
+}
+
+EntityHandle PortalTable::add(QVector3D position, WorldEffect effect, ShaderType shaderType, int worldId) {
+    EntityHandle handle = ObjectTable::add(position);
+
+    effects.push_back({effect, shaderType, worldId});
+    collisions.emplace_back();
+
+    return handle;
+}
+
+void PortalTable::reserve(size_t count) {
+    ObjectTable::reserve(count);
+    effects.reserve(count);
+    collisions.reserve(count);
+}
+
+void PortalTable::remove(EntityHandle handle) {
+    if (!handles.isValid(handle)) return;
+
+    size_t index = handles.indexOf(handle);
+    ObjectTable::remove(handle);
+    swapRemove(effects, index);
+    swapRemove(collisions, index);
+}
@@ -0,0 +1,164 @@
+#ifndef SCENESTORE_H
+#define SCENESTORE_H
+
+#include <GL/gl.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "cellgrid.h"
+#include "material.h"
+#include "meshlet.h"
+#include "portalobject.h"
+
+/*
+ * Refers to an entity in an entity table. Unlike a dense index, a handle stays
+ * valid when other entities are added or removed.
+ */
+struct EntityHandle
+{
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t slot = INVALID;
+    uint32_t generation = 0;
+
+    bool operator==(EntityHandle const &other) const {
+        return slot == other.slot && generation == other.generation;
+    }
+    bool operator!=(EntityHandle const &other) const { return !(*this == other); }
+};
+
+/*
+ * Maps entity handles to indices in the dense component arrays of a table.
+ * Removal moves the last dense element into the hole, so the arrays stay packed.
+ */
+class HandleTable
+{
+public:
+    // Creates a handle for a new element appended at the end of the dense arrays
+    EntityHandle create();
+
+    /*
+     * Removes a handle. Returns the dense index that was freed: the caller has to
+     * move the last element of each dense array into it and shrink the arrays.
+     */
+    size_t remove(EntityHandle handle);
+
+    bool isValid(EntityHandle handle) const;
+    size_t indexOf(EntityHandle handle) const { return entries[handle.slot].denseIndex; }
+    EntityHandle handleAt(size_t index) const;
+    size_t size() const { return denseToSlot.size(); }
+    void reserve(size_t count);
+
+private:
+    struct Slot {
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    std::vector<Slot> entries;
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> denseToSlot;
+};
+
+/*
+ * The GPU resources needed to draw an entity.
+ */
+struct RenderHandle
+{
+    GLuint vao = 0;
+    // Interleaved PackedVertex data
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    // The number of indices
+    GLuint size = 0;
+    // Where they start in the element buffer, which is shared in a static batch
+    GLuint firstIndex = 0;
+    // The StaticBatch of the ObjectTable the mesh is merged into, or -1
+    int batch = -1;
+
+    // Decodes the quantized coordinates, see EncodedMesh
+    QVector3D positionOffset;
+    QVector3D positionScale;
+
+    // Bounding sphere of the mesh, in model space
+    QVector3D boundsCenter;
+    float boundsRadius = 0;
+
+    // The meshlets the index buffer is ordered in, shared by all copies of the handle
+    std::shared_ptr<std::vector<Meshlet> const> meshlets;
+
+    // Only set for textured objects
+    Material material;
+};
+
+/*
+ * The GPU resources of meshes merged into one batch, see StaticBatcher.
+ */
+struct StaticBatch
+{
+    GLuint vao = 0;
+    // Interleaved PackedVertex data, and the index in the batch of the object
+    // of every vertex
+    GLuint vbo = 0;
+    GLuint objectIndices = 0;
+    GLuint ebo = 0;
+    // The objects as a GL_TEXTURE_BUFFER, see StaticBatcher::Record
+    GLuint records = 0;
+    GLuint recordsTexture = 0;
+    // The material page all objects in the batch share
+    GLuint page = 0;
+};
+
+/*
+ * Textured meshes, stored as one dense array per component, so per-frame loops
+ * only touch the data they actually need.
+ */
+struct ObjectTable
+{
+    HandleTable handles;
+
+    // Position in the scene
+    std::vector<QVector3D> positions;
+    // The model to world transform
+    std::vector<QMatrix4x4> modelTransforms;
+    std::vector<RenderHandle> renderHandles;
+
+    // The static batches the objects may be merged into, see RenderHandle::batch.
+    // Only for objects that do not move.
+    std::vector<StaticBatch> batches;
+
+    // The objects by where they are, for the passes to skip the ones that
+    // are out of view in bulk. Built once they are loaded, cleared when any
+    // is added or removed.
+    CellGrid cells;
+
+    EntityHandle add(QVector3D position);
+    void remove(EntityHandle handle);
+    // Makes room for count entities in total, before adding many at once
+    void reserve(size_t count);
+
+    size_t size() const { return handles.size(); }
+};
+
+/*
+ * Portals, with the same layout as ObjectTable plus the portal specific arrays.
+ */
+struct PortalTable : public ObjectTable
+{
+    // Read when rendering the world behind a portal
+    std::vector<PortalEffect> effects;
+    // Updated by the collision checks
+    std::vector<PortalCollision> collisions;
+
+    EntityHandle add(QVector3D position, WorldEffect effect,
+                     ShaderType shaderType = ShaderType::PHONG, int worldId = -1);
+    void remove(EntityHandle handle);
+    void reserve(size_t count);
+};
+
+#endif // SCENESTORE_H
@@ -0,0 +1,70 @@
+#version 330 core
+
+#include "multiview.glsl"
+#include "worldeffect.glsl"
+
+// Specify the input locations of attributes
+// Coordinates are normalized relative to the mesh bounds, normals octahedral
+// encoded and texture coordinates half floats (see PackedVertex)
+layout(location = 0) in vec3 vertCoordinates_in;
+layout(location = 1) in vec2 vertNormal_in;
+layout(location = 2) in vec2 vertTextureCoords_in;
+// The index of the object of the vertex in its static batch
+layout(location = 4) in uint objectIndex_in;
+
+// Three texels per object, see StaticBatcher::Record: the position and
+// material layer, the position offset and the position scale
+uniform samplerBuffer objectRecords;
+
+// Light properties
+uniform vec3 lightCoordinates;
+
+// Specify the Uniforms of the vertex shader
+// The camera, applied after the world effect and before moving the object to its position
+uniform mat4 passTransform;
+uniform mat3 normalMatrix;
+
+// Specify the output of the vertex stage
+out vec3 N;
+out vec3 V;
+out vec3 L;
+out vec2 textureCoords;
+out vec3 vertNormal;
+flat out int textureLayer;
+
+// Inverse of the octahedral encoding of the normals
+vec3 decodeOctahedral(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0F - abs(encoded.x) - abs(encoded.y));
+  float t = max(-normal.z, 0.0F);
+  normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0F)));
+  return normalize(normal);
+}
+
+void main() {
+  int record = 3 * int(objectIndex_in);
+  vec4 positionAndLayer = texelFetch(objectRecords, record);
+  vec3 positionOffset = texelFetch(objectRecords, record + 1).xyz;
+  vec3 positionScale = texelFetch(objectRecords, record + 2).xyz;
+
+  vec3 coordinates = positionOffset + positionScale * vertCoordinates_in;
+  vec3 normal = decodeOctahedral(vertNormal_in);
+  // The effect of the world applies in model space
+  applyWorldEffect(coordinates, normal);
+
+  vec4 P = passTransform * vec4(coordinates, 1.0F) + vec4(positionAndLayer.xyz, 0.0F);
+  // gl_Position is the output (a vec4) of the vertex shader
+  gl_Position = projectToView(P);
+
+  // We are assuming that camera is outside model, so no need to flip normal
+  N = normalize(normalMatrix * normal);
+
+  // Direction to light from point
+  L = normalize(lightCoordinates - P.xyz);
+
+  // Direction to the eye of the view
+  V = normalize(currentEye() - P.xyz);
+
+  textureCoords = vertTextureCoords_in;
+  vertNormal = N;
+  textureLayer = int(positionAndLayer.w);
+}
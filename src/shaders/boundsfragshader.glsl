@@ -0,0 +1,8 @@
+#version 330 core
+
+// Only depth is tested, colour writes are masked off
+out vec4 fColor;
+
+void main() {
+  fColor = vec4(1, 1, 1, 1);
+}
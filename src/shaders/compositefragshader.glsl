@@ -0,0 +1,15 @@
+#version 330 core
+
+in vec2 sourceCoords;
+
+// A portal world, rendered at a lower resolution than the frame
+uniform sampler2D sourceColor;
+uniform sampler2D sourceDepth;
+
+out vec4 fColor;
+
+void main() {
+  fColor = texture(sourceColor, sourceCoords);
+  // The depth of the world, for the occlusion culling of the next frames
+  gl_FragDepth = texture(sourceDepth, sourceCoords).r;
+}
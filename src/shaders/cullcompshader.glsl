@@ -0,0 +1,80 @@
+#version 430 core
+
+#include "worldeffect.glsl"
+
+// One invocation per object, see IndirectDraws
+layout(local_size_x = 64) in;
+
+// Must match ObjectRecord in indirectdraws.cpp
+struct ObjectRecord {
+  vec4 position;
+  vec4 positionOffset;
+  vec4 positionScale;
+  // Bounding sphere in model space: center and radius
+  vec4 bounds;
+  uint count;
+  uint firstIndex;
+  int baseVertex;
+  int materialLayer;
+};
+
+struct DrawElementsIndirectCommand {
+  uint count;
+  uint instanceCount;
+  uint firstIndex;
+  int baseVertex;
+  uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectRecords {
+  ObjectRecord records[];
+};
+
+layout(std430, binding = 1) writeonly buffer DrawCommands {
+  DrawElementsIndirectCommand commands[];
+};
+
+uniform uint objectCount;
+
+// The camera, applied after the world effect and before moving the object to its position
+uniform mat4 passTransform;
+// Largest factor by which passTransform scales lengths
+uniform float passScale;
+
+// Must match MultiView::MAX_VIEWS
+#define MAX_VIEWS 4
+
+// Every draw is instanced once per view
+uniform int viewCount;
+// Six per view, (a, b, c, d) such that a point p is inside if a*x + b*y + c*z + d >= 0
+uniform vec4 frustumPlanes[6 * MAX_VIEWS];
+
+void main() {
+  uint object = gl_GlobalInvocationID.x;
+  if (object >= objectCount) {
+    return;
+  }
+
+  ObjectRecord record = records[object];
+  vec3 center = record.bounds.xyz;
+  float radius = record.bounds.w;
+  worldEffectBounds(center, radius);
+  center = (passTransform * vec4(center, 1.0F)).xyz + record.position.xyz;
+  radius *= passScale;
+
+  // Drawn for all views if any of them sees it
+  bool visible = false;
+  for (int view = 0; view < viewCount; ++view) {
+    bool inView = true;
+    for (int i = 6 * view; i < 6 * view + 6; ++i) {
+      if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius) {
+        inView = false;
+      }
+    }
+    visible = visible || inView;
+  }
+
+  // Culled objects are drawn zero times, the draw of an object stays at its index
+  commands[object] = DrawElementsIndirectCommand(
+      record.count, visible ? uint(viewCount) : 0u, record.firstIndex, record.baseVertex, object);
+}
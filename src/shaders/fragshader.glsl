@@ -8,9 +8,10 @@ in vec3 N;
 in vec3 V;
 in vec3 L;
 in vec2 textureCoords;
+flat in int textureLayer;
 
-// Texture
-uniform sampler2D sampler;
+// Texture, sampled at the layer of the page holding the object's texture
+uniform sampler2DArray sampler;
 
 // Material properties
 // Ambient / Diffuse / Specular constants
@@ -26,7 +27,7 @@ uniform vec3 lightColor;
 out vec4 fColor;
 
 void main() {
-  vec3 textureColor = texture(sampler, textureCoords).rgb;
+  vec3 textureColor = texture(sampler, vec3(textureCoords, textureLayer)).rgb;
 
   float NL = dot(N,L);
 
@@ -0,0 +1,80 @@
+#version 430 core
+
+#include "multiview.glsl"
+#include "worldeffect.glsl"
+
+// Specify the input locations of attributes
+// Coordinates are normalized relative to the mesh bounds, normals octahedral
+// encoded and texture coordinates half floats (see PackedVertex)
+layout(location = 0) in vec3 vertCoordinates_in;
+layout(location = 1) in vec2 vertNormal_in;
+layout(location = 2) in vec2 vertTextureCoords_in;
+// The baseInstance of the draw, which is the index of its record, the same
+// for the instances of all views
+layout(location = 3) in uint drawId_in;
+
+// Must match ObjectRecord in indirectdraws.cpp
+struct ObjectRecord {
+  vec4 position;
+  vec4 positionOffset;
+  vec4 positionScale;
+  vec4 bounds;
+  uint count;
+  uint firstIndex;
+  int baseVertex;
+  int materialLayer;
+};
+
+layout(std430, binding = 0) readonly buffer ObjectRecords {
+  ObjectRecord records[];
+};
+
+// Light properties
+uniform vec3 lightCoordinates;
+
+// Specify the Uniforms of the vertex shader
+// The camera, applied after the world effect and before moving the object to its position
+uniform mat4 passTransform;
+uniform mat3 normalMatrix;
+
+// Specify the output of the vertex stage
+out vec3 N;
+out vec3 V;
+out vec3 L;
+out vec2 textureCoords;
+out vec3 vertNormal;
+flat out int textureLayer;
+
+// Inverse of the octahedral encoding of the normals
+vec3 decodeOctahedral(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0F - abs(encoded.x) - abs(encoded.y));
+  float t = max(-normal.z, 0.0F);
+  normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0F)));
+  return normalize(normal);
+}
+
+void main() {
+  ObjectRecord record = records[drawId_in];
+
+  vec3 coordinates = record.positionOffset.xyz + record.positionScale.xyz * vertCoordinates_in;
+  vec3 normal = decodeOctahedral(vertNormal_in);
+  // The effect of the world applies in model space
+  applyWorldEffect(coordinates, normal);
+
+  vec4 P = passTransform * vec4(coordinates, 1.0F) + vec4(record.position.xyz, 0.0F);
+  // gl_Position is the output (a vec4) of the vertex shader
+  gl_Position = projectToView(P);
+
+  // We are assuming that camera is outside model, so no need to flip normal
+  N = normalize(normalMatrix * normal);
+
+  // Direction to light from point
+  L = normalize(lightCoordinates - P.xyz);
+
+  // Direction to the eye of the view
+  V = normalize(currentEye() - P.xyz);
+
+  textureCoords = vertTextureCoords_in;
+  vertNormal = N;
+  textureLayer = record.materialLayer;
+}
@@ -0,0 +1,34 @@
+// Draws every instance for a view of its own, side by side across the frame,
+// included by the shaders that draw worlds. See MultiView.
+
+// Must match MultiView::MAX_VIEWS
+#define MAX_VIEWS 4
+
+uniform int viewCount;
+// From the space of the modelview transforms to the clip space of each view
+uniform mat4 viewProjections[MAX_VIEWS];
+// Where the eye of each view is, in the same space
+uniform vec3 viewEyes[MAX_VIEWS];
+
+// The left and right edge of the view's slot
+out float gl_ClipDistance[2];
+
+int currentView() {
+  return gl_InstanceID % viewCount;
+}
+
+// Projects a point for the view of this instance, into the view's slot
+vec4 projectToView(vec4 position) {
+  int view = currentView();
+  vec4 clip = viewProjections[view] * position;
+  // Squeezed into the slot, the frustum no longer ends at its left and right edges
+  gl_ClipDistance[0] = clip.w + clip.x;
+  gl_ClipDistance[1] = clip.w - clip.x;
+  // From [-1, 1] to the slot's [-1 + 2 * view / viewCount, -1 + 2 * (view + 1) / viewCount]
+  clip.x = (clip.x + clip.w * float(2 * view + 1 - viewCount)) / float(viewCount);
+  return clip;
+}
+
+vec3 currentEye() {
+  return viewEyes[currentView()];
+}
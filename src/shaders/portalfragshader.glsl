@@ -1,9 +1,13 @@
 #version 330 core
 
 in vec2 textureCoords;
+in vec4 impostorCoords;
 
 uniform float borderWidth;
 uniform bool renderBorder;
+// Fills the portal with its image in the impostor atlas, rather than white
+uniform bool drawImpostor;
+uniform sampler2D impostorAtlas;
 
 // Output color
 out vec4 fColor;
@@ -18,6 +22,8 @@ void main() {
   } else {
     if (renderBorder) {
       discard;
+    } else if (drawImpostor) {
+      fColor = textureProj(impostorAtlas, impostorCoords.xyw);
     } else {
       fColor = vec4(1, 1, 1, 1);
     }
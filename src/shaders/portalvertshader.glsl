@@ -0,0 +1,36 @@
+#version 330 core
+
+#include "multiview.glsl"
+
+// Portals are drawn without a world effect, so this only needs the coordinates
+// and the texture coordinates of vertshader.glsl
+layout(location = 0) in vec3 vertCoordinates_in;
+layout(location = 2) in vec2 vertTextureCoords_in;
+
+// Written per object to a stream buffer (see ObjectUniforms)
+layout(std140) uniform ObjectUniforms {
+  mat4 modelViewTransform;
+  mat3 normalMatrix;
+  // Maps the quantized coordinates back onto the bounds of the mesh
+  vec3 positionOffset;
+  vec3 positionScale;
+  // The layer of the material page holding the texture (see Material)
+  int materialLayer;
+};
+
+// From the space of the modelview transforms to the image of the portal in
+// the impostor atlas, see ImpostorAtlas::getImageTransform
+uniform mat4 impostorTransform;
+
+out vec2 textureCoords;
+out vec4 impostorCoords;
+
+void main() {
+  vec3 coordinates = positionOffset + positionScale * vertCoordinates_in;
+  vec4 P = modelViewTransform * vec4(coordinates, 1.0F);
+  gl_Position = projectToView(P);
+
+  textureCoords = vertTextureCoords_in;
+  // Divided by w per fragment, the image is projected onto the portal
+  impostorCoords = impostorTransform * P;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+// A single triangle covering the screen, drawn without any vertex attributes
+
+// Maps the screen onto the part of the source texture rendered to
+uniform vec2 sourceScale;
+
+out vec2 sourceCoords;
+
+void main() {
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(2.0F * corner - 1.0F, 0.0F, 1.0F);
+  sourceCoords = corner * sourceScale;
+}
@@ -0,0 +1,29 @@
+#version 330 core
+
+in vec2 sourceCoords;
+
+// The frame, rendered at a lower resolution
+uniform sampler2D source;
+uniform vec2 sourceScale;
+uniform vec2 texelSize;
+// 0 leaves the bilinear upscale as is
+uniform float sharpness;
+
+out vec4 fColor;
+
+void main() {
+  // Do not read the texels past the part rendered to
+  vec2 coords = min(sourceCoords, sourceScale - 0.5F * texelSize);
+
+  vec3 center = texture(source, coords).rgb;
+  vec3 left = texture(source, coords - vec2(texelSize.x, 0.0F)).rgb;
+  vec3 right = texture(source, min(coords + vec2(texelSize.x, 0.0F), sourceScale - 0.5F * texelSize)).rgb;
+  vec3 down = texture(source, coords - vec2(0.0F, texelSize.y)).rgb;
+  vec3 up = texture(source, min(coords + vec2(0.0F, texelSize.y), sourceScale - 0.5F * texelSize)).rgb;
+
+  // Unsharp mask, kept within the range of the neighbourhood so edges do not ring
+  vec3 blurred = 0.25F * (left + right + down + up);
+  vec3 lowest = min(center, min(min(left, right), min(down, up)));
+  vec3 highest = max(center, max(max(left, right), max(down, up)));
+  fColor = vec4(clamp(center + sharpness * (center - blurred), lowest, highest), 1.0F);
+}
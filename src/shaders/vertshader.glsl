@@ -1,20 +1,31 @@
 #version 330 core
 
+#include "multiview.glsl"
+#include "worldeffect.glsl"
+
 // Define constants
 #define M_PI 3.141593
 
 // Specify the input locations of attributes
+// Coordinates are normalized relative to the mesh bounds, normals octahedral
+// encoded and texture coordinates half floats (see PackedVertex)
 layout(location = 0) in vec3 vertCoordinates_in;
-layout(location = 1) in vec3 vertNormal_in;
+layout(location = 1) in vec2 vertNormal_in;
 layout(location = 2) in vec2 vertTextureCoords_in;
 
 // Light properties
 uniform vec3 lightCoordinates;
 
-// Specify the Uniforms of the vertex shader
-uniform mat4 modelViewTransform;
-uniform mat4 projectionTransform;
-uniform mat3 normalMatrix;
+// Written per object to a stream buffer (see ObjectUniforms)
+layout(std140) uniform ObjectUniforms {
+  mat4 modelViewTransform;
+  mat3 normalMatrix;
+  // Maps the quantized coordinates back onto the bounds of the mesh
+  vec3 positionOffset;
+  vec3 positionScale;
+  // The layer of the material page holding the texture (see Material)
+  int materialLayer;
+};
 
 // Specify the output of the vertex stage
 out vec3 N;
@@ -22,21 +33,36 @@ out vec3 V;
 out vec3 L;
 out vec2 textureCoords;
 out vec3 vertNormal;
+flat out int textureLayer;
+
+// Inverse of the octahedral encoding of the normals
+vec3 decodeOctahedral(vec2 encoded) {
+  vec3 normal = vec3(encoded, 1.0F - abs(encoded.x) - abs(encoded.y));
+  float t = max(-normal.z, 0.0F);
+  normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0F)));
+  return normalize(normal);
+}
 
 void main() {
-  vec4 P = modelViewTransform * vec4(vertCoordinates_in, 1.0F);
+  vec3 coordinates = positionOffset + positionScale * vertCoordinates_in;
+  vec3 normal = decodeOctahedral(vertNormal_in);
+  // The effect of the world applies in model space
+  applyWorldEffect(coordinates, normal);
+
+  vec4 P = modelViewTransform * vec4(coordinates, 1.0F);
   // gl_Position is the output (a vec4) of the vertex shader
-  gl_Position = projectionTransform * P;
+  gl_Position = projectToView(P);
 
   // We are assuming that camera is outside model, so no need to flip normal
-  N = normalize(normalMatrix * vertNormal_in);
+  N = normalize(normalMatrix * normal);
 
   // Direction to light from point
   L = normalize(lightCoordinates - P.xyz);
 
-  // Direction to camera, which is placed at the origin
-  V = normalize(-P.xyz);
+  // Direction to the eye of the view
+  V = normalize(currentEye() - P.xyz);
 
   textureCoords = vertTextureCoords_in;
-  vertNormal = normalize(normalMatrix * vertNormal_in);
+  vertNormal = normalize(normalMatrix * normal);
+  textureLayer = materialLayer;
 }
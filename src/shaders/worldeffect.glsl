@@ -0,0 +1,81 @@
+// The world effect of the pass, included by the shaders that draw worlds.
+// Written once per pass, see EffectUniforms in drawlist.h and WorldEffect.
+layout(std140) uniform WorldEffect {
+  // The affine part, spun to the time of the frame
+  mat4 effectTransform;
+  mat3 effectNormalMatrix;
+  // 0: none, 1: twist, 2: bend (see WorldEffect::DEFORMATION)
+  int effectDeformation;
+  // Radians per unit, pulsed to the time of the frame
+  float effectStrength;
+};
+
+// Below this strength, a bend is too close to a straight line to divide by
+#define MIN_BEND 1e-6F
+
+vec3 twist(vec3 p) {
+  float angle = effectStrength * p.y;
+  float c = cos(angle);
+  float s = sin(angle);
+  return vec3(p.x * c - p.z * s, p.y, p.x * s + p.z * c);
+}
+
+vec3 bend(vec3 p) {
+  float angle = effectStrength * p.x;
+  float radius = 1.0F / effectStrength;
+  return vec3((radius - p.y) * sin(angle), radius - (radius - p.y) * cos(angle), p.z);
+}
+
+// Moves a point in model space into the world, and its normal along. The
+// normal is left unnormalized.
+void applyWorldEffect(inout vec3 position, inout vec3 normal) {
+  position = (effectTransform * vec4(position, 1.0F)).xyz;
+  normal = effectNormalMatrix * normal;
+
+  if (effectDeformation == 1) {
+    // The inverse transpose of the Jacobian, a shear followed by the rotation
+    float k = effectStrength;
+    normal.y += k * (position.z * normal.x - position.x * normal.z);
+    float angle = k * position.y;
+    float c = cos(angle);
+    float s = sin(angle);
+    normal = vec3(normal.x * c - normal.z * s, normal.y, normal.x * s + normal.z * c);
+    position = twist(position);
+  } else if (effectDeformation == 2 && abs(effectStrength) >= MIN_BEND) {
+    // The cofactors of the Jacobian, a stretch along x followed by the rotation
+    float stretch = 1.0F - effectStrength * position.y;
+    normal.yz *= stretch;
+    float angle = effectStrength * position.x;
+    float c = cos(angle);
+    float s = sin(angle);
+    normal = vec3(normal.x * c - normal.y * s, normal.x * s + normal.y * c, normal.z);
+    position = bend(position);
+  }
+}
+
+// A sphere in model space, turned into one around it under the effect. Must
+// match WorldEffect::mapBounds.
+void worldEffectBounds(inout vec3 center, inout float radius) {
+  center = (effectTransform * vec4(center, 1.0F)).xyz;
+  radius *= sqrt(max(max(dot(effectTransform[0].xyz, effectTransform[0].xyz),
+                         dot(effectTransform[1].xyz, effectTransform[1].xyz)),
+                     dot(effectTransform[2].xyz, effectTransform[2].xyz)));
+
+  if (effectDeformation == 1) {
+    float axial = length(center.xz);
+    float aroundAxis = length(vec2(axial + radius, radius));
+    float aroundCenter = radius * (1.0F + abs(effectStrength) * (axial + radius));
+    if (aroundCenter < aroundAxis) {
+      center = twist(center);
+      radius = aroundCenter;
+    } else {
+      center = vec3(0.0F, center.y, 0.0F);
+      radius = aroundAxis;
+    }
+  } else if (effectDeformation == 2 && abs(effectStrength) >= MIN_BEND) {
+    float stretch = max(1.0F, max(abs(1.0F - effectStrength * (center.y - radius)),
+                                  abs(1.0F - effectStrength * (center.y + radius))));
+    center = bend(center);
+    radius *= stretch;
+  }
+}
@@ -0,0 +1,35 @@
+#include "shadersource.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+
+QByteArray ShaderSource::load(QString const &fileName) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot read shader" << fileName << ":" << file.errorString();
+        return {};
+    }
+
+    static QByteArray const INCLUDE = "#include \"";
+    QString directory = QFileInfo(fileName).path();
+
+    QByteArray source;
+    QList<QByteArray> lines = file.readAll().split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        QByteArray line = lines[i].trimmed();
+        if (!line.startsWith(INCLUDE) || !line.endsWith('"')) {
+            source += lines[i] + '\n';
+            continue;
+        }
+
+        QString included = QString::fromUtf8(line.mid(INCLUDE.size(), line.size() - INCLUDE.size() - 1));
+        QByteArray includedSource = load(directory + "/" + included);
+        if (includedSource.isEmpty()) {
+            return {};
+        }
+        source += includedSource;
+        source += "#line " + QByteArray::number(i + 2) + '\n';
+    }
+    return source;
+}
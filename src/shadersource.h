@@ -0,0 +1,20 @@
+#ifndef SHADERSOURCE_H
+#define SHADERSOURCE_H
+
+#include <QByteArray>
+#include <QString>
+
+/*
+ * Reads the source of a shader, with every line #include "<file>" replaced
+ * by that file, from the same directory, as GLSL has no includes of its own.
+ * Line numbers after an include are reset to those of the including file, so
+ * compile errors point at the right line.
+ */
+class ShaderSource
+{
+public:
+    // Empty, having warned, if a file does not read
+    static QByteArray load(QString const &fileName);
+};
+
+#endif // SHADERSOURCE_H
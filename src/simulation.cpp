@@ -0,0 +1,221 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// The near plane distance of the projection, see MainView::updateProjectionTransform
+constexpr float NEAR_PLANE = 0.2F;
+
+// A tick never simulates more than this, e.g. after the process was suspended
+constexpr int MAX_TICKS_BEHIND = 4;
+
+/*
+ * Where the center of the near plane is in the scene. Crossings are tested for
+ * this point rather than the camera itself, so the world switches before the
+ * near plane starts clipping the portal. The camera stores the translation
+ * that moves the scene, hence the negation.
+ */
+QVector3D crossingPoint(Camera &camera) {
+    return -(camera.getPosition() + NEAR_PLANE * camera.viewVector());
+}
+
+}
+
+Simulation::Simulation(PortalTable const &portals)
+    : portalPositions{portals.positions},
+      portalEffects{portals.effects},
+      portalCollisions{portals.collisions},
+      portalSweep{portals.positions} {
+    previousTickTime = tickTime = KeyboardStatus::Clock::now();
+
+    // Make sure the renderer has something to read before the first tick
+    publish(camera.getPose());
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running.exchange(true)) return;
+
+    thread = std::thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+    if (!running.exchange(false)) return;
+
+    thread.join();
+}
+
+void Simulation::updateKeyStatus(int key, KeyboardStatus::KEY_STATUS status,
+                                 KeyboardStatus::Clock::time_point time) {
+    KeyboardStatus::ACTION action;
+    if (!KeyboardStatus::actionFor(key, action)) return;
+
+    std::lock_guard<std::mutex> lock(inputMutex);
+    pendingEvents.push_back({action, status, time});
+}
+
+void Simulation::takeAppliedInputs(std::vector<KeyboardStatus::Clock::time_point> &times) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    times.insert(times.end(), appliedInputs.begin(), appliedInputs.end());
+    appliedInputs.clear();
+}
+
+void Simulation::run() {
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (running.load()) {
+        tick();
+
+        nextTick += tickDuration();
+        auto now = std::chrono::steady_clock::now();
+        if (now - nextTick > MAX_TICKS_BEHIND * tickDuration()) {
+            // Fell too far behind (e.g. the process was suspended), don't try to catch up
+            nextTick = now;
+        }
+        std::this_thread::sleep_until(nextTick);
+    }
+}
+
+void Simulation::setRecording(bool recording) {
+    this->recording = recording;
+    if (recording) {
+        // An hour's worth, so recording does not reallocate along the way
+        recorded.reserve(3600 * TICK_RATE);
+    }
+}
+
+void Simulation::tick() {
+    Camera::Pose previousCamera = camera.getPose();
+    QVector3D previousPosition = crossingPoint(camera);
+
+    // Every event taken was stamped before now, so none is in the future
+    {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        std::swap(events, pendingEvents);
+    }
+    previousTickTime = tickTime;
+    tickTime = KeyboardStatus::Clock::now();
+
+    // From here on the tick only depends on its input in ticks, which is what gets recorded
+    auto start = std::max(previousTickTime, tickTime - MAX_TICKS_BEHIND * tickDuration());
+    auto ticksSince = [&](KeyboardStatus::Clock::time_point time) {
+        return std::chrono::duration<float>(time - start) / std::chrono::duration<float>(tickDuration());
+    };
+    float span = ticksSince(tickTime);
+    tickEvents.clear();
+    for (auto const &event : events) {
+        tickEvents.push_back({event.action, event.status, ticksSince(std::clamp(event.time, start, tickTime))});
+    }
+
+    applyInput(span, tickEvents.data(), tickEvents.size());
+    updatePortalEffectTransforms(previousPosition);
+    if (recording) {
+        recorded.addTick(span, tickEvents.data(), tickEvents.size(), camera.getPose(), currentWorldId);
+    }
+
+    ++tickCount;
+    publish(previousCamera);
+
+    if (!events.empty()) {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        for (auto const &event : events) {
+            appliedInputs.push_back(event.time);
+        }
+    }
+    events.clear();
+}
+
+bool Simulation::replayTick(InputRecording const &recording, size_t tick) {
+    InputRecording::Tick const &recordedTick = recording.tick(tick);
+
+    Camera::Pose previousCamera = camera.getPose();
+    QVector3D previousPosition = crossingPoint(camera);
+
+    applyInput(recordedTick.span, recording.eventsOf(recordedTick), recordedTick.eventCount);
+    Camera::Pose moved = camera.getPose();
+    bool matches = std::memcmp(&moved, &recordedTick.camera, sizeof(moved)) == 0;
+
+    // Following the recorded camera keeps the path the same, even if the input moves it differently
+    camera.setPose(recordedTick.camera);
+    updatePortalEffectTransforms(previousPosition);
+    matches = matches && currentWorldId == recordedTick.worldId;
+
+    previousTickTime = tickTime;
+    tickTime = KeyboardStatus::Clock::now();
+    ++tickCount;
+    publish(previousCamera);
+
+    return matches;
+}
+
+void Simulation::applyInput(float span, InputRecording::Event const *events, size_t eventCount) {
+    // Every action moves the camera for as long as it was held within the tick
+    float time = 0;
+    for (size_t i = 0; i < eventCount; ++i) {
+        float at = std::clamp(events[i].at, time, span);
+        camera.update(keyboardStatus.getActions(), at - time);
+        keyboardStatus.updateStatus(events[i].action, events[i].status);
+        time = at;
+    }
+    camera.update(keyboardStatus.getActions(), span - time);
+}
+
+void Simulation::publish(Camera::Pose const &previousCamera) {
+    RenderSnapshot &snapshot = snapshots.writeBuffer();
+
+    snapshot.tick = tickCount;
+    snapshot.previousTickTime = previousTickTime;
+    snapshot.tickTime = tickTime;
+    snapshot.previousCamera = previousCamera;
+    snapshot.camera = camera.getPose();
+    snapshot.actions = keyboardStatus.getActions();
+    snapshot.inPortal = inPortal;
+    snapshot.currentWorldId = currentWorldId;
+    snapshot.currentWorldEffect = currentWorldEffect;
+    snapshot.currentShaderType = currentShaderType;
+    snapshot.portalCollisions = portalCollisions;
+
+    snapshots.publish();
+}
+
+void Simulation::updatePortalEffectTransforms(QVector3D const &previousPosition) {
+    QVector3D position = crossingPoint(camera);
+
+    portalSweep.sweep(previousPosition, position, crossings);
+    for (auto const &crossing : crossings) {
+        crossPortal(crossing.portal);
+    }
+
+    for (size_t portal = 0; portal < portalPositions.size(); ++portal) {
+        updatePortalCollision(portal);
+    }
+}
+
+void Simulation::crossPortal(size_t portal) {
+    PortalEffect const &effect = portalEffects[portal];
+
+    if (inPortal) {
+        inPortal = false;
+        currentWorldEffect = WorldEffect{};
+        currentShaderType = ShaderType::PHONG;
+        currentWorldId = -1;
+    } else {
+        currentWorldEffect = effect.worldEffect;
+        currentShaderType = effect.shaderType;
+        currentWorldId = effect.worldId;
+        inPortal = true;
+    }
+}
+
+void Simulation::updatePortalCollision(size_t portal) {
+    PortalCollision &collision = portalCollisions[portal];
+    QVector3D position = -camera.getPosition();
+
+    collision.cameraDistance = (position - portalPositions[portal]).length();
+    collision.collisionState = portalSweep.side(portal, position);
+}
@@ -0,0 +1,158 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include "camera.h"
+#include "inputrecording.h"
+#include "keyboardstatus.h"
+#include "portalsweep.h"
+#include "scenestore.h"
+#include "ShaderType.h"
+#include "triplebuffer.h"
+
+/*
+ * The state of one simulation tick, as the renderer sees it.
+ */
+struct RenderSnapshot
+{
+    uint64_t tick = 0;
+    // The span of time the tick simulated, up to when it sampled the input
+    std::chrono::steady_clock::time_point previousTickTime;
+    std::chrono::steady_clock::time_point tickTime;
+
+    // The camera at the previous and at this tick, to interpolate between
+    Camera::Pose previousCamera{};
+    Camera::Pose camera{};
+    // Held at the end of the tick, to extrapolate the camera with
+    KeyboardStatus::Actions actions;
+
+    // The world the camera is in
+    bool inPortal = false;
+    int currentWorldId = -1;
+    WorldEffect currentWorldEffect;
+    ShaderType currentShaderType = ShaderType::PHONG;
+
+    // Per portal, in the order of the scene's PortalTable
+    std::vector<PortalCollision> portalCollisions;
+};
+
+/*
+ * Runs input handling, camera movement and portal crossing on its own thread,
+ * at a fixed tick rate, independent of the frame rate.
+ *
+ * Input arrives as timestamped key events. A tick applies the events that
+ * arrived since the previous one in order, moving the camera for exactly as
+ * long as each action was held, so a tap moves the camera as far as it was
+ * held rather than a whole tick.
+ *
+ * Every tick is published as a RenderSnapshot, which the GL thread reads
+ * without locking.
+ */
+class Simulation
+{
+public:
+    // The ticks per second. Camera speeds are expressed per tick.
+    static constexpr int TICK_RATE = 60;
+
+    static constexpr std::chrono::nanoseconds tickDuration() {
+        return std::chrono::nanoseconds(1000000000 / TICK_RATE);
+    }
+
+    explicit Simulation(PortalTable const &portals);
+    ~Simulation();
+
+    Simulation(Simulation const &) = delete;
+    Simulation &operator=(Simulation const &) = delete;
+
+    void start();
+    void stop();
+
+    /*
+     * Whether the ticks to come are added to getRecording(). Only to be
+     * changed, and the recording read, while the simulation is stopped.
+     */
+    void setRecording(bool recording);
+    InputRecording const &getRecording() const { return recorded; }
+
+    /*
+     * Runs a tick of a recording on the calling thread, instead of a tick of
+     * live input, and publishes it. Only while the simulation is stopped.
+     * The camera follows the recording exactly. Returns false if the tick's
+     * input did not move the camera, or cross portals, as it did when it was
+     * recorded.
+     */
+    bool replayTick(InputRecording const &recording, size_t tick);
+
+    /*
+     * Safe to call from any thread. Keys that are not mapped to an action
+     * are ignored.
+     */
+    void updateKeyStatus(int key, KeyboardStatus::KEY_STATUS status,
+                         KeyboardStatus::Clock::time_point time);
+
+    /*
+     * Appends the times of the input events applied by published ticks since
+     * the last call, to measure latency against. Called before
+     * latestSnapshot(), every event taken is in the snapshot it returns.
+     */
+    void takeAppliedInputs(std::vector<KeyboardStatus::Clock::time_point> &times);
+
+    // GL thread only: the latest published tick
+    RenderSnapshot const &latestSnapshot() { return snapshots.read(); }
+
+private:
+    void run();
+    void tick();
+    // Moves the camera over a tick by the actions held and the events within it
+    void applyInput(float span, InputRecording::Event const *events, size_t eventCount);
+    void publish(Camera::Pose const &previousCamera);
+
+    // Switches worlds for every portal the camera passed through this tick
+    void updatePortalEffectTransforms(QVector3D const &previousPosition);
+    void crossPortal(size_t portal);
+    void updatePortalCollision(size_t portal);
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    // Written by the GUI thread, taken once per tick
+    std::mutex inputMutex;
+    std::vector<KeyboardStatus::Event> pendingEvents;
+    // Written by the simulation thread after publishing, taken by the GL thread
+    std::vector<KeyboardStatus::Clock::time_point> appliedInputs;
+
+    // Owned by the simulation thread
+    KeyboardStatus keyboardStatus;
+    std::vector<KeyboardStatus::Event> events;
+    std::vector<InputRecording::Event> tickEvents;
+    bool recording = false;
+    InputRecording recorded;
+    Camera camera;
+    uint64_t tickCount = 0;
+    KeyboardStatus::Clock::time_point previousTickTime;
+    KeyboardStatus::Clock::time_point tickTime;
+
+    std::vector<QVector3D> portalPositions;
+    std::vector<PortalEffect> portalEffects;
+    std::vector<PortalCollision> portalCollisions;
+    PortalSweep portalSweep;
+    std::vector<PortalSweep::Crossing> crossings;
+
+    bool inPortal = false;
+    int currentWorldId = -1;
+    WorldEffect currentWorldEffect;
+    ShaderType currentShaderType = ShaderType::PHONG;
+
+    TripleBuffer<RenderSnapshot> snapshots;
+};
+
+#endif // SIMULATION_H
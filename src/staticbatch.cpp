@@ -0,0 +1,35 @@
+#include "staticbatch.h"
+
+#include <algorithm>
+
+void StaticBatcher::add(RenderHandle &rh, EncodedMesh const &encoded, QVector<unsigned> const &indices,
+                        QVector3D const &position) {
+    auto batch = std::find_if(batches.begin(), batches.end(),
+                              [&](Batch const &b) { return b.page == rh.material.page; });
+    if (batch == batches.end()) {
+        batches.emplace_back();
+        batch = batches.end() - 1;
+        batch->page = rh.material.page;
+    }
+
+    GLuint object = static_cast<GLuint>(batch->records.size());
+    Record record{};
+    for (int i = 0; i < 3; ++i) {
+        record.position[i] = position[i];
+        record.positionOffset[i] = encoded.positionOffset[i];
+        record.positionScale[i] = encoded.positionScale[i];
+    }
+    record.materialLayer = static_cast<float>(rh.material.layer);
+    batch->records.push_back(record);
+
+    // The indices keep the meshlet order, moved past the vertices already in the batch
+    GLuint firstVertex = static_cast<GLuint>(batch->vertices.size());
+    rh.batch = static_cast<int>(batch - batches.begin());
+    rh.firstIndex = static_cast<GLuint>(batch->indices.size());
+
+    batch->vertices.insert(batch->vertices.end(), encoded.vertices.begin(), encoded.vertices.end());
+    batch->objectIndices.resize(batch->vertices.size(), object);
+    for (unsigned index : indices) {
+        batch->indices.push_back(firstVertex + index);
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef STATICBATCH_H
+#define STATICBATCH_H
+
+#include <GL/gl.h>
+
+#include <vector>
+
+#include <QVector3D>
+#include <QVector>
+
+#include "scenestore.h"
+#include "vertexencoding.h"
+
+/*
+ * Merges the meshes of a world that a single object uses into one vertex
+ * and index buffer per material page, when the world is loaded. A mesh that
+ * several objects use keeps buffers of its own, which its objects share
+ * already.
+ *
+ * The vertices stay in model space, tagged with the index of their object
+ * in the batch. The vertex shader (shaders/batchvertshader.glsl) looks up
+ * the position and material layer of the object with it, so all objects of
+ * a batch are drawn with one glMultiDrawElements of the ranges of their
+ * visible meshlets. Neighbouring objects that are visible as a whole merge
+ * into one range.
+ */
+class StaticBatcher
+{
+public:
+    // An object in a batch, as three RGBA32F texels
+    struct Record {
+        float position[3];
+        float materialLayer;
+        float positionOffset[4];
+        float positionScale[4];
+    };
+
+    // A batch on the CPU, ready to be uploaded
+    struct Batch {
+        GLuint page = 0;
+        std::vector<PackedVertex> vertices;
+        std::vector<GLuint> objectIndices;
+        std::vector<GLuint> indices;
+        std::vector<Record> records;
+    };
+
+    /*
+     * Adds the mesh of an object to the batch of its material page. Sets the
+     * batch and firstIndex of the render handle, which has to hold the rest
+     * of the mesh's data and the material already.
+     */
+    void add(RenderHandle &rh, EncodedMesh const &encoded, QVector<unsigned> const &indices,
+             QVector3D const &position);
+
+    // In the order of RenderHandle::batch
+    std::vector<Batch> const &getBatches() const { return batches; }
+
+private:
+    std::vector<Batch> batches;
+};
+
+#endif // STATICBATCH_H
@@ -0,0 +1,126 @@
+#include "mainview.h"
+
+/*
+ * The static batches of the worlds (see StaticBatcher) are drawn on the GL 3.3
+ * path by batchShaders, one glMultiDrawElements per batch and pass. On the
+ * indirect path, the objects of a batch are records like any other, which
+ * share a vertex array and material page and so are drawn by one command.
+ */
+
+namespace {
+
+// The texture unit the records of a batch are bound to, next to the material page
+constexpr GLint RECORDS_UNIT = 1;
+
+}
+
+/**
+ * @brief MainView::uploadStaticBatches Uploads the batches of a table.
+ * @param batcher The batches the meshes of the objects were merged into.
+ * @param objects The objects, whose render handles refer to the batches.
+ */
+void MainView::uploadStaticBatches(StaticBatcher const &batcher, ObjectTable &objects) {
+    for (auto const &data : batcher.getBatches()) {
+        StaticBatch batch;
+        batch.page = data.page;
+
+        glGenVertexArrays(1, &batch.vao);
+        glBindVertexArray(batch.vao);
+
+        glGenBuffers(1, &batch.vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.vbo);
+        glBufferData(GL_ARRAY_BUFFER, data.vertices.size() * sizeof(PackedVertex), data.vertices.data(),
+                     GL_STATIC_DRAW);
+        setVertexAttributes();
+
+        // The object of every vertex to location 4, which only the batch shader reads
+        glGenBuffers(1, &batch.objectIndices);
+        glBindBuffer(GL_ARRAY_BUFFER, batch.objectIndices);
+        glBufferData(GL_ARRAY_BUFFER, data.objectIndices.size() * sizeof(GLuint), data.objectIndices.data(),
+                     GL_STATIC_DRAW);
+        glVertexAttribIPointer(4, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+        glEnableVertexAttribArray(4);
+
+        glGenBuffers(1, &batch.ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indices.size() * sizeof(GLuint), data.indices.data(),
+                     GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        glGenBuffers(1, &batch.records);
+        glBindBuffer(GL_TEXTURE_BUFFER, batch.records);
+        glBufferData(GL_TEXTURE_BUFFER, data.records.size() * sizeof(StaticBatcher::Record), data.records.data(),
+                     GL_STATIC_DRAW);
+        glGenTextures(1, &batch.recordsTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, batch.recordsTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, batch.records);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        qDebug() << ":: Batched" << data.records.size() << "meshes into" << data.vertices.size() << "vertices and"
+                 << data.indices.size() << "indices";
+        objects.batches.push_back(batch);
+    }
+
+    // The objects draw their own ranges out of the batch as well, e.g. under an occlusion query
+    for (auto &rh : objects.renderHandles) {
+        if (rh.batch >= 0) {
+            rh.vao = objects.batches[rh.batch].vao;
+        }
+    }
+}
+
+void MainView::releaseStaticBatches(ObjectTable &objects) {
+    for (auto &batch : objects.batches) {
+        glDeleteVertexArrays(1, &batch.vao);
+        glDeleteBuffers(1, &batch.vbo);
+        glDeleteBuffers(1, &batch.objectIndices);
+        glDeleteBuffers(1, &batch.ebo);
+        glDeleteTextures(1, &batch.recordsTexture);
+        glDeleteBuffers(1, &batch.records);
+    }
+    objects.batches.clear();
+}
+
+/**
+ * @brief MainView::paintBatches Draws the batches of a draw list, with the
+ * effect of the pass bound.
+ * @param drawList The draw list.
+ */
+void MainView::paintBatches(DrawList const &drawList) {
+    QOpenGLShaderProgram &shaderProgram = batchShaders[drawList.shaderType];
+    shaderProgram.bind();
+    setShadingUniforms(shaderProgram);
+
+    // Only the camera, the objects are moved to their positions by the shader
+    QMatrix4x4 passTransform = camera.getModelTransform();
+    setViewUniforms(shaderProgram);
+    shaderProgram.setUniformValue("passTransform", passTransform);
+    shaderProgram.setUniformValue("normalMatrix", passTransform.normalMatrix());
+    shaderProgram.setUniformValue("sampler", 0);
+    shaderProgram.setUniformValue("objectRecords", RECORDS_UNIT);
+
+    for (auto const &draw : drawList.batchDraws) {
+        if (draw.rangeCounts.empty()) continue;
+
+        glActiveTexture(GL_TEXTURE0 + RECORDS_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, draw.recordsTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, draw.page);
+        glBindVertexArray(draw.vao);
+
+        if (views.count() == 1) {
+            glMultiDrawElements(GL_TRIANGLES, draw.rangeCounts.data(), GL_UNSIGNED_INT, draw.rangeOffsets.data(),
+                                static_cast<GLsizei>(draw.rangeCounts.size()));
+            continue;
+        }
+        for (size_t range = 0; range < draw.rangeCounts.size(); ++range) {
+            glDrawElementsInstanced(GL_TRIANGLES, draw.rangeCounts[range], GL_UNSIGNED_INT,
+                                    draw.rangeOffsets[range], views.count());
+        }
+    }
+
+    shaderProgram.release();
+}
@@ -0,0 +1,168 @@
+#include "streambuffer.h"
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QOpenGLVersionFunctionsFactory>
+#endif
+
+namespace {
+
+// Used until a frame asks for more
+constexpr size_t INITIAL_FRAME_SIZE = 1 << 20;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+void StreamBuffer::initialize(QOpenGLContext *context, QOpenGLFunctions_3_3_Core *gl) {
+    this->gl = gl;
+
+    QSurfaceFormat format = context->format();
+    if (std::make_pair(format.majorVersion(), format.minorVersion()) >= std::make_pair(4, 4)) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        persistentGl = QOpenGLVersionFunctionsFactory::get<QOpenGLFunctions_4_4_Core>(context);
+#else
+        persistentGl = context->versionFunctions<QOpenGLFunctions_4_4_Core>();
+#endif
+        if (persistentGl != nullptr && !persistentGl->initializeOpenGLFunctions()) {
+            persistentGl = nullptr;
+        }
+    }
+    qDebug() << ":: Streaming per-frame data"
+             << (persistentGl != nullptr ? "through a persistent mapping" : "by orphaning");
+
+    create(INITIAL_FRAME_SIZE);
+}
+
+void StreamBuffer::initializeInMemory() {
+    gl = nullptr;
+    persistentGl = nullptr;
+    create(INITIAL_FRAME_SIZE);
+}
+
+void StreamBuffer::destroy() {
+    release();
+    gl = nullptr;
+    persistentGl = nullptr;
+}
+
+void StreamBuffer::create(size_t frameSize) {
+    this->frameSize = frameSize;
+    if (gl == nullptr) {
+        staging.resize(frameSize);
+        return;
+    }
+
+    gl->glGenBuffers(1, &buffer);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+    if (persistentGl != nullptr) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        persistentGl->glBufferStorage(GL_COPY_WRITE_BUFFER, FRAMES * frameSize, nullptr, flags);
+        mapping = static_cast<char *>(gl->glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, FRAMES * frameSize, flags));
+    } else {
+        staging.resize(frameSize);
+    }
+
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::release() {
+    region = nullptr;
+    staging.clear();
+    if (gl == nullptr) return;
+
+    for (auto &fence : fences) {
+        waitFor(fence);
+    }
+
+    if (mapping != nullptr) {
+        gl->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        gl->glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapping = nullptr;
+    }
+    gl->glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+void StreamBuffer::waitFor(GLsync &fence) {
+    if (fence == nullptr) return;
+
+    // Flushing once makes sure the fence gets submitted at all
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (gl->glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) {
+        flags = 0;
+    }
+    gl->glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamBuffer::beginFrame(size_t frameSize) {
+    if (frameSize > this->frameSize) {
+        size_t grown = this->frameSize;
+        while (grown < frameSize) {
+            grown *= 2;
+        }
+        release();
+        create(grown);
+    }
+
+    size_t index = frame % FRAMES;
+    if (persistentGl != nullptr) {
+        waitFor(fences[index]);
+        regionOffset = static_cast<GLintptr>(index * this->frameSize);
+        region = mapping + regionOffset;
+    } else {
+        // Orphan the storage of the previous frames, the GPU may still be reading it
+        if (gl != nullptr) {
+            gl->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            gl->glBufferData(GL_COPY_WRITE_BUFFER, this->frameSize, nullptr, GL_STREAM_DRAW);
+            gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        regionOffset = 0;
+        region = staging.data();
+    }
+
+    head.store(0);
+    flushed = 0;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment) {
+    size_t current = head.load(std::memory_order_relaxed);
+    size_t offset;
+    do {
+        offset = alignUp(current, alignment);
+        if (offset + size > frameSize) {
+            return {};
+        }
+    } while (!head.compare_exchange_weak(current, offset + size, std::memory_order_relaxed));
+
+    return {region + offset, regionOffset + static_cast<GLintptr>(offset)};
+}
+
+void StreamBuffer::flush() {
+    size_t end = std::min(head.load(), frameSize);
+    if (persistentGl != nullptr || gl == nullptr || end <= flushed) {
+        // Coherent, writes are visible to the commands issued after them
+        flushed = end;
+        return;
+    }
+
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    gl->glBufferSubData(GL_COPY_WRITE_BUFFER, flushed, end - flushed, staging.data() + flushed);
+    gl->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    flushed = end;
+}
+
+void StreamBuffer::endFrame() {
+    if (persistentGl != nullptr) {
+        fences[frame % FRAMES] = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    ++frame;
+}
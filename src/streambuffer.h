@@ -0,0 +1,92 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLFunctions_4_4_Core>
+
+/*
+ * A ring buffer for data written anew every frame (uniform blocks, storage
+ * buffers, vertices), sub-allocated in place.
+ *
+ * With GL 4.4, the buffer is mapped once, persistently and coherently, and
+ * split in FRAMES regions. A frame writes straight into its region, which a
+ * fence guards until the GPU has read it, so writing never waits on the
+ * frames still in flight.
+ *
+ * Without, the frame's data is written to memory on the CPU and uploaded on
+ * flush(), into a buffer orphaned at the start of every frame, so the driver
+ * does not wait on the previous frame either.
+ *
+ * allocate() may be called from any thread, everything else only from the GL
+ * thread.
+ */
+class StreamBuffer
+{
+public:
+    static constexpr size_t FRAMES = 3;
+
+    struct Allocation {
+        // Where to write the data, nullptr if the frame is out of space
+        void *data = nullptr;
+        // Where the data is in getBuffer()
+        GLintptr offset = 0;
+    };
+
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLContext *context, QOpenGLFunctions_3_3_Core *gl);
+    // Without GL: the data only goes to memory and is never uploaded, for
+    // timing the CPU side (see DrawListBenchmark)
+    void initializeInMemory();
+    void destroy();
+
+    bool isPersistent() const { return persistentGl != nullptr; }
+    GLuint getBuffer() const { return buffer; }
+
+    /*
+     * Starts writing the data of a frame, of at most frameSize bytes
+     * including alignment. Grows the buffer if needed, which waits for the
+     * frames in flight.
+     */
+    void beginFrame(size_t frameSize);
+
+    // Alignment has to be a power of two
+    Allocation allocate(size_t size, size_t alignment);
+
+    // Makes the data allocated since the last flush visible to the GPU
+    void flush();
+
+    void endFrame();
+
+private:
+    void create(size_t frameSize);
+    void release();
+    void waitFor(GLsync &fence);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    // Only set if the buffer is persistently mapped
+    QOpenGLFunctions_4_4_Core *persistentGl = nullptr;
+
+    GLuint buffer = 0;
+    size_t frameSize = 0;
+    size_t frame = 0;
+
+    // Start of the current frame's region, and what has been allocated in it
+    char *region = nullptr;
+    GLintptr regionOffset = 0;
+    std::atomic<size_t> head{0};
+    size_t flushed = 0;
+
+    // Persistent: the whole mapped buffer and a fence per region
+    char *mapping = nullptr;
+    std::array<GLsync, FRAMES> fences{};
+
+    // Orphaning: the frame's data before upload
+    std::vector<char> staging;
+};
+
+#endif // STREAMBUFFER_H
@@ -1,5 +0,0 @@
-#include "texturedobject.h"
-
-
-TexturedObject::TexturedObject(QVector3D position)
-    : SceneObject{position} {}
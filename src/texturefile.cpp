@@ -0,0 +1,198 @@
+#include "texturefile.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtGlobal>
+
+namespace {
+
+constexpr char MAGIC[4] = {'M', 'W', 'T', 'X'};
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 24, "FileHeader should not be padded");
+
+// Where a level starts, the coarser ones come before it
+qint64 levelOffset(int width, int height, int level) {
+    qint64 offset = sizeof(FileHeader);
+    for (int coarser = TextureFile::levelCount(width, height) - 1; coarser > level; --coarser) {
+        offset += static_cast<qint64>(TextureFile::levelBytes(width, height, coarser));
+    }
+    return offset;
+}
+
+bool readHeader(QFile &file, FileHeader &header) {
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header) ||
+        std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.width == 0 || header.height == 0 ||
+        static_cast<int>(header.levelCount) != TextureFile::levelCount(header.width, header.height)) {
+        qWarning() << "Invalid texture file" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+// Halves a level with a box filter, the last row / column is repeated for odd sizes
+QVector<quint8> downsample(QVector<quint8> const &pixels, int width, int height) {
+    int halfWidth = TextureFile::levelWidth(width, 1);
+    int halfHeight = TextureFile::levelWidth(height, 1);
+    QVector<quint8> half(halfWidth * halfHeight * 4);
+
+    for (int y = 0; y < halfHeight; ++y) {
+        int y0 = std::min(2 * y, height - 1);
+        int y1 = std::min(2 * y + 1, height - 1);
+        for (int x = 0; x < halfWidth; ++x) {
+            int x0 = std::min(2 * x, width - 1);
+            int x1 = std::min(2 * x + 1, width - 1);
+            for (int channel = 0; channel < 4; ++channel) {
+                int sum = pixels[(y0 * width + x0) * 4 + channel] + pixels[(y0 * width + x1) * 4 + channel] +
+                          pixels[(y1 * width + x0) * 4 + channel] + pixels[(y1 * width + x1) * 4 + channel];
+                half[(y * halfWidth + x) * 4 + channel] = static_cast<quint8>((sum + 2) / 4);
+            }
+        }
+    }
+    return half;
+}
+
+}
+
+int TextureFile::levelCount(int width, int height) {
+    int levels = 1;
+    while ((std::max(width, height) >> levels) > 0) {
+        ++levels;
+    }
+    return levels;
+}
+
+size_t TextureFile::levelBytes(int width, int height, int level) {
+    return static_cast<size_t>(levelWidth(width, level)) * levelWidth(height, level) * 4;
+}
+
+bool TextureFile::compile(QString const &imageFileName, QString const &textureFileName) {
+    // Same layout as TextureData: RGBA, with (0,0) bottom left
+    QImage image = QImage{imageFileName}.mirrored().convertToFormat(QImage::Format_RGBA8888);
+    if (image.isNull()) {
+        qWarning() << "Could not load texture" << imageFileName;
+        return false;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = static_cast<uint32_t>(image.width());
+    header.height = static_cast<uint32_t>(image.height());
+    header.levelCount = static_cast<uint32_t>(levelCount(image.width(), image.height()));
+
+    // Built from the full size level down, written the other way around
+    std::vector<QVector<quint8>> levels(header.levelCount);
+    levels[0].resize(image.width() * image.height() * 4);
+    for (int y = 0; y < image.height(); ++y) {
+        std::memcpy(levels[0].data() + y * image.width() * 4, image.constScanLine(y), image.width() * 4);
+    }
+    for (size_t level = 1; level < levels.size(); ++level) {
+        levels[level] = downsample(levels[level - 1], levelWidth(image.width(), static_cast<int>(level) - 1),
+                                   levelWidth(image.height(), static_cast<int>(level) - 1));
+    }
+
+    // Written to a temporary file first, so other threads never read half of it
+    QSaveFile file(textureFileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write texture" << textureFileName;
+        return false;
+    }
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+        file.write(reinterpret_cast<char const *>(level->constData()), level->size());
+    }
+    if (!file.commit()) {
+        qWarning() << "Could not write texture" << textureFileName << "-" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString TextureFile::resolve(QString const &fileName) {
+    if (fileName.endsWith(".mwt")) {
+        return fileName;
+    }
+
+    // Named after the image and when it last changed, so an edited image is converted again
+    QFileInfo info(fileName);
+    QString key = QString("%1:%2:%3").arg(info.absoluteFilePath()).arg(info.size())
+                      .arg(info.lastModified().toMSecsSinceEpoch());
+    QDir cache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures");
+    QString textureFileName = cache.filePath(QString("%1.mwt").arg(static_cast<qulonglong>(qHash(key)), 16, 16, QChar('0')));
+    if (QFile::exists(textureFileName)) {
+        return textureFileName;
+    }
+
+    if (!cache.mkpath(".") || !compile(fileName, textureFileName)) {
+        return QString();
+    }
+    qDebug() << ":: Converted" << fileName << "into" << textureFileName;
+    return textureFileName;
+}
+
+TextureData TextureFile::loadResident(QString const &fileName) {
+    TextureData missing{QString(), 1, 1, 0, QVector<quint8>(4, 255)};
+
+    TextureData texture;
+    texture.fileName = resolve(fileName);
+
+    QFile file(texture.fileName);
+    FileHeader header;
+    if (texture.fileName.isEmpty() || !file.open(QIODevice::ReadOnly) || !readHeader(file, header)) {
+        qWarning() << "Could not load texture" << fileName;
+        return missing;
+    }
+    texture.width = static_cast<int>(header.width);
+    texture.height = static_cast<int>(header.height);
+
+    // The finest level that still fits, and all coarser ones, which come before it
+    texture.firstLevel = static_cast<int>(header.levelCount) - 1;
+    while (texture.firstLevel > 0 &&
+           std::max(levelWidth(texture.width, texture.firstLevel - 1),
+                    levelWidth(texture.height, texture.firstLevel - 1)) <= RESIDENT_SIZE) {
+        --texture.firstLevel;
+    }
+    qint64 end = levelOffset(texture.width, texture.height, texture.firstLevel) +
+                 static_cast<qint64>(levelBytes(texture.width, texture.height, texture.firstLevel));
+
+    texture.pixels.resize(static_cast<int>(end - sizeof(FileHeader)));
+    if (file.read(reinterpret_cast<char *>(texture.pixels.data()), texture.pixels.size()) != texture.pixels.size()) {
+        qWarning() << "Texture file" << texture.fileName << "is too short";
+        return missing;
+    }
+    return texture;
+}
+
+bool TextureFile::readLevel(QString const &textureFileName, int level, QVector<quint8> &pixels) {
+    QFile file(textureFileName);
+    FileHeader header;
+    if (!file.open(QIODevice::ReadOnly) || !readHeader(file, header) ||
+        level >= static_cast<int>(header.levelCount)) {
+        return false;
+    }
+
+    int width = static_cast<int>(header.width);
+    int height = static_cast<int>(header.height);
+    pixels.resize(static_cast<int>(levelBytes(width, height, level)));
+    return file.seek(levelOffset(width, height, level)) &&
+           file.read(reinterpret_cast<char *>(pixels.data()), pixels.size()) == pixels.size();
+}
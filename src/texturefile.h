@@ -0,0 +1,54 @@
+#ifndef TEXTUREFILE_H
+#define TEXTUREFILE_H
+
+#include <algorithm>
+
+#include <QString>
+#include <QVector>
+
+#include "world.h"
+
+/*
+ * Textures on disk with their whole mip chain, so they can be streamed in a
+ * level at a time.
+ *
+ * The file is a little endian header followed by the levels in RGBA8, with
+ * (0,0) bottom left, ordered from the coarsest (1x1) level to the full size
+ * one. The coarse levels every texture keeps resident are therefore a single
+ * read from the start of the file, and any finer level one read at an offset
+ * that follows from the size.
+ *
+ * Images in any other format are converted once, into the cache directory,
+ * on first use. Everything in here may be called from any thread.
+ */
+class TextureFile
+{
+public:
+    // Levels of at most this many texels on either side are always resident
+    static constexpr int RESIDENT_SIZE = 64;
+
+    static int levelCount(int width, int height);
+    static int levelWidth(int width, int level) { return std::max(1, width >> level); }
+    static size_t levelBytes(int width, int height, int level);
+
+    // Converts an image into a texture file
+    static bool compile(QString const &imageFileName, QString const &textureFileName);
+
+    /*
+     * The texture file of a texture: fileName itself if it is one, otherwise
+     * the one converted from the image, which is done now if it has not been
+     * before. Returns an empty string if the image does not load.
+     */
+    static QString resolve(QString const &fileName);
+
+    /*
+     * Loads a texture's size and its levels of at most RESIDENT_SIZE.
+     * Returns a white 1x1 texture if it does not load.
+     */
+    static TextureData loadResident(QString const &fileName);
+
+    // Reads one level of a texture file, in the layout glTexSubImage3D takes
+    static bool readLevel(QString const &textureFileName, int level, QVector<quint8> &pixels);
+};
+
+#endif // TEXTUREFILE_H
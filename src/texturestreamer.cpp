@@ -0,0 +1,226 @@
+#include "texturestreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <QDebug>
+
+#include "texturefile.h"
+
+void TextureStreamer::initialize(QOpenGLFunctions_3_3_Core *gl, Settings settings) {
+    this->gl = gl;
+    this->settings = settings;
+    qDebug() << ":: Streaming texture levels within" << settings.memoryBudget / (1024 * 1024) << "MB";
+}
+
+void TextureStreamer::destroy() {
+    if (gl == nullptr) return;
+
+    // Waits for the loads still running
+    pendingLoads.clear();
+    for (auto const &pair : pages) {
+        gl->glDeleteTextures(1, &pair.first);
+    }
+    pages.clear();
+    memoryUsage = 0;
+    gl = nullptr;
+}
+
+size_t TextureStreamer::levelBytes(Page const &page, int level) const {
+    return TextureFile::levelBytes(page.width, page.height, level) * page.files.size();
+}
+
+uint64_t TextureStreamer::lastUsedAt(Page const &page, int level) const {
+    return *std::max_element(page.lastUsed.begin(), page.lastUsed.begin() + level + 1);
+}
+
+void TextureStreamer::setLevels(GLuint texture, int baseLevel, int maxLevel) {
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, baseLevel);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, maxLevel);
+}
+
+GLuint TextureStreamer::createPage(std::vector<TextureData const *> const &layers) {
+    TextureData const &first = *layers.front();
+
+    Page page;
+    page.serial = nextSerial++;
+    page.width = first.width;
+    page.height = first.height;
+    page.levelCount = TextureFile::levelCount(page.width, page.height);
+    page.baseLevel = page.residentLevel = page.wantedLevel = first.firstLevel;
+    page.lastUsed.assign(page.levelCount, 0);
+    for (TextureData const *layer : layers) {
+        page.files.push_back(layer->fileName);
+    }
+
+    GLuint texture;
+    gl->glGenTextures(1, &texture);
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // The resident levels, which come coarsest first in the pixels of every layer
+    GLsizei layerCount = static_cast<GLsizei>(layers.size());
+    size_t offset = 0;
+    for (int level = page.levelCount - 1; level >= page.residentLevel; --level) {
+        GLsizei width = TextureFile::levelWidth(page.width, level);
+        GLsizei height = TextureFile::levelWidth(page.height, level);
+        gl->glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, width, height, layerCount, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        for (GLint layer = 0; layer < layerCount; ++layer) {
+            gl->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1,
+                                GL_RGBA, GL_UNSIGNED_BYTE, layers[layer]->pixels.constData() + offset);
+        }
+        offset += TextureFile::levelBytes(page.width, page.height, level);
+        memoryUsage += levelBytes(page, level);
+    }
+    setLevels(texture, page.baseLevel, page.levelCount - 1);
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    pages[texture] = std::move(page);
+    return texture;
+}
+
+void TextureStreamer::releasePage(GLuint texture) {
+    auto it = pages.find(texture);
+    if (it == pages.end()) return;
+
+    // A load still running is dropped once it finishes, by its serial
+    for (int level = it->second.levelCount - 1; level >= it->second.baseLevel; --level) {
+        memoryUsage -= levelBytes(it->second, level);
+    }
+    gl->glDeleteTextures(1, &texture);
+    pages.erase(it);
+}
+
+void TextureStreamer::request(Material const &material, float pixels) {
+    auto it = pages.find(material.page);
+    if (it == pages.end()) return;
+    Page &page = it->second;
+
+    // The level with about a texel per pixel, rounded to the finer one
+    float texels = static_cast<float>(std::max(page.width, page.height));
+    int level = pixels >= texels ? 0 : static_cast<int>(std::log2(texels / std::max(pixels, 1.0F)));
+    page.wantedLevel = std::min(page.wantedLevel, std::min(level, page.residentLevel));
+}
+
+void TextureStreamer::update() {
+    ++updateCount;
+
+    // Upload loads that have finished in the background, dropping those of released pages
+    int uploads = 0;
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end() && uploads < settings.maxUploadsPerFrame;) {
+        if (it->layers.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        upload(*it);
+        it = pendingLoads.erase(it);
+        ++uploads;
+    }
+
+    // The pages furthest from the level they want load first
+    std::vector<std::pair<int, GLuint>> wanting;
+    for (auto &pair : pages) {
+        Page &page = pair.second;
+        page.lastUsed[page.wantedLevel] = updateCount;
+        if (page.wantedLevel < page.baseLevel && !page.loading) {
+            wanting.push_back({page.baseLevel - page.wantedLevel, pair.first});
+        }
+    }
+    std::sort(wanting.begin(), wanting.end(), std::greater<>());
+
+    for (auto const &pair : wanting) {
+        if (static_cast<int>(pendingLoads.size()) >= settings.maxPendingLoads) break;
+
+        Page &page = pages[pair.second];
+        int level = page.baseLevel - 1;
+        if (!makeRoom(levelBytes(page, level))) continue;
+
+        // The file names are copied, so the loader thread owns everything it reads
+        page.loading = true;
+        pendingLoads.push_back({pair.second, page.serial, level, std::async(
+            std::launch::async, [files = page.files, level]() {
+                std::vector<QVector<quint8>> layers(files.size());
+                for (size_t i = 0; i < files.size(); ++i) {
+                    if (!TextureFile::readLevel(files[i], level, layers[i])) {
+                        qWarning() << "Could not read level" << level << "of" << files[i];
+                        return std::vector<QVector<quint8>>{};
+                    }
+                }
+                return layers;
+            })});
+    }
+
+    // Requests are for the frame to come
+    for (auto &pair : pages) {
+        pair.second.wantedLevel = pair.second.residentLevel;
+    }
+
+    // Loads of earlier frames may have overshot the budget
+    makeRoom(0);
+}
+
+void TextureStreamer::upload(PendingLoad &load) {
+    std::vector<QVector<quint8>> layers = load.layers.get();
+
+    auto it = pages.find(load.page);
+    if (it == pages.end() || it->second.serial != load.serial) return;
+    Page &page = it->second;
+    page.loading = false;
+    if (layers.empty() || load.level != page.baseLevel - 1) return;
+
+    GLsizei width = TextureFile::levelWidth(page.width, load.level);
+    GLsizei height = TextureFile::levelWidth(page.height, load.level);
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, load.page);
+    gl->glTexImage3D(GL_TEXTURE_2D_ARRAY, load.level, GL_RGBA8, width, height,
+                     static_cast<GLsizei>(layers.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    for (size_t layer = 0; layer < layers.size(); ++layer) {
+        gl->glTexSubImage3D(GL_TEXTURE_2D_ARRAY, load.level, 0, 0, static_cast<GLint>(layer), width, height, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, layers[layer].constData());
+    }
+
+    // Only sampled once it is complete
+    page.baseLevel = load.level;
+    setLevels(load.page, page.baseLevel, page.levelCount - 1);
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    memoryUsage += levelBytes(page, load.level);
+}
+
+bool TextureStreamer::makeRoom(size_t bytes) {
+    while (memoryUsage + bytes > settings.memoryBudget) {
+        // The finest level of the page that was used least recently at that level
+        auto victim = pages.end();
+        uint64_t oldest = updateCount;
+        for (auto it = pages.begin(); it != pages.end(); ++it) {
+            Page const &page = it->second;
+            if (page.baseLevel >= page.residentLevel) continue;
+
+            uint64_t lastUsed = lastUsedAt(page, page.baseLevel);
+            if (lastUsed < oldest) {
+                oldest = lastUsed;
+                victim = it;
+            }
+        }
+        if (victim == pages.end()) {
+            return false;
+        }
+        evictLevel(victim->first, victim->second);
+    }
+    return true;
+}
+
+void TextureStreamer::evictLevel(GLuint texture, Page &page) {
+    int level = page.baseLevel;
+
+    // Stop sampling the level before dropping its storage
+    page.baseLevel = level + 1;
+    setLevels(texture, page.baseLevel, page.levelCount - 1);
+    gl->glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    gl->glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    memoryUsage -= levelBytes(page, level);
+}
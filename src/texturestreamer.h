@@ -0,0 +1,118 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include <cstdint>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QString>
+#include <QVector>
+
+#include "material.h"
+#include "world.h"
+
+/*
+ * Keeps only the mip levels of the material pages that are actually seen.
+ *
+ * A page starts out with its levels of at most TextureFile::RESIDENT_SIZE,
+ * which stay resident. Every frame, the draws request the level their
+ * projected size on screen needs. Pages that need a finer level than they
+ * have load the next one from the texture files of their layers on a loader
+ * thread, and upload it on the GL thread, one level at a time.
+ *
+ * GL_TEXTURE_BASE_LEVEL is kept at the finest level a page has, and
+ * GL_TEXTURE_MAX_LEVEL at its coarsest, so a page is complete at any point
+ * and samples the finest level it has.
+ *
+ * When the levels exceed the memory budget, the finest level of the page
+ * used least recently at that level is evicted first. Levels in use this
+ * frame are never evicted, rather the finer level is not loaded.
+ *
+ * Only to be used from the GL thread.
+ */
+class TextureStreamer
+{
+public:
+    struct Settings {
+        // Bytes all pages may take up together
+        size_t memoryBudget = 256 * 1024 * 1024;
+        // Levels uploaded per frame, and loaded at once
+        int maxUploadsPerFrame = 2;
+        int maxPendingLoads = 4;
+    };
+
+    // gl has to stay valid until destroy()
+    void initialize(QOpenGLFunctions_3_3_Core *gl, Settings settings);
+    void destroy();
+
+    /*
+     * Creates a page from the resident levels of textures of the same size,
+     * one layer each, in order.
+     */
+    GLuint createPage(std::vector<TextureData const *> const &layers);
+    void releasePage(GLuint page);
+
+    /*
+     * Asks for the level of a material that fits a draw of it covering the
+     * given number of pixels across.
+     */
+    void request(Material const &material, float pixels);
+
+    /*
+     * Uploads finished loads, starts loads of the levels requested since the
+     * last update and evicts levels if over the budget.
+     */
+    void update();
+
+    size_t getMemoryUsage() const { return memoryUsage; }
+
+private:
+    struct Page {
+        // Tells a page apart from a later one that got the same texture name
+        uint64_t serial = 0;
+        int width = 0;
+        int height = 0;
+        int levelCount = 0;
+        // Of every layer
+        std::vector<QString> files;
+
+        // The finest level uploaded, and the finest of those that always stay
+        int baseLevel = 0;
+        int residentLevel = 0;
+        // The finest level requested since the last update
+        int wantedLevel = 0;
+        // The last update each level was the finest one requested in
+        std::vector<uint64_t> lastUsed;
+        bool loading = false;
+    };
+
+    struct PendingLoad {
+        GLuint page;
+        uint64_t serial;
+        int level;
+        std::future<std::vector<QVector<quint8>>> layers;
+    };
+
+    size_t levelBytes(Page const &page, int level) const;
+    // The last update the level, or any finer one, was requested in
+    uint64_t lastUsedAt(Page const &page, int level) const;
+    void setLevels(GLuint texture, int baseLevel, int maxLevel);
+
+    void upload(PendingLoad &load);
+    // Evicts until bytes more fit in the budget, returns false if they cannot
+    bool makeRoom(size_t bytes);
+    void evictLevel(GLuint texture, Page &page);
+
+    QOpenGLFunctions_3_3_Core *gl = nullptr;
+    Settings settings;
+
+    std::unordered_map<GLuint, Page> pages;
+    std::vector<PendingLoad> pendingLoads;
+    uint64_t updateCount = 1;
+    uint64_t nextSerial = 1;
+    size_t memoryUsage = 0;
+};
+
+#endif // TEXTURESTREAMER_H
@@ -0,0 +1,64 @@
+#include "mainview.h"
+
+#include <cmath>
+
+#include <QtMath>
+
+#include "vectormath.h"
+
+/**
+ * @brief MainView::requestTextureLevels Asks the texture streamer for the mip
+ * levels the objects of a pass need, by how large they are on screen.
+ * @param objects The objects of the pass.
+ * @param effect The world effect the pass is drawn under, at the time of the frame.
+ * @param views The views of the pass, objects outside of all of them need nothing.
+ * @param cameraOffset The translation of the camera, for the cells of the objects.
+ * @param maxPixels The most pixels an object of the pass can cover across,
+ * e.g. the size of the portal it is seen through.
+ */
+void MainView::requestTextureLevels(ObjectTable const &objects, WorldEffect const &effect,
+                                    MultiView const &views, QVector3D const &cameraOffset, float maxPixels) {
+    float focal = focalPixels();
+    auto request = [&](size_t i) {
+        RenderHandle const &rh = objects.renderHandles[i];
+        QMatrix4x4 const &modelViewTransform = objects.modelTransforms[i];
+
+        QVector3D center = rh.boundsCenter;
+        float radius = rh.boundsRadius;
+        effect.mapBounds(center, radius);
+        center = modelViewTransform.map(center);
+        radius *= VectorMath::maxScale(modelViewTransform);
+        if (!views.intersectsSphere(center, radius)) return;
+
+        // The nearest point of the bounds to the nearest eye is what shows largest
+        float distance = std::max(views.distance(center) - radius, NEAR_PLANE);
+        textureStreamer.request(rh.material, std::min(2 * radius * focal / distance, maxPixels));
+    };
+
+    if (objects.cells.isEmpty()) {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            request(i);
+        }
+    } else {
+        objects.cells.forEachVisible(cameraOffset, effect, views, request);
+    }
+}
+
+/**
+ * @brief MainView::updateTextureStreaming Lets the texture streamer upload,
+ * load and evict levels for the requests of this frame.
+ */
+void MainView::updateTextureStreaming() {
+    Profiler::CpuZone zone{profiler, "updateTextureStreaming"};
+    textureStreamer.update();
+}
+
+/**
+ * @brief MainView::focalPixels The distance to the camera at which one unit
+ * covers one pixel on screen.
+ * @return The focal length of the projection, in pixels.
+ */
+float MainView::focalPixels() const {
+    return static_cast<float>(height()) * dynamicResolution.getSceneScale() /
+           (2 * std::tan(qDegreesToRadians(FIELD_OF_VIEW / 2)));
+}
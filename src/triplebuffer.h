@@ -0,0 +1,49 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+
+/*
+ * Hands values from one writer thread to one reader thread without locks.
+ *
+ * The writer fills writeBuffer() and publishes it, the reader always gets the
+ * most recently published value. Neither side ever waits on the other: the
+ * writer owns one buffer, the reader owns one and the third is swapped between
+ * them atomically.
+ */
+template <typename T>
+class TripleBuffer
+{
+    // Set in middle when it holds a value the reader has not picked up yet
+    static constexpr int FRESH_BIT = 4;
+    static constexpr int INDEX_MASK = 3;
+
+public:
+    // Writer only: the buffer to fill before calling publish()
+    T &writeBuffer() { return buffers[backIndex]; }
+
+    // Writer only: makes the write buffer available to the reader
+    void publish() {
+        int previous = middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    // Reader only: the most recently published value
+    T const &read() {
+        if (middle.load(std::memory_order_acquire) & FRESH_BIT) {
+            int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & INDEX_MASK;
+        }
+        return buffers[frontIndex];
+    }
+
+private:
+    std::array<T, 3> buffers;
+
+    int backIndex = 0;
+    std::atomic<int> middle{1};
+    int frontIndex = 2;
+};
+
+#endif // TRIPLEBUFFER_H
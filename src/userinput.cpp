@@ -1,3 +1,4 @@
+#include <QDateTime>
 #include <QDebug>
 
 #include "mainview.h"
@@ -7,7 +8,26 @@
  * @param ev Key event.
  */
 void MainView::keyPressEvent(QKeyEvent *ev) {
-    keyboardStatus.updateStatus(ev->key(), KeyboardStatus::KEY_STATUS::DOWN);
+    switch (ev->key()) {
+    case Qt::Key_F1:
+        showProfilerOverlay = !showProfilerOverlay;
+        // Profiles without the profiler still run it for the overlay
+        if (!RenderSettings::current().profiler) {
+            profiler.setEnabled(showProfilerOverlay);
+        }
+        break;
+    case Qt::Key_F2:
+        profiler.exportChromeTrace(
+            QString("many_worlds_trace_%1.json")
+                .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+        break;
+    }
+
+    // Held keys repeat, but the action only starts once
+    if (!ev->isAutoRepeat()) {
+        simulation.updateKeyStatus(ev->key(), KeyboardStatus::KEY_STATUS::DOWN,
+                                   std::chrono::steady_clock::now());
+    }
 
     update();
 }
@@ -17,7 +37,10 @@ void MainView::keyPressEvent(QKeyEvent *ev) {
  * @param ev Key event.
  */
 void MainView::keyReleaseEvent(QKeyEvent *ev) {
-    keyboardStatus.updateStatus(ev->key(), KeyboardStatus::KEY_STATUS::UP);
+    if (!ev->isAutoRepeat()) {
+        simulation.updateKeyStatus(ev->key(), KeyboardStatus::KEY_STATUS::UP,
+                                   std::chrono::steady_clock::now());
+    }
 
     update();
 }
@@ -1,35 +1,22 @@
 #include "mainview.h"
 
 /**
- * @brief MainView::imageToBytes Converts an image to a collection of bytes so
- * that it can be used as a texture in the shader(s).
- * @param image The image to convert.
- * @return A list of bytes that represent the image.
+ * @brief MainView::checkGLErrors Reports the pending GL errors, if the render
+ * profile checks at the given granularity. Compiled out of release builds.
+ * @param where What was drawn since the previous check.
+ * @param granularity How often the check runs.
  */
-QVector<quint8> MainView::imageToBytes(const QImage& image) {
-    // needed since (0,0) is bottom left in OpenGL
-    QImage im = image.mirrored();
-    QVector<quint8> pixelData;
-    pixelData.reserve(im.width() * im.height() * 4);
-
-    for (int i = 0; i != im.height(); ++i) {
-        for (int j = 0; j != im.width(); ++j) {
-            QRgb pixel = im.pixel(j, i);
-
-            // pixel is of format #AARRGGBB (in hexadecimal notation)
-            // so with bitshifting and binary AND you can get
-            // the values of the different components
-            quint8 r = quint8((pixel >> 16) & 0xFF);  // Red component
-            quint8 g = quint8((pixel >> 8) & 0xFF);   // Green component
-            quint8 b = quint8(pixel & 0xFF);          // Blue component
-            quint8 a = quint8((pixel >> 24) & 0xFF);  // Alpha component
+void MainView::checkGLErrors(char const *where, RenderSettings::GL_ERROR_CHECKS granularity) {
+#ifdef MANY_WORLDS_GL_CHECKS
+    if (RenderSettings::current().glErrorChecks < granularity) {
+        return;
+    }
 
-            // Add them to the Vector
-            pixelData.append(r);
-            pixelData.append(g);
-            pixelData.append(b);
-            pixelData.append(a);
-        }
+    for (GLenum error = glGetError(); error != GL_NO_ERROR; error = glGetError()) {
+        qWarning() << "GL error" << qPrintable("0x" + QString::number(error, 16)) << "in" << where;
     }
-    return pixelData;
+#else
+    Q_UNUSED(where)
+    Q_UNUSED(granularity)
+#endif
 }
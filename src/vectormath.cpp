@@ -1,8 +1,51 @@
 #include "vectormath.h"
 
+#include <algorithm>
+#include <cmath>
+
 QPair<QVector3D, QVector3D> VectorMath::orthogonalVectors(QVector3D const &v) {
     QVector3D u = (std::abs(v.z()) > std::numeric_limits<float>::epsilon()) ? QVector3D(1, 0, 0) : QVector3D(0, 0, 1);
     QVector3D a = QVector3D::crossProduct(v, u).normalized();
     QVector3D b = QVector3D::crossProduct(v, a).normalized();
     return qMakePair(a, b);
 }
+
+QPair<QVector3D, float> VectorMath::boundingSphere(QVector<QVector3D> const &points) {
+    if (points.isEmpty()) {
+        return qMakePair(QVector3D{0, 0, 0}, 0.0F);
+    }
+
+    QVector3D min = points[0];
+    QVector3D max = points[0];
+    for (auto const &p : points) {
+        min = QVector3D{std::min(min.x(), p.x()), std::min(min.y(), p.y()), std::min(min.z(), p.z())};
+        max = QVector3D{std::max(max.x(), p.x()), std::max(max.y(), p.y()), std::max(max.z(), p.z())};
+    }
+
+    QVector3D center = (min + max) / 2;
+    float radius = 0;
+    for (auto const &p : points) {
+        radius = std::max(radius, (p - center).length());
+    }
+    return qMakePair(center, radius);
+}
+
+float VectorMath::maxScale(QMatrix4x4 const &transform) {
+    float x = transform.column(0).toVector3D().lengthSquared();
+    float y = transform.column(1).toVector3D().lengthSquared();
+    float z = transform.column(2).toVector3D().lengthSquared();
+    return std::sqrt(std::max({x, y, z}));
+}
+
+bool VectorMath::isSimilarity(QMatrix4x4 const &transform) {
+    QVector3D x = transform.column(0).toVector3D();
+    QVector3D y = transform.column(1).toVector3D();
+    QVector3D z = transform.column(2).toVector3D();
+
+    float scale = x.lengthSquared();
+    float tolerance = 1e-3F * scale;
+    return std::abs(y.lengthSquared() - scale) <= tolerance && std::abs(z.lengthSquared() - scale) <= tolerance &&
+           std::abs(QVector3D::dotProduct(x, y)) <= tolerance && std::abs(QVector3D::dotProduct(y, z)) <= tolerance &&
+           std::abs(QVector3D::dotProduct(z, x)) <= tolerance &&
+           QVector3D::dotProduct(QVector3D::crossProduct(x, y), z) > 0;
+}
@@ -1,13 +1,24 @@
 #ifndef VECTORMATH_H
 #define VECTORMATH_H
 
+#include <QMatrix4x4>
 #include <QVector3D>
+#include <QVector>
 
 
 class VectorMath
 {
 public:
     static QPair<QVector3D, QVector3D> orthogonalVectors(QVector3D const &v);
+
+    // A sphere (center, radius) enclosing all points, centered on their bounding box
+    static QPair<QVector3D, float> boundingSphere(QVector<QVector3D> const &points);
+
+    // Largest factor by which a transform scales lengths, bounds the radius of a transformed sphere
+    static float maxScale(QMatrix4x4 const &transform);
+
+    // Whether a transform only rotates, translates and scales uniformly, so it keeps angles and winding
+    static bool isSimilarity(QMatrix4x4 const &transform);
 };
 
 #endif // VECTORMATH_H
@@ -0,0 +1,198 @@
+#include "vertexencoding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QtMath>
+
+namespace {
+
+float signNotZero(float value) {
+    return value >= 0 ? 1.0F : -1.0F;
+}
+
+uint16_t toUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0F, 1.0F) * 65535.0F));
+}
+
+int16_t toSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0F, 1.0F) * 32767.0F));
+}
+
+// As GL converts normalized signed integers
+float fromSnorm16(int16_t value) {
+    return std::max(static_cast<float>(value) / 32767.0F, -1.0F);
+}
+
+}
+
+EncodedMesh VertexEncoding::encode(MeshData const &mesh) {
+    EncodedMesh encoded;
+
+    QVector3D min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                  std::numeric_limits<float>::max()};
+    QVector3D max = -min;
+    for (auto const &coords : mesh.coords) {
+        for (int axis = 0; axis < 3; ++axis) {
+            min[axis] = std::min(min[axis], coords[axis]);
+            max[axis] = std::max(max[axis], coords[axis]);
+        }
+    }
+    if (mesh.coords.isEmpty()) {
+        min = max = QVector3D{};
+    }
+
+    encoded.positionOffset = min;
+    encoded.positionScale = max - min;
+
+    encoded.vertices.resize(mesh.coords.size());
+    for (int i = 0; i < mesh.coords.size(); ++i) {
+        PackedVertex &vertex = encoded.vertices[i];
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float extent = encoded.positionScale[axis];
+            float relative = extent > 0 ? (mesh.coords[i][axis] - min[axis]) / extent : 0;
+            vertex.coords[axis] = toUnorm16(relative);
+        }
+        vertex.coords[3] = 0;
+
+        QVector2D normal = i < mesh.normals.size() ? encodeOctahedral(mesh.normals[i]) : QVector2D{0, 0};
+        vertex.normal[0] = toSnorm16(normal.x());
+        vertex.normal[1] = toSnorm16(normal.y());
+
+        QVector2D textureCoords = i < mesh.textureCoords.size() ? mesh.textureCoords[i] : QVector2D{0, 0};
+        vertex.textureCoords[0] = toHalf(textureCoords.x());
+        vertex.textureCoords[1] = toHalf(textureCoords.y());
+    }
+
+    return encoded;
+}
+
+EncodingError VertexEncoding::measureError(MeshData const &mesh, EncodedMesh const &encoded) {
+    EncodingError error;
+    if (encoded.vertices.empty()) return error;
+
+    double positionSum = 0;
+    double normalSum = 0;
+    for (size_t i = 0; i < encoded.vertices.size(); ++i) {
+        PackedVertex const &vertex = encoded.vertices[i];
+
+        float position = (decodeCoords(encoded, vertex) - mesh.coords[i]).length();
+        error.maxPosition = std::max(error.maxPosition, position);
+        positionSum += position;
+
+        if (static_cast<int>(i) < mesh.normals.size() && !mesh.normals[i].isNull()) {
+            float cosine = QVector3D::dotProduct(decodeNormal(vertex), mesh.normals[i].normalized());
+            float normal = qRadiansToDegrees(std::acos(std::clamp(cosine, -1.0F, 1.0F)));
+            error.maxNormal = std::max(error.maxNormal, normal);
+            normalSum += normal;
+        }
+
+        if (static_cast<int>(i) < mesh.textureCoords.size()) {
+            QVector2D difference = decodeTextureCoords(vertex) - mesh.textureCoords[i];
+            error.maxTextureCoords = std::max({
+                error.maxTextureCoords, std::abs(difference.x()), std::abs(difference.y())
+            });
+        }
+    }
+
+    error.meanPosition = static_cast<float>(positionSum / encoded.vertices.size());
+    error.meanNormal = static_cast<float>(normalSum / encoded.vertices.size());
+    return error;
+}
+
+QVector3D VertexEncoding::decodeCoords(EncodedMesh const &encoded, PackedVertex const &vertex) {
+    QVector3D coords{
+        vertex.coords[0] / 65535.0F,
+        vertex.coords[1] / 65535.0F,
+        vertex.coords[2] / 65535.0F
+    };
+    return encoded.positionOffset + encoded.positionScale * coords;
+}
+
+QVector3D VertexEncoding::decodeNormal(PackedVertex const &vertex) {
+    return decodeOctahedral({fromSnorm16(vertex.normal[0]), fromSnorm16(vertex.normal[1])});
+}
+
+QVector2D VertexEncoding::decodeTextureCoords(PackedVertex const &vertex) {
+    return {fromHalf(vertex.textureCoords[0]), fromHalf(vertex.textureCoords[1])};
+}
+
+uint16_t VertexEncoding::toHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t floatExponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (floatExponent == 0xFF) {
+        // Infinity stays infinity, NaN stays NaN
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa != 0 ? 0x200 : 0));
+    }
+
+    int exponent = static_cast<int>(floatExponent) - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7C00);
+    }
+
+    if (exponent <= 0) {
+        // Subnormal, or too small even for that
+        if (exponent < -10) return static_cast<uint16_t>(sign);
+
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1U << shift) - 1);
+        uint32_t halfway = 1U << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1FFF;
+    // A carry out of the mantissa correctly bumps the exponent
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) ++half;
+    return static_cast<uint16_t>(sign | half);
+}
+
+float VertexEncoding::fromHalf(uint16_t half) {
+    float sign = (half & 0x8000) ? -1.0F : 1.0F;
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+
+    if (exponent == 0) {
+        return sign * std::ldexp(static_cast<float>(mantissa), -24);
+    }
+    if (exponent == 31) {
+        return mantissa == 0 ? sign * std::numeric_limits<float>::infinity()
+                             : std::numeric_limits<float>::quiet_NaN();
+    }
+    return sign * std::ldexp(static_cast<float>(mantissa + 1024), exponent - 25);
+}
+
+QVector2D VertexEncoding::encodeOctahedral(QVector3D const &normal) {
+    float length = std::abs(normal.x()) + std::abs(normal.y()) + std::abs(normal.z());
+    if (length == 0) return {0, 0};
+
+    float x = normal.x() / length;
+    float y = normal.y() / length;
+    if (normal.z() < 0) {
+        // Fold the lower hemisphere over the diagonals
+        float foldedX = (1 - std::abs(y)) * signNotZero(x);
+        float foldedY = (1 - std::abs(x)) * signNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    return {x, y};
+}
+
+QVector3D VertexEncoding::decodeOctahedral(QVector2D const &encoded) {
+    QVector3D normal{encoded.x(), encoded.y(), 1 - std::abs(encoded.x()) - std::abs(encoded.y())};
+    float t = std::max(-normal.z(), 0.0F);
+    normal.setX(normal.x() + (normal.x() >= 0 ? -t : t));
+    normal.setY(normal.y() + (normal.y() >= 0 ? -t : t));
+    return normal.normalized();
+}
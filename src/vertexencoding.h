@@ -0,0 +1,76 @@
+#ifndef VERTEXENCODING_H
+#define VERTEXENCODING_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QVector2D>
+#include <QVector3D>
+
+#include "meshdata.h"
+
+/*
+ * A vertex as uploaded to the GPU: 16 bytes, instead of the 32 bytes of the
+ * float coordinates, normal and texture coordinates.
+ */
+struct PackedVertex
+{
+    // Normalized unsigned 16 bit, relative to the bounds of the mesh. The
+    // fourth component is unused, it keeps the normal 4 byte aligned.
+    uint16_t coords[4];
+    // Octahedral encoding, normalized signed 16 bit
+    int16_t normal[2];
+    // Half floats
+    uint16_t textureCoords[2];
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex should not be padded");
+
+/*
+ * A mesh in its GPU layout. The vertex shader decodes the coordinates as
+ * positionOffset + positionScale * coords.
+ */
+struct EncodedMesh
+{
+    std::vector<PackedVertex> vertices;
+    QVector3D positionOffset;
+    QVector3D positionScale;
+};
+
+/*
+ * How far the decoded mesh is off from the float one.
+ */
+struct EncodingError
+{
+    // In model units
+    float maxPosition = 0;
+    float meanPosition = 0;
+    // In degrees
+    float maxNormal = 0;
+    float meanNormal = 0;
+    float maxTextureCoords = 0;
+};
+
+/*
+ * Quantizes Model output into PackedVertex, and decodes it again exactly as
+ * the vertex shaders do, to measure the error.
+ */
+class VertexEncoding
+{
+public:
+    static EncodedMesh encode(MeshData const &mesh);
+    static EncodingError measureError(MeshData const &mesh, EncodedMesh const &encoded);
+
+    static QVector3D decodeCoords(EncodedMesh const &encoded, PackedVertex const &vertex);
+    static QVector3D decodeNormal(PackedVertex const &vertex);
+    static QVector2D decodeTextureCoords(PackedVertex const &vertex);
+
+    // Round to nearest even, overflowing to infinity
+    static uint16_t toHalf(float value);
+    static float fromHalf(uint16_t half);
+
+    static QVector2D encodeOctahedral(QVector3D const &normal);
+    static QVector3D decodeOctahedral(QVector2D const &encoded);
+};
+
+#endif // VERTEXENCODING_H
@@ -0,0 +1,100 @@
+#include "world.h"
+
+#include <QDebug>
+#include <algorithm>
+
+#include "model.h"
+#include "texturefile.h"
+#include "vectormath.h"
+
+PreparedMesh PreparedMesh::prepare(MeshData const &mesh) {
+    PreparedMesh prepared;
+    RenderHandle &rh = prepared.handle;
+    rh.size = mesh.indices.size();
+
+    auto bounds = VectorMath::boundingSphere(mesh.coords);
+    rh.boundsCenter = bounds.first;
+    rh.boundsRadius = bounds.second;
+
+    // Ordered into meshlets, so the parts of the mesh facing away or out of view can be skipped
+    MeshletMesh meshletMesh = Meshlets::build(mesh.coords, mesh.indices);
+    rh.meshlets = std::make_shared<std::vector<Meshlet> const>(std::move(meshletMesh.meshlets));
+    prepared.indices = std::move(meshletMesh.indices);
+
+    // Quantize into half the memory, and report what that costs in accuracy
+    prepared.encoded = VertexEncoding::encode(mesh);
+    rh.positionOffset = prepared.encoded.positionOffset;
+    rh.positionScale = prepared.encoded.positionScale;
+
+    EncodingError error = VertexEncoding::measureError(mesh, prepared.encoded);
+    qDebug() << ":: Encoded" << mesh.fileName << "from"
+             << mesh.coords.size() * (2 * sizeof(QVector3D) + sizeof(QVector2D)) << "to"
+             << prepared.encoded.vertices.size() * sizeof(PackedVertex) << "bytes."
+             << "Position error max" << error.maxPosition << "mean" << error.meanPosition
+             << "(extent" << prepared.encoded.positionScale.length() << "),"
+             << "normal error max" << error.maxNormal << "mean" << error.meanNormal << "degrees,"
+             << "texture coordinate error max" << error.maxTextureCoords;
+    qDebug() << ":: Split" << mesh.fileName << "into" << rh.meshlets->size() << "meshlets";
+
+    return prepared;
+}
+
+size_t WorldData::memoryUsage() const {
+    size_t bytes = 0;
+    // As uploaded, not as decoded
+    for (auto const &mesh : meshes) {
+        bytes += mesh.encoded.vertices.size() * sizeof(PackedVertex);
+        bytes += mesh.indices.size() * sizeof(unsigned);
+    }
+    // The streamed texture levels are accounted for by TextureStreamer
+    for (auto const &texture : textures) {
+        bytes += texture.pixels.size();
+    }
+    return bytes;
+}
+
+WorldData WorldData::load(int worldId, WorldDescription const &description) {
+    qDebug() << ":: Loading world" << worldId;
+
+    WorldData data;
+    data.worldId = worldId;
+
+    // Objects of one world commonly share files, so only decode each file once
+    std::vector<QString> meshFiles;
+    auto findMesh = [&data, &meshFiles](QString const &fileName) {
+        for (size_t i = 0; i < meshFiles.size(); ++i) {
+            if (meshFiles[i] == fileName) return static_cast<int>(i);
+        }
+        meshFiles.push_back(fileName);
+        Model model(fileName, Model::LAYOUT::INDEXED);
+        data.meshes.push_back(PreparedMesh::prepare({
+            fileName,
+            model.takeCoords(),
+            model.takeNormals(),
+            model.takeTextureCoords(),
+            model.takeIndices()
+        }));
+        return static_cast<int>(data.meshes.size() - 1);
+    };
+
+    std::vector<QString> textureFiles;
+    auto findTexture = [&data, &textureFiles](QString const &fileName) {
+        for (size_t i = 0; i < textureFiles.size(); ++i) {
+            if (textureFiles[i] == fileName) return static_cast<int>(i);
+        }
+        textureFiles.push_back(fileName);
+        // Only the coarse levels, the finer ones are streamed in once they are seen up close
+        data.textures.push_back(TextureFile::loadResident(fileName));
+        return static_cast<int>(data.textures.size() - 1);
+    };
+
+    for (auto const &object : description.objects) {
+        data.objects.push_back({
+            findMesh(object.modelFile),
+            findTexture(object.textureFile),
+            object.position
+        });
+    }
+
+    return data;
+}
@@ -0,0 +1,108 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <vector>
+
+#include <QImage>
+#include <QString>
+#include <QVector>
+#include <QVector3D>
+
+#include "meshdata.h"
+#include "scenestore.h"
+#include "vertexencoding.h"
+
+/*
+ * A single object placed inside a portal world, described by the files it is
+ * loaded from.
+ */
+struct WorldObjectDescription
+{
+    QString modelFile;
+    QString textureFile;
+    QVector3D position;
+};
+
+/*
+ * The (static) description of a portal world. Nothing in here is loaded until
+ * the camera approaches a portal leading to the world.
+ */
+struct WorldDescription
+{
+    std::vector<WorldObjectDescription> objects;
+};
+
+/*
+ * A mesh in the layout it is uploaded in: quantized, and with its indices
+ * ordered into meshlets. Prepared off the GL thread, so uploading it is only
+ * a matter of filling the buffers.
+ */
+struct PreparedMesh
+{
+    // Has the size, bounds, meshlets and decoding of the mesh, but no buffers yet
+    RenderHandle handle;
+    EncodedMesh encoded;
+    // In meshlet order
+    QVector<unsigned> indices;
+
+    static PreparedMesh prepare(MeshData const &mesh);
+};
+
+/*
+ * CPU-side data of the resident levels of a texture, in the RGBA byte layout
+ * expected by glTexImage3D. The finer levels are streamed in later, see
+ * TextureStreamer.
+ */
+struct TextureData
+{
+    // The texture file, see TextureFile
+    QString fileName;
+    // Of level 0
+    int width = 0;
+    int height = 0;
+    // The finest level in pixels, which holds it and every coarser level,
+    // coarsest first
+    int firstLevel = 0;
+    QVector<quint8> pixels;
+};
+
+/*
+ * Everything a world needs, decoded from disk but not yet uploaded to the GPU.
+ * Produced on a loader thread, consumed on the GL thread.
+ */
+struct WorldData
+{
+    struct Object {
+        int meshIndex;
+        int textureIndex;
+        QVector3D position;
+    };
+
+    int worldId = -1;
+    std::vector<PreparedMesh> meshes;
+    std::vector<TextureData> textures;
+    std::vector<Object> objects;
+
+    // Estimated size of the data once it lives on the GPU
+    size_t memoryUsage() const;
+
+    static WorldData load(int worldId, WorldDescription const &description);
+};
+
+/*
+ * A world that is resident on the GPU. The objects share the meshes / textures
+ * of the world, which are the ones released again when the world is evicted.
+ */
+struct World
+{
+    ObjectTable texturedObjects;
+
+    std::vector<RenderHandle> meshes;
+    // The GL_TEXTURE_2D_ARRAY pages holding the textures, see Material
+    std::vector<GLuint> materialPages;
+    std::vector<Material> materials;
+
+    size_t memoryUsage = 0;
+};
+
+#endif // WORLD_H
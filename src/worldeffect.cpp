@@ -0,0 +1,76 @@
+#include "worldeffect.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "vectormath.h"
+
+namespace {
+
+// Below this strength, a bend is too close to a straight line to divide by
+constexpr float MIN_BEND = 1e-6F;
+
+// The deformations as the vertex shaders apply them
+QVector3D twist(QVector3D const &p, float strength) {
+    float angle = strength * p.y();
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    return {p.x() * c - p.z() * s, p.y(), p.x() * s + p.z() * c};
+}
+
+QVector3D bend(QVector3D const &p, float strength) {
+    float angle = strength * p.x();
+    float radius = 1 / strength;
+    return {(radius - p.y()) * std::sin(angle), radius - (radius - p.y()) * std::cos(angle), p.z()};
+}
+
+}
+
+WorldEffect WorldEffect::at(float seconds) const {
+    WorldEffect effect = *this;
+    if (spinSpeed != 0) {
+        QMatrix4x4 spin;
+        spin.rotate(std::fmod(spinSpeed * seconds, 360.0F), spinAxis);
+        effect.transform = spin * transform;
+    }
+    if (pulseSpeed != 0) {
+        effect.strength = strength * std::cos(pulseSpeed * seconds);
+    }
+    effect.spinSpeed = 0;
+    effect.pulseSpeed = 0;
+    return effect;
+}
+
+void WorldEffect::mapBounds(QVector3D &center, float &radius) const {
+    center = transform.map(center);
+    radius *= VectorMath::maxScale(transform);
+
+    switch (deformation) {
+    case DEFORMATION::NONE:
+        break;
+    case DEFORMATION::TWIST: {
+        // Points keep their height and distance to the axis...
+        float axial = std::hypot(center.x(), center.z());
+        float aroundAxis = std::hypot(axial + radius, radius);
+        // ...and move apart by at most 1 + |strength| times that distance
+        float aroundCenter = radius * (1 + std::abs(strength) * (axial + radius));
+        if (aroundCenter < aroundAxis) {
+            center = twist(center, strength);
+            radius = aroundCenter;
+        } else {
+            center = QVector3D{0, center.y(), 0};
+            radius = aroundAxis;
+        }
+        break;
+    }
+    case DEFORMATION::BEND: {
+        if (std::abs(strength) < MIN_BEND) break;
+        // Stretches along the circle by |1 - strength * y|, and not at all across it
+        float stretch = std::max({1.0F, std::abs(1 - strength * (center.y() - radius)),
+                                  std::abs(1 - strength * (center.y() + radius))});
+        center = bend(center, strength);
+        radius *= stretch;
+        break;
+    }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef WORLDEFFECT_H
+#define WORLDEFFECT_H
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+/*
+ * How a world differs from the scene: an affine transform, which may spin
+ * over time, followed by an optional deformation, which may pulse. All of it
+ * applies to each object in its own model space.
+ *
+ * The effect is evaluated in the vertex shaders (shaders/worldeffect.glsl),
+ * from an EffectUniforms block written once per pass, so animated and
+ * non-affine worlds cost nothing extra per object on the CPU. The CPU only
+ * bounds what the effect does to a sphere, for culling.
+ */
+struct WorldEffect
+{
+    // Must match applyWorldEffect in shaders/worldeffect.glsl
+    enum class DEFORMATION {
+        NONE = 0,
+        // Rotates about the y axis, by strength radians per unit of y
+        TWIST,
+        // Wraps the x axis around a circle in the xy plane, of strength radians per unit of x
+        BEND
+    };
+
+    // Implicit, an affine transform is an effect in its own right
+    WorldEffect(QMatrix4x4 const &transform = QMatrix4x4{}) : transform{transform} {}
+
+    QMatrix4x4 transform;
+    // Rotation about spinAxis after the transform, in degrees per second
+    QVector3D spinAxis{0, 1, 0};
+    float spinSpeed = 0;
+
+    DEFORMATION deformation = DEFORMATION::NONE;
+    float strength = 0;
+    // Swings the strength between -strength and strength, in radians per
+    // second, 0 to keep it constant
+    float pulseSpeed = 0;
+
+    // The effect as it is at a time, in seconds, with the animation resolved
+    WorldEffect at(float seconds) const;
+
+    /*
+     * Turns a sphere in model space into one around the sphere under the
+     * effect. Conservative, for culling. Ignores the animation, so only to be
+     * called on the result of at().
+     */
+    void mapBounds(QVector3D &center, float &radius) const;
+};
+
+#endif // WORLDEFFECT_H
@@ -0,0 +1,120 @@
+#include "worldstreamer.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+WorldStreamer::WorldStreamer(std::vector<WorldDescription> descriptions)
+    : descriptions{std::move(descriptions)} {}
+
+WorldStreamer::WorldStreamer(std::vector<WorldDescription> descriptions, Settings settings)
+    : descriptions{std::move(descriptions)}, settings{settings} {}
+
+void WorldStreamer::update(
+    PortalTable const &portals, int pinnedWorld,
+    Uploader const &upload, Releaser const &release
+) {
+    // Distance to the closest portal leading into each world
+    std::unordered_map<int, float> distances;
+    for (size_t i = 0; i < portals.size(); ++i) {
+        int worldId = portals.effects[i].worldId;
+        float distance = portals.collisions[i].cameraDistance;
+        if (worldId < 0) continue;
+
+        auto it = distances.find(worldId);
+        if (it == distances.end() || distance < it->second) {
+            distances[worldId] = distance;
+        }
+    }
+
+    for (auto const &pair : distances) {
+        int worldId = pair.first;
+        if (pair.second < settings.loadDistance
+            && residentWorlds.find(worldId) == residentWorlds.end()
+            && pendingLoads.find(worldId) == pendingLoads.end()
+        ) {
+            startLoad(worldId);
+        }
+    }
+
+    // Upload loads that have finished in the background
+    int uploads = 0;
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end() && uploads < settings.maxUploadsPerFrame;) {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+
+        WorldData data = it->second.get();
+        World world = upload(data);
+        world.memoryUsage = data.memoryUsage();
+        memoryUsage += world.memoryUsage;
+        residentWorlds[data.worldId] = std::move(world);
+
+        it = pendingLoads.erase(it);
+        ++uploads;
+    }
+
+    evict(distances, pinnedWorld, release);
+}
+
+World *WorldStreamer::getWorld(int worldId) {
+    auto it = residentWorlds.find(worldId);
+    return it == residentWorlds.end() ? nullptr : &it->second;
+}
+
+void WorldStreamer::releaseAll(Releaser const &release) {
+    for (auto &pair : pendingLoads) {
+        pair.second.wait();
+    }
+    pendingLoads.clear();
+
+    for (auto &pair : residentWorlds) {
+        release(pair.second);
+    }
+    residentWorlds.clear();
+    memoryUsage = 0;
+}
+
+void WorldStreamer::startLoad(int worldId) {
+    if (worldId >= static_cast<int>(descriptions.size())) {
+        qDebug() << ":: No description for world" << worldId;
+        return;
+    }
+
+    // The description is copied, so the loader thread owns everything it reads
+    pendingLoads[worldId] = std::async(
+        std::launch::async, &WorldData::load, worldId, descriptions[worldId]);
+}
+
+void WorldStreamer::evict(
+    std::unordered_map<int, float> const &distances, int pinnedWorld,
+    Releaser const &release
+) {
+    while (memoryUsage > settings.memoryBudget) {
+        // Find the resident world furthest away from the camera
+        int furthestWorld = -1;
+        float furthestDistance = settings.evictDistance;
+        for (auto const &pair : residentWorlds) {
+            if (pair.first == pinnedWorld) continue;
+
+            auto it = distances.find(pair.first);
+            float distance = it == distances.end() ? std::numeric_limits<float>::max() : it->second;
+            if (distance >= furthestDistance) {
+                furthestWorld = pair.first;
+                furthestDistance = distance;
+            }
+        }
+
+        if (furthestWorld < 0) {
+            // Everything resident is close by, so stay over budget
+            return;
+        }
+
+        qDebug() << ":: Evicting world" << furthestWorld;
+        World &world = residentWorlds[furthestWorld];
+        memoryUsage -= world.memoryUsage;
+        release(world);
+        residentWorlds.erase(furthestWorld);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef WORLDSTREAMER_H
+#define WORLDSTREAMER_H
+
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+#include "scenestore.h"
+#include "world.h"
+
+/*
+ * Loads portal worlds in the background when the camera approaches one of
+ * their portals, and evicts the worlds furthest away whenever the resident
+ * worlds exceed the memory budget.
+ *
+ * Decoding of models / textures happens on a loader thread. Uploading to the
+ * GPU has to happen on the GL thread, so it is done through the uploader
+ * passed to update(), and is rate limited to avoid hitches.
+ */
+class WorldStreamer
+{
+public:
+    struct Settings {
+        // Camera distance to a portal at which its world starts loading
+        float loadDistance = 8;
+        // Worlds closer than this are never evicted
+        float evictDistance = 12;
+        // Bytes the resident worlds may take up before evicting
+        size_t memoryBudget = 64 * 1024 * 1024;
+        // Number of worlds uploaded to the GPU per frame
+        int maxUploadsPerFrame = 1;
+    };
+
+    using Uploader = std::function<World(WorldData &)>;
+    using Releaser = std::function<void(World &)>;
+
+    WorldStreamer() = default;
+    explicit WorldStreamer(std::vector<WorldDescription> descriptions);
+    WorldStreamer(std::vector<WorldDescription> descriptions, Settings settings);
+
+    /*
+     * Starts loads of worlds that came into range, uploads finished loads and
+     * evicts distant worlds if over budget. The world with id pinnedWorld
+     * (the one the camera is in) is never evicted.
+     */
+    void update(PortalTable const &portals, int pinnedWorld,
+                Uploader const &upload, Releaser const &release);
+
+    // Returns the world if it is resident, nullptr otherwise
+    World *getWorld(int worldId);
+
+    // All resident worlds, by id
+    std::unordered_map<int, World> &getResidentWorlds() { return residentWorlds; }
+
+    size_t getMemoryUsage() const { return memoryUsage; }
+
+    // Releases all resident worlds and waits for pending loads
+    void releaseAll(Releaser const &release);
+
+private:
+    void startLoad(int worldId);
+    void evict(std::unordered_map<int, float> const &distances, int pinnedWorld,
+               Releaser const &release);
+
+    std::vector<WorldDescription> descriptions;
+    Settings settings;
+
+    std::unordered_map<int, std::future<WorldData>> pendingLoads;
+    std::unordered_map<int, World> residentWorlds;
+
+    size_t memoryUsage = 0;
+};
+
+#endif // WORLDSTREAMER_H
@@ -0,0 +1,95 @@
+#include "mainview.h"
+
+/**
+ * @brief MainView::updateWorldStreaming Lets the world streamer load / evict
+ * worlds, based on the portal distances of the last collision check.
+ */
+void MainView::updateWorldStreaming() {
+    worldStreamer.update(
+        currentScene.portalObjects,
+        currentWorldId,
+        [this](WorldData &data) { return uploadWorld(data); },
+        [this](World &world) { releaseWorld(world); }
+    );
+}
+
+/**
+ * @brief MainView::uploadWorld Uploads the decoded data of a world to the GPU.
+ * @param data The decoded world.
+ * @return The resident world.
+ */
+World MainView::uploadWorld(WorldData &data) {
+    World world;
+
+    // Meshes that only one object uses are merged into the static batches of
+    // the world. The others keep their own buffers, which their objects share.
+    std::vector<int> users(data.meshes.size());
+    for (auto const &object : data.objects) {
+        ++users[object.meshIndex];
+    }
+
+    world.meshes.resize(data.meshes.size());
+    for (size_t i = 0; i < data.meshes.size(); ++i) {
+        if (users[i] != 1) {
+            loadIntoRenderHandle(data.meshes[i], world.meshes[i]);
+        }
+    }
+
+    world.materials = generateMaterials(data.textures, world.materialPages);
+
+    ObjectTable &objects = world.texturedObjects;
+    StaticBatcher batcher;
+    for (auto const &object : data.objects) {
+        EntityHandle handle = objects.add(object.position);
+
+        RenderHandle &renderHandle = objects.renderHandles[objects.handles.indexOf(handle)];
+        if (users[object.meshIndex] == 1) {
+            // Encoded on the loader thread already, see PreparedMesh
+            PreparedMesh const &mesh = data.meshes[object.meshIndex];
+            renderHandle = mesh.handle;
+            renderHandle.material = world.materials[object.textureIndex];
+            batcher.add(renderHandle, mesh.encoded, mesh.indices, object.position);
+        } else {
+            renderHandle = world.meshes[object.meshIndex];
+            renderHandle.material = world.materials[object.textureIndex];
+        }
+    }
+    uploadStaticBatches(batcher, objects);
+    updateModelTransforms(objects);
+    objects.cells.build(objects);
+
+    return world;
+}
+
+/**
+ * @brief MainView::releaseWorld Frees the GPU resources of a world.
+ * @param world The world to release.
+ */
+void MainView::releaseWorld(World &world) {
+    if (indirectDraws.isAvailable()) {
+        indirectDraws.release(world.texturedObjects);
+    }
+    for (auto &mesh : world.meshes) {
+        cleanUpRenderHandle(mesh);
+    }
+    releaseStaticBatches(world.texturedObjects);
+    for (GLuint page : world.materialPages) {
+        textureStreamer.releasePage(page);
+    }
+
+    world = World{};
+}
+
+/**
+ * @brief MainView::getWorldObjects Gets the objects to render for a world.
+ * @param worldId The world, or -1 for the objects of the scene itself.
+ * @return The objects, or nullptr if the world is not resident (yet).
+ */
+ObjectTable *MainView::getWorldObjects(int worldId) {
+    if (worldId < 0) {
+        return &currentScene.texturedObjects;
+    }
+
+    World *world = worldStreamer.getWorld(worldId);
+    return world == nullptr ? nullptr : &world->texturedObjects;
+}